@@ -0,0 +1,157 @@
+/**
+AnilloRegistros.c
+
+    Funcionalidad:
+        Anillo de registros en memoria compartida y bloqueo del fichero consolidado, comunes a FileProcessor
+        y Monitor.
+
+        Además de añadirlos al fichero consolidado, FileProcessor publica los registros consolidados, ya
+        separados en campos, en un anillo de memoria compartida POSIX (SHM_REGISTROS). Monitor los lee de ahí
+        y sólo procesa los registros nuevos, sin volver a leer el fichero consolidado.
+
+        El anillo tiene un único escritor (el hilo consolidador de FileProcessor) y cualquier número de lectores,
+        cada uno con su propia posición. Cuando está lleno se sobrescriben los registros más antiguos: el escritor
+        nunca espera. Cada ranura tiene un número de versión (seqlock): impar mientras se escribe y 2*(n+1)
+        cuando contiene el registro número n. El lector comprueba la versión antes y después de copiar el
+        registro; si no coincide, el registro se ha sobrescrito y el lector vuelve al fichero consolidado para
+        recuperar lo perdido.
+
+        Cada registro lleva su posición en el fichero consolidado (offset_inicio, offset_fin), de forma que
+        Monitor sabe exactamente hasta dónde ha procesado y detecta los huecos. FileProcessor publica los
+        registros mientras tiene el bloqueo de escritura del fichero consolidado (bloquear_fichero).
+
+    Compilación:
+        Se compila junto con FileProcessor.c y con Monitor.c (ver compilar_FileProcessor.sh y compilar_Monitor.sh)
+*/
+
+// Necesario para los bloqueos de fichero por descriptor abierto (F_OFD_SETLKW)
+#define _GNU_SOURCE
+
+#include <string.h>         // memcpy, memset
+#include <errno.h>          // EINTR
+#include <fcntl.h>          // fcntl, bloqueos OFD, shm_open
+#include <unistd.h>         // ftruncate, close
+#include <sys/mman.h>       // Memoria compartida POSIX (shm_open, mmap)
+#include <sys/stat.h>       // fstat
+
+#include "AnilloRegistros.h"    // Declaración de funciones de este módulo
+
+// Toma (F_RDLCK/F_WRLCK) o libera (F_UNLCK) un bloqueo sobre el fichero completo
+// Se utilizan bloqueos OFD (asociados al descriptor abierto y no al proceso) para que cada hilo tenga su propio bloqueo
+// Devuelve 0 si todo va bien y -1 en caso de error
+int bloquear_fichero(int fd, short tipo) {
+    struct flock bloqueo;
+    memset(&bloqueo, 0, sizeof(bloqueo));
+    bloqueo.l_type = tipo;
+    bloqueo.l_whence = SEEK_SET;
+    bloqueo.l_start = 0;
+    bloqueo.l_len = 0;      // 0 = hasta el final del fichero, aunque crezca
+    while (fcntl(fd, F_OFD_SETLKW, &bloqueo) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Crea el anillo de memoria compartida (lo usa FileProcessor)
+// Si ya existía uno (de una ejecución anterior) se marca como descartado, para que Monitor se vuelva a conectar,
+// y se crea otro objeto: los registros del anterior se refieren a un fichero consolidado que puede haber cambiado
+// Devuelve NULL si no se ha podido crear (quien lo llama sigue sin anillo: los registros sólo van al fichero consolidado)
+AnilloRegistros *crear_anillo_registros(const char *nombre_anillo, int capacidad) {
+    size_t tamano = sizeof(AnilloRegistros) + (size_t)capacidad * sizeof(RanuraAnillo);
+
+    int fd = shm_open(nombre_anillo, O_RDWR, 0);
+    if (fd != -1) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(AnilloRegistros)) {
+            AnilloRegistros *anterior = mmap(NULL, sizeof(AnilloRegistros), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (anterior != MAP_FAILED) {
+                __atomic_store_n(&anterior->magia, 0, __ATOMIC_RELEASE);
+                munmap(anterior, sizeof(AnilloRegistros));
+            }
+        }
+        close(fd);
+        shm_unlink(nombre_anillo);
+    }
+
+    fd = shm_open(nombre_anillo, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    if (ftruncate(fd, tamano) == -1) {
+        close(fd);
+        return NULL;
+    }
+    AnilloRegistros *anillo = mmap(NULL, tamano, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (anillo == MAP_FAILED) {
+        return NULL;
+    }
+
+    // ftruncate deja el objeto a ceros: versiones a 0 y ningún registro publicado
+    anillo->capacidad = capacidad;
+    anillo->escritos = 0;
+    __atomic_store_n(&anillo->magia, MAGIA_ANILLO_REGISTROS, __ATOMIC_RELEASE);
+    return anillo;
+}
+
+// Publica un registro en el anillo (sólo lo puede llamar un único escritor)
+void publicar_registro_anillo(AnilloRegistros *anillo, const RegistroTransaccion *registro) {
+    uint64_t numero = anillo->escritos;
+    RanuraAnillo *ranura = &anillo->ranuras[numero % anillo->capacidad];
+
+    // Versión impar: la ranura se está escribiendo
+    __atomic_store_n(&ranura->version, 2 * numero + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&ranura->registro, registro, sizeof(RegistroTransaccion));
+    // Versión par: la ranura contiene el registro número "numero"
+    __atomic_store_n(&ranura->version, 2 * numero + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&anillo->escritos, numero + 1, __ATOMIC_RELEASE);
+}
+
+// Proyecta en sólo lectura el anillo de memoria compartida (lo usa Monitor)
+// Devuelve NULL si no existe, si todavía no está listo o si su tamaño no corresponde al formato de este programa;
+// si lo proyecta, deja en *tamano los bytes proyectados (para munmap)
+AnilloRegistros *proyectar_anillo_registros(const char *nombre_anillo, size_t *tamano) {
+    int fd = shm_open(nombre_anillo, O_RDONLY, 0);
+    if (fd == -1) {
+        return NULL;
+    }
+    AnilloRegistros *resultado = NULL;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(AnilloRegistros)) {
+        AnilloRegistros *anillo = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (anillo != MAP_FAILED) {
+            if (anillo_registros_vigente(anillo) &&
+                sizeof(AnilloRegistros) + (size_t)anillo->capacidad * sizeof(RanuraAnillo) == (size_t)info.st_size) {
+                resultado = anillo;
+                *tamano = info.st_size;
+            } else {
+                munmap(anillo, info.st_size);
+            }
+        }
+    }
+    close(fd);
+    return resultado;
+}
+
+// Devuelve 1 si el anillo está listo y 0 si el escritor lo ha descartado (hay que volver a proyectar el nuevo)
+int anillo_registros_vigente(const AnilloRegistros *anillo) {
+    return __atomic_load_n(&anillo->magia, __ATOMIC_ACQUIRE) == MAGIA_ANILLO_REGISTROS;
+}
+
+// Copia del anillo el registro número "numero"
+// Devuelve 1 si se ha leído correctamente y 0 si ya se ha sobrescrito (o se está escribiendo)
+int leer_registro_anillo(const AnilloRegistros *anillo, uint64_t numero, RegistroTransaccion *registro) {
+    const RanuraAnillo *ranura = &anillo->ranuras[numero % anillo->capacidad];
+    uint64_t version = __atomic_load_n(&ranura->version, __ATOMIC_ACQUIRE);
+    if (version != 2 * numero + 2) {
+        return 0;
+    }
+    memcpy(registro, &ranura->registro, sizeof(RegistroTransaccion));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    // Si la versión ha cambiado mientras se copiaba, el registro copiado puede estar mezclado
+    return __atomic_load_n(&ranura->version, __ATOMIC_RELAXED) == version;
+}
@@ -0,0 +1,55 @@
+/**
+AnilloRegistros.h
+
+    Declaración del anillo de registros en memoria compartida y del bloqueo del fichero consolidado,
+    comunes a FileProcessor.c (escritor) y Monitor.c (lector)
+*/
+
+// Para evitar que se puedan llegar a declarar las funciones varias veces
+#pragma once
+
+#include <stddef.h>         // size_t
+#include <stdint.h>         // Enteros de tamaño fijo
+
+// Identificador del formato del anillo (cambiarlo si cambia la estructura de los registros)
+#define MAGIA_ANILLO_REGISTROS 0x52454733u
+
+// Registro del fichero consolidado separado en campos de tamaño fijo
+// Formato: SU001;OPE0001;12/03/2024 09:47:00;12/03/2024 10:14:00;USER144;COMPRA01;1;73 €;Finalizado
+typedef struct REGISTRO_TRANSACCION {
+    uint64_t offset_inicio;         // Posición de la línea en el fichero consolidado
+    uint64_t offset_fin;            // Posición siguiente al final de la línea (incluido el salto de línea)
+    char sucursal[8];
+    char operacion[12];
+    char fechaHora1[20];            // "dd/mm/yyyy hh:mm:ss"
+    char fechaHora2[20];
+    int64_t instante1;              // fechaHora1 en segundos desde 01/01/1970 (INSTANTE_NO_VALIDO si no es válida)
+    int64_t instante2;              // fechaHora2, igual que instante1
+    char usuario[16];
+    char tipoOperacion1[12];
+    int32_t tipoOperacion2;
+    int32_t importe;                // Importe en unidades enteras (sin el " €")
+    char estado[16];
+    int32_t codigoEstado;           // Estado decodificado (EstadoOperacion)
+} RegistroTransaccion;
+
+// Ranura del anillo: versión (seqlock) + registro
+typedef struct RANURA_ANILLO {
+    uint64_t version;
+    RegistroTransaccion registro;
+} RanuraAnillo;
+
+// Cabecera del anillo seguida de las ranuras
+typedef struct ANILLO_REGISTROS {
+    uint32_t magia;                 // MAGIA_ANILLO_REGISTROS cuando está listo, 0 si se ha descartado
+    uint32_t capacidad;             // Número de ranuras
+    uint64_t escritos;              // Número de registros publicados desde que se creó el anillo
+    RanuraAnillo ranuras[];
+} AnilloRegistros;
+
+int bloquear_fichero(int fd, short tipo);
+AnilloRegistros *crear_anillo_registros(const char *nombre_anillo, int capacidad);
+void publicar_registro_anillo(AnilloRegistros *anillo, const RegistroTransaccion *registro);
+AnilloRegistros *proyectar_anillo_registros(const char *nombre_anillo, size_t *tamano);
+int anillo_registros_vigente(const AnilloRegistros *anillo);
+int leer_registro_anillo(const AnilloRegistros *anillo, uint64_t numero, RegistroTransaccion *registro);
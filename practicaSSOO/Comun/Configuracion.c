@@ -0,0 +1,437 @@
+/**
+Configuracion.c
+
+    Funcionalidad:
+        Fichero de configuración común a FileProcessor y Monitor.
+
+        El fichero .conf se lee una vez y cada clave se convierte a su tipo (texto, entero, SI/NO, nivel de log...)
+        en un campo de la estructura Configuracion, comprobando que los números estén dentro de su rango. Un valor
+        que no es válido se avisa y se sustituye por el valor por defecto (o, al recargar, por el que había).
+        Así los hilos no buscan claves ni convierten textos: leen un campo.
+
+        La configuración vigente se publica con un puntero atómico (configuracion_actual). Al recargar (SIGHUP o
+        cambio del fichero, según cada programa) se lee una configuración completa nueva y se sustituye el puntero:
+        quien esté usando la anterior la sigue viendo entera y coherente. Las versiones anteriores no se liberan,
+        porque algún hilo puede conservar punteros a sus textos; sólo se crea una nueva cuando algo ha cambiado.
+
+        Las claves de recursos que se crean al arrancar (ficheros, pipe, anillo, carpeta de datos...) sólo se
+        aplican al reiniciar: si cambian en una recarga se avisa y se mantiene el valor anterior. El resto
+        (retardo simulado, nivel de log, pool de trabajadores, límites de los lotes, retraso permitido, punto de
+        control...) se aplican en caliente.
+
+    Compilación:
+        Se compila junto con FileProcessor.c y con Monitor.c (ver compilar_FileProcessor.sh y compilar_Monitor.sh)
+*/
+
+#include <stdio.h>          // Funciones estándar de entrada y salida
+#include <stdlib.h>         // calloc, strtoll, exit
+#include <string.h>         // Tratamiento de cadenas de caracteres
+#include <stdarg.h>         // Tratamiento de parámetros opcionales va_init...
+#include <stddef.h>         // offsetof
+#include <errno.h>          // errno
+#include <limits.h>         // PATH_MAX
+#include <unistd.h>         // read, close
+#include <pthread.h>        // Mutex de las recargas
+#include <sys/inotify.h>    // Vigilancia del fichero de configuración
+
+#include "Configuracion.h"  // Declaración de funciones de este módulo
+
+// Longitud máxima de una línea del fichero de configuración
+#define MAX_LONGITUD_LINEA 512
+
+// Tipo de valor de una clave
+typedef enum TIPO_CLAVE_CONFIGURACION {
+    TIPO_TEXTO,             // char[MAX_LONGITUD_VALOR]
+    TIPO_ENTERO,            // int, entre minimo y maximo
+    TIPO_ENTERO_LARGO,      // int64_t, entre minimo y maximo
+    TIPO_SI_NO,             // int: SI = 1, NO = 0
+    TIPO_NIVEL_LOG,         // NivelLog: GENERAL, DEBUG, INFO, WARNING, ERROR
+    TIPO_DESBORDAMIENTO_LOG,// PoliticaDesbordamientoLog: BLOCK, DROP
+    TIPO_MODELO_RETARDO     // ModeloRetardo: OFF, FIXED, UNIFORM, LOGNORMAL
+} TipoClaveConfiguracion;
+
+// Descripción de una clave del fichero de configuración
+typedef struct CLAVE_CONFIGURACION {
+    const char *clave;
+    TipoClaveConfiguracion tipo;
+    size_t posicion;                // Posición del campo en Configuracion
+    const char *valor_por_defecto;
+    long long minimo;
+    long long maximo;
+    int recargable;                 // 1 si se aplica sin reiniciar
+} ClaveConfiguracion;
+
+#define CAMPO(campo) offsetof(Configuracion, campo)
+
+// Claves admitidas (las de FileProcessor y las de Monitor: cada programa usa las suyas)
+static const ClaveConfiguracion claves_configuracion[] = {
+    {"PATH_FILES",                 TIPO_TEXTO,              CAMPO(carpeta_datos),              "../Datos",           0, 0,                    0},
+    {"INVENTORY_FILE",             TIPO_TEXTO,              CAMPO(fichero_consolidado),        "consolidado.csv",    0, 0,                    0},
+    {"PREFIJO_CARPETAS_PROCESO",   TIPO_TEXTO,              CAMPO(prefijo_carpetas_proceso),   "procesados",         0, 0,                    0},
+    {"PREFIJO_FICHEROS",           TIPO_TEXTO,              CAMPO(prefijo_ficheros),           "SU",                 0, 0,                    0},
+    {"RESULTS_FILE",               TIPO_TEXTO,              CAMPO(raiz_fichero_resultado),     "resultado_patron_",  0, 0,                    0},
+    {"CHECKPOINT_FILE",            TIPO_TEXTO,              CAMPO(fichero_punto_control),      "estado_monitor.bin", 0, 0,                    0},
+    {"ALERTS_FILE",                TIPO_TEXTO,              CAMPO(fichero_alertas),            "alertas.log",        0, 0,                    0},
+    {"LOG_FILE",                   TIPO_TEXTO,              CAMPO(fichero_log),                "file_log.log",       0, 0,                    0},
+    {"LOG_FILE_APP",               TIPO_TEXTO,              CAMPO(fichero_log_aplicacion),     "logfile_app.log",    0, 0,                    0},
+    {"LOG_LEVEL",                  TIPO_NIVEL_LOG,          CAMPO(nivel_log),                  "INFO",               0, 0,                    1},
+    {"LOG_OVERFLOW",               TIPO_DESBORDAMIENTO_LOG, CAMPO(desbordamiento_log),         "BLOCK",              0, 0,                    1},
+    {"MONITOR_ACTIVO",             TIPO_SI_NO,              CAMPO(monitor_activo),             "NO",                 0, 0,                    0},
+    {"PIPE_NAME",                  TIPO_TEXTO,              CAMPO(nombre_pipe),                "/tmp/pipeAudita",    0, 0,                    0},
+    {"SHM_REGISTROS",              TIPO_TEXTO,              CAMPO(nombre_anillo_registros),    "/registrosAudita",   0, 0,                    0},
+    {"CAPACIDAD_ANILLO_REGISTROS", TIPO_ENTERO,             CAMPO(capacidad_anillo_registros), "65536",              1, 1 << 24,              0},
+    {"NUM_PROCESOS",               TIPO_ENTERO,             CAMPO(num_procesos),               "0",                  0, 1024,                 1},
+    {"TAMANO_COLA_TRABAJO",        TIPO_ENTERO,             CAMPO(tamano_cola_trabajo),        "256",                1, 1 << 20,              1},
+    {"ORDEN_POR_SUCURSAL",         TIPO_SI_NO,              CAMPO(orden_por_sucursal),         "SI",                 0, 0,                    1},
+    {"VENTANA_CONSOLIDACION_MS",   TIPO_ENTERO,             CAMPO(ventana_consolidacion_ms),   "20",                 0, 60000,                1},
+    {"MAX_FICHEROS_CONSOLIDACION", TIPO_ENTERO,             CAMPO(max_ficheros_consolidacion), "64",                 1, 1 << 20,              1},
+    {"MAX_BYTES_CONSOLIDACION",    TIPO_ENTERO_LARGO,       CAMPO(max_bytes_consolidacion),    "16777216",           1, 1LL << 40,            1},
+    {"MODO_OBSERVACION",           TIPO_TEXTO,              CAMPO(modo_observacion),           "INOTIFY",            0, 0,                    0},
+    {"ALLOWED_LATENESS",           TIPO_ENTERO_LARGO,       CAMPO(retraso_permitido),          "86400",              0, 100LL * 366 * 86400,  1},
+    {"ALLOWED_FUTURE",             TIPO_ENTERO_LARGO,       CAMPO(adelanto_permitido),         "86400",              0, 100LL * 366 * 86400,  1},
+    {"CHECKPOINT_SECONDS",         TIPO_ENTERO,             CAMPO(segundos_punto_control),     "60",                 0, 7 * 86400,            1},
+    {"SIMULATE_MODE",              TIPO_MODELO_RETARDO,     CAMPO(modelo_retardo),             "UNIFORM",            0, 0,                    1},
+    {"SIMULATE_SLEEP_MIN",         TIPO_ENTERO,             CAMPO(retardo_minimo),             "1",                  0, 3600,                 1},
+    {"SIMULATE_SLEEP_MAX",         TIPO_ENTERO,             CAMPO(retardo_maximo),             "2",                  0, 3600,                 1},
+    {"SIMULATE_SLEEP_MS",          TIPO_ENTERO,             CAMPO(retardo_ms),                 "1000",               0, 3600000,              1},
+    {"SIMULATE_SLEEP_SIGMA",       TIPO_ENTERO,             CAMPO(dispersion_retardo),         "50",                 0, 500,                  1},
+    {"SIMULATE_SEED",              TIPO_ENTERO_LARGO,       CAMPO(semilla_retardo),            "0",                  0, INT64_MAX,            1},
+};
+
+#define NUM_CLAVES_CONFIGURACION ((int)(sizeof(claves_configuracion) / sizeof(claves_configuracion[0])))
+
+// Configuración vigente y datos para recargarla
+const Configuracion *configuracion_actual = NULL;
+static char nombre_fichero_configuracion[PATH_MAX];
+static pthread_mutex_t mutex_recarga = PTHREAD_MUTEX_INITIALIZER;
+
+// Avisa de un problema en el fichero de configuración
+// Al arrancar todavía no hay log (su configuración es la que se está leyendo): el aviso va a la salida de error
+static void avisar_configuracion(int recarga, const char *formato, ...) __attribute__((format(printf, 2, 3)));
+static void avisar_configuracion(int recarga, const char *formato, ...) {
+    char aviso[512];
+    va_list args;
+    va_start(args, formato);
+    vsnprintf(aviso, sizeof(aviso), formato, args);
+    va_end(args);
+    if (recarga) {
+        escribirEnLog(LOG_WARNING, "configuracion", "%s\n", aviso);
+    } else {
+        fprintf(stderr, "%s\n", aviso);
+    }
+}
+
+// Tamaño del campo de una clave dentro de Configuracion
+static size_t tamano_campo(TipoClaveConfiguracion tipo) {
+    switch (tipo) {
+        case TIPO_TEXTO:
+            return MAX_LONGITUD_VALOR;
+        case TIPO_ENTERO_LARGO:
+            return sizeof(int64_t);
+        case TIPO_NIVEL_LOG:
+            return sizeof(NivelLog);
+        case TIPO_DESBORDAMIENTO_LOG:
+            return sizeof(PoliticaDesbordamientoLog);
+        case TIPO_MODELO_RETARDO:
+            return sizeof(ModeloRetardo);
+        default:
+            return sizeof(int);
+    }
+}
+
+// Convierte el texto de un valor al tipo de su clave y lo guarda en la configuración
+// Devuelve 0 si el valor es válido y -1 si no (la configuración no se modifica)
+static int asignar_valor(Configuracion *configuracion, const ClaveConfiguracion *clave, const char *texto) {
+    void *campo = (char *)configuracion + clave->posicion;
+    switch (clave->tipo) {
+        case TIPO_TEXTO:
+            if (strlen(texto) >= MAX_LONGITUD_VALOR) {
+                return -1;
+            }
+            strcpy((char *)campo, texto);
+            return 0;
+
+        case TIPO_ENTERO:
+        case TIPO_ENTERO_LARGO: {
+            char *fin;
+            errno = 0;
+            long long valor = strtoll(texto, &fin, 10);
+            if (fin == texto || *fin != '\0' || errno == ERANGE || valor < clave->minimo || valor > clave->maximo) {
+                return -1;
+            }
+            if (clave->tipo == TIPO_ENTERO) {
+                *(int *)campo = (int)valor;
+            } else {
+                *(int64_t *)campo = valor;
+            }
+            return 0;
+        }
+
+        case TIPO_SI_NO:
+            if (strcmp(texto, "SI") == 0) {
+                *(int *)campo = 1;
+            } else if (strcmp(texto, "NO") == 0) {
+                *(int *)campo = 0;
+            } else {
+                return -1;
+            }
+            return 0;
+
+        case TIPO_NIVEL_LOG: {
+            static const char *niveles[] = {"GENERAL", "DEBUG", "INFO", "WARNING", "ERROR"};
+            for (int i = 0; i <= LOG_ERROR; i++) {
+                if (strcmp(texto, niveles[i]) == 0) {
+                    *(NivelLog *)campo = (NivelLog)i;
+                    return 0;
+                }
+            }
+            return -1;
+        }
+
+        case TIPO_DESBORDAMIENTO_LOG:
+            if (strcmp(texto, "BLOCK") == 0) {
+                *(PoliticaDesbordamientoLog *)campo = LOG_DESBORDAMIENTO_ESPERAR;
+            } else if (strcmp(texto, "DROP") == 0) {
+                *(PoliticaDesbordamientoLog *)campo = LOG_DESBORDAMIENTO_DESCARTAR;
+            } else {
+                return -1;
+            }
+            return 0;
+
+        case TIPO_MODELO_RETARDO: {
+            static const char *modelos[] = {"OFF", "FIXED", "UNIFORM", "LOGNORMAL"};
+            for (int i = 0; i <= RETARDO_LOGNORMAL; i++) {
+                if (strcmp(texto, modelos[i]) == 0) {
+                    *(ModeloRetardo *)campo = (ModeloRetardo)i;
+                    return 0;
+                }
+            }
+            return -1;
+        }
+    }
+    return -1;
+}
+
+// Busca la descripción de una clave (sólo al leer el fichero)
+static const ClaveConfiguracion *buscar_clave(const char *clave) {
+    for (int i = 0; i < NUM_CLAVES_CONFIGURACION; i++) {
+        if (strcmp(claves_configuracion[i].clave, clave) == 0) {
+            return &claves_configuracion[i];
+        }
+    }
+    return NULL;
+}
+
+// Quita los espacios (y el '\r' de los ficheros de Windows) del final de un texto
+static void recortar_final(char *texto) {
+    size_t longitud = strlen(texto);
+    while (longitud > 0 && (texto[longitud - 1] == ' ' || texto[longitud - 1] == '\t' ||
+                            texto[longitud - 1] == '\r' || texto[longitud - 1] == '\n')) {
+        texto[--longitud] = '\0';
+    }
+}
+
+// Lee el fichero de configuración y devuelve una configuración nueva con todas las claves ya convertidas
+// Con una configuración anterior (recarga), los valores no válidos y los de las claves no recargables
+// se toman de ella. Devuelve NULL si no se puede leer el fichero
+static Configuracion *leer_archivo_configuracion(const char *nombre_archivo, const Configuracion *anterior) {
+    int recarga = (anterior != NULL);
+
+    FILE *archivo = fopen(nombre_archivo, "r");
+    if (archivo == NULL) {
+        avisar_configuracion(recarga, "Error al abrir el archivo de configuración %s: %s", nombre_archivo, strerror(errno));
+        return NULL;
+    }
+
+    // calloc deja a cero el relleno entre campos: dos configuraciones iguales se pueden comparar con memcmp
+    Configuracion *configuracion = calloc(1, sizeof(Configuracion));
+    if (configuracion == NULL) {
+        avisar_configuracion(recarga, "Error al reservar memoria para la configuración");
+        fclose(archivo);
+        return NULL;
+    }
+
+    // Partir de los valores anteriores, al recargar, o de los valores por defecto
+    if (recarga) {
+        memcpy(configuracion, anterior, sizeof(Configuracion));
+    } else {
+        for (int i = 0; i < NUM_CLAVES_CONFIGURACION; i++) {
+            asignar_valor(configuracion, &claves_configuracion[i], claves_configuracion[i].valor_por_defecto);
+        }
+    }
+
+    char linea[MAX_LONGITUD_LINEA];
+    int numero_linea = 0;
+    unsigned char leida[NUM_CLAVES_CONFIGURACION] = {0};
+    //Vamos metiendo cada línea del fichero
+    while (fgets(linea, sizeof(linea), archivo)) {
+        numero_linea++;
+        // No leer las líneas vacías y comentarios (controlamos # para linux y ; para los archivos .ini de Windows)
+        if (linea[0] == '\n' || linea[0] == '\r' || linea[0] == '#' || linea[0] == ';')
+            continue;
+
+        // Encontrar la posición del primer '=' en la línea; el valor está justo en la primera posición detrás del igual de la clave
+        char *posicion_igual = strchr(linea, '=');
+        if (posicion_igual == NULL) {
+            continue;
+        }
+        *posicion_igual = '\0';
+        char *texto_clave = linea;
+        recortar_final(texto_clave);
+
+        // Controlamos que se pueda poner un espacio al meter el valor después del igual, y las comillas
+        char *texto_valor = posicion_igual + 1;
+        while (*texto_valor == ' ') {
+            texto_valor++;
+        }
+        recortar_final(texto_valor);
+        size_t longitud_valor = strlen(texto_valor);
+        if (longitud_valor >= 2 && texto_valor[0] == '"' && texto_valor[longitud_valor - 1] == '"') {
+            texto_valor[longitud_valor - 1] = '\0';
+            texto_valor++;
+        }
+
+        const ClaveConfiguracion *clave = buscar_clave(texto_clave);
+        if (clave == NULL) {
+            avisar_configuracion(recarga, "%s:%d: clave %s desconocida", nombre_archivo, numero_linea, texto_clave);
+            continue;
+        }
+        leida[clave - claves_configuracion] = 1;
+
+        if (recarga && !clave->recargable) {
+            // Sólo se aplica al reiniciar: se conserva el valor anterior, pero se avisa si ha cambiado
+            Configuracion prueba = *anterior;
+            if (asignar_valor(&prueba, clave, texto_valor) == 0 &&
+                memcmp((char *)&prueba + clave->posicion, (char *)anterior + clave->posicion, tamano_campo(clave->tipo)) != 0) {
+                avisar_configuracion(recarga, "%s:%d: %s no se puede cambiar sin reiniciar, se mantiene el valor anterior", nombre_archivo, numero_linea, clave->clave);
+            }
+            continue;
+        }
+
+        if (asignar_valor(configuracion, clave, texto_valor) == -1) {
+            if (clave->tipo == TIPO_ENTERO || clave->tipo == TIPO_ENTERO_LARGO) {
+                avisar_configuracion(recarga, "%s:%d: valor '%s' no válido para %s (entre %lld y %lld), se utiliza el %s",
+                                     nombre_archivo, numero_linea, texto_valor, clave->clave, clave->minimo, clave->maximo,
+                                     recarga ? "anterior" : "valor por defecto");
+            } else {
+                avisar_configuracion(recarga, "%s:%d: valor '%s' no válido para %s, se utiliza el %s",
+                                     nombre_archivo, numero_linea, texto_valor, clave->clave, recarga ? "anterior" : "valor por defecto");
+            }
+        }
+    }
+    fclose(archivo);
+
+    // Las claves recargables que se han quitado del fichero vuelven a su valor por defecto
+    if (recarga) {
+        for (int i = 0; i < NUM_CLAVES_CONFIGURACION; i++) {
+            if (!leida[i] && claves_configuracion[i].recargable) {
+                asignar_valor(configuracion, &claves_configuracion[i], claves_configuracion[i].valor_por_defecto);
+            }
+        }
+    }
+
+    // Comprobaciones entre claves
+    if (configuracion->retardo_maximo < configuracion->retardo_minimo) {
+        avisar_configuracion(recarga, "%s: SIMULATE_SLEEP_MAX (%d) menor que SIMULATE_SLEEP_MIN (%d), se utiliza %d",
+                             nombre_archivo, configuracion->retardo_maximo, configuracion->retardo_minimo, configuracion->retardo_minimo);
+        configuracion->retardo_maximo = configuracion->retardo_minimo;
+    }
+
+    configuracion->version = recarga ? anterior->version : 1;
+    return configuracion;
+}
+
+// Lee el fichero de configuración al arrancar (antes de crear ningún hilo y de escribir en el log)
+// Si no se puede leer, el programa termina
+void cargar_configuracion(const char *nombre_fichero) {
+    snprintf(nombre_fichero_configuracion, sizeof(nombre_fichero_configuracion), "%s", nombre_fichero);
+    Configuracion *configuracion = leer_archivo_configuracion(nombre_fichero_configuracion, NULL);
+    if (configuracion == NULL) {
+        exit(1);
+    }
+    __atomic_store_n(&configuracion_actual, configuracion, __ATOMIC_RELEASE);
+}
+
+// Vuelve a leer el fichero de configuración y, si algo ha cambiado, publica la nueva configuración
+// Devuelve 1 si se ha publicado una configuración nueva, 0 si no ha cambiado nada y -1 si no se ha podido leer
+int recargar_configuracion() {
+    pthread_mutex_lock(&mutex_recarga);
+    const Configuracion *anterior = obtener_configuracion();
+    Configuracion *nueva = leer_archivo_configuracion(nombre_fichero_configuracion, anterior);
+    if (nueva == NULL) {
+        pthread_mutex_unlock(&mutex_recarga);
+        return -1;
+    }
+    if (memcmp(nueva, anterior, sizeof(Configuracion)) == 0) {
+        free(nueva);
+        pthread_mutex_unlock(&mutex_recarga);
+        escribirEnLog(LOG_DEBUG, "configuracion", "Fichero %s sin cambios\n", nombre_fichero_configuracion);
+        return 0;
+    }
+
+    // Registrar qué claves cambian (antes de publicar, para comparar con la anterior)
+    for (int i = 0; i < NUM_CLAVES_CONFIGURACION; i++) {
+        const ClaveConfiguracion *clave = &claves_configuracion[i];
+        if (memcmp((char *)nueva + clave->posicion, (char *)anterior + clave->posicion, tamano_campo(clave->tipo)) != 0) {
+            escribirEnLog(LOG_INFO, "configuracion", "Clave %s modificada\n", clave->clave);
+        }
+    }
+
+    nueva->version = anterior->version + 1;
+    __atomic_store_n(&configuracion_actual, nueva, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&mutex_recarga);
+
+    actualizar_configuracion_log(nueva->nivel_log, nueva->desbordamiento_log);
+    escribirEnLog(LOG_INFO, "configuracion", "Configuración recargada de %s (versión %llu)\n", nombre_fichero_configuracion, (unsigned long long)nueva->version);
+    return 1;
+}
+
+// Prepara la vigilancia del fichero de configuración con inotify
+// Se vigila la carpeta y no el fichero: los editores suelen guardar escribiendo otro fichero y renombrándolo
+// Devuelve el descriptor (no bloqueante) o -1 si inotify no está disponible
+int vigilar_fichero_configuracion() {
+    char carpeta[PATH_MAX];
+    snprintf(carpeta, sizeof(carpeta), "%s", nombre_fichero_configuracion);
+    char *barra = strrchr(carpeta, '/');
+    if (barra == NULL) {
+        strcpy(carpeta, ".");
+    } else {
+        *barra = '\0';
+    }
+
+    int fd_vigilancia = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_vigilancia != -1 && inotify_add_watch(fd_vigilancia, carpeta, IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        close(fd_vigilancia);
+        fd_vigilancia = -1;
+    }
+    if (fd_vigilancia == -1) {
+        escribirEnLog(LOG_WARNING, "configuracion", "No se puede vigilar %s: sólo se recargará con SIGHUP\n", nombre_fichero_configuracion);
+    }
+    return fd_vigilancia;
+}
+
+// Lee los eventos pendientes de la vigilancia y devuelve 1 si alguno es del fichero de configuración
+int fichero_configuracion_modificado(int fd_vigilancia) {
+    const char *nombre = strrchr(nombre_fichero_configuracion, '/');
+    nombre = (nombre == NULL) ? nombre_fichero_configuracion : nombre + 1;
+
+    int modificado = 0;
+    char buffer[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (1) {
+        ssize_t leidos = read(fd_vigilancia, buffer, sizeof(buffer));
+        if (leidos <= 0) {
+            if (leidos == -1 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (char *puntero = buffer; puntero < buffer + leidos; ) {
+            struct inotify_event *evento = (struct inotify_event *)puntero;
+            puntero += sizeof(struct inotify_event) + evento->len;
+            if ((evento->mask & IN_Q_OVERFLOW) || (evento->len > 0 && strcmp(evento->name, nombre) == 0)) {
+                modificado = 1;
+            }
+        }
+    }
+    return modificado;
+}
@@ -0,0 +1,79 @@
+/**
+Configuracion.h
+
+    Declaración de la configuración común a FileProcessor.c y Monitor.c
+*/
+
+// Para evitar que se puedan llegar a declarar las funciones varias veces
+#pragma once
+
+#include <stdint.h>         // Enteros de tamaño fijo
+
+#include "Log.h"            // NivelLog y PoliticaDesbordamientoLog
+#include "Retardo.h"        // ModeloRetardo
+
+// Longitud máxima de los valores de texto del fichero de configuración
+#define MAX_LONGITUD_VALOR 256
+
+// Configuración ya interpretada: cada clave del fichero .conf es un campo con su tipo, validado al leerlo
+// Una vez publicada no se modifica: al recargar se publica otra completa
+typedef struct CONFIGURACION {
+    // Carpetas y ficheros
+    char carpeta_datos[MAX_LONGITUD_VALOR];             // PATH_FILES
+    char fichero_consolidado[MAX_LONGITUD_VALOR];       // INVENTORY_FILE
+    char prefijo_carpetas_proceso[MAX_LONGITUD_VALOR];  // PREFIJO_CARPETAS_PROCESO
+    char prefijo_ficheros[MAX_LONGITUD_VALOR];          // PREFIJO_FICHEROS
+    char raiz_fichero_resultado[MAX_LONGITUD_VALOR];    // RESULTS_FILE
+    char fichero_punto_control[MAX_LONGITUD_VALOR];     // CHECKPOINT_FILE
+    char fichero_alertas[MAX_LONGITUD_VALOR];           // ALERTS_FILE
+
+    // Log
+    char fichero_log[MAX_LONGITUD_VALOR];               // LOG_FILE
+    char fichero_log_aplicacion[MAX_LONGITUD_VALOR];    // LOG_FILE_APP
+    NivelLog nivel_log;                                 // LOG_LEVEL
+    PoliticaDesbordamientoLog desbordamiento_log;       // LOG_OVERFLOW
+
+    // Comunicación entre FileProcessor y Monitor
+    int monitor_activo;                                 // MONITOR_ACTIVO
+    char nombre_pipe[MAX_LONGITUD_VALOR];               // PIPE_NAME
+    char nombre_anillo_registros[MAX_LONGITUD_VALOR];   // SHM_REGISTROS
+    int capacidad_anillo_registros;                     // CAPACIDAD_ANILLO_REGISTROS
+
+    // FileProcessor
+    int num_procesos;                                   // NUM_PROCESOS
+    int tamano_cola_trabajo;                            // TAMANO_COLA_TRABAJO
+    int orden_por_sucursal;                             // ORDEN_POR_SUCURSAL
+    int ventana_consolidacion_ms;                       // VENTANA_CONSOLIDACION_MS
+    int max_ficheros_consolidacion;                     // MAX_FICHEROS_CONSOLIDACION
+    int64_t max_bytes_consolidacion;                    // MAX_BYTES_CONSOLIDACION
+    char modo_observacion[MAX_LONGITUD_VALOR];          // MODO_OBSERVACION
+
+    // Monitor
+    int64_t retraso_permitido;                          // ALLOWED_LATENESS
+    int64_t adelanto_permitido;                         // ALLOWED_FUTURE
+    int segundos_punto_control;                         // CHECKPOINT_SECONDS
+
+    // Retardo simulado
+    ModeloRetardo modelo_retardo;                       // SIMULATE_MODE
+    int retardo_minimo;                                 // SIMULATE_SLEEP_MIN (segundos)
+    int retardo_maximo;                                 // SIMULATE_SLEEP_MAX (segundos)
+    int retardo_ms;                                     // SIMULATE_SLEEP_MS
+    int dispersion_retardo;                             // SIMULATE_SLEEP_SIGMA (centésimas)
+    int64_t semilla_retardo;                            // SIMULATE_SEED
+
+    uint64_t version;                                   // 1 la primera vez y uno más en cada recarga con cambios
+} Configuracion;
+
+// Configuración vigente: se sustituye de forma atómica al recargar
+extern const Configuracion *configuracion_actual;
+
+// Devuelve la configuración vigente (un único acceso a memoria)
+// Los punteros que se obtengan siguen siendo válidos después de una recarga: las versiones anteriores no se liberan
+static inline const Configuracion *obtener_configuracion() {
+    return __atomic_load_n(&configuracion_actual, __ATOMIC_ACQUIRE);
+}
+
+void cargar_configuracion(const char *nombre_fichero);
+int recargar_configuracion();
+int vigilar_fichero_configuracion();
+int fichero_configuracion_modificado(int fd_vigilancia);
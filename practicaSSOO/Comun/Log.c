@@ -0,0 +1,445 @@
+/**
+Log.c
+
+    Funcionalidad:
+        Log asíncrono común a FileProcessor y Monitor.
+
+        Vamos a manejar dos ficheros de log:
+            El primero será un log detallado que ayudará a ver el funcionamiento de la aplicación y nos permita depurar (clave de .conf LOG_FILE_APP)
+            El segundo será el log que se pde en la práctica (clave de .conf LOG_FILE)
+
+            Para ello emplearemos una variable adicional de tipo NivelLog con los siguientes valores (clave de .conf LOG_LEVEL)
+                LOG_GENERAL: mensajes generales solicitados en el enunciado de la práctica, se escriben en ambos ficheros de log LOG_FILE_APP y LOG_FILE
+                LOG_DEBUG: mensajes muy detallados utilizados para depurar el funcionamiento de la aplicación en desarrollo, se escribe en LOG_FILE_APP
+                LOG_INFO: mensajes informativos acerca del funcionamiento de la aplicación, se escribe en LOG_FILE_APP
+                LOG_WARNING: mensajes de advertencia, se escribe en LOG_FILE_APP
+                LOG_ERROR: mensajes de error que indican que algo ha funcionado incorrectamente, se escribe en LOG_FILE_APP
+
+        escribirEnLog no escribe en los ficheros: compone la línea y la deja en un buffer circular propio del hilo
+        que llama (un único productor y un único consumidor, sin mutex). Un hilo escritor recoge las líneas de
+        todos los buffers y las escribe por lotes en los ficheros de log, que mantiene abiertos.
+
+        La configuración (nivel, ficheros y política de desbordamiento) se toma de Configuracion.c con la primera
+        llamada; el nivel y la política se vuelven a aplicar al recargarla. El nivel queda en mascara_niveles_log, que la macro escribirEnLog (Log.h) consulta antes de
+        evaluar los parámetros del mensaje. La fecha-hora de las líneas se formatea una vez por segundo en
+        cada hilo.
+
+        Las líneas de un mismo hilo se escriben en orden; las de hilos distintos pueden quedar desordenadas
+        dentro de un mismo lote (cada línea lleva su fecha-hora).
+
+        Al terminar el programa (exit) se escriben las líneas pendientes.
+
+    Compilación:
+        Se compila junto con FileProcessor.c y con Monitor.c (ver compilar_FileProcessor.sh y compilar_Monitor.sh)
+*/
+
+#include <stdio.h>          // Funciones estándar de entrada y salida
+#include <stdlib.h>         // malloc, atexit
+#include <string.h>         // Tratamiento de cadenas de caracteres
+#include <stdarg.h>         // Tratamiento de parámetros opcionales va_init...
+#include <stdint.h>         // Enteros de tamaño fijo
+#include <pthread.h>        // Hilo escritor, pthread_once y datos propios de cada hilo
+#include <time.h>           // Tratamiento de datos temporales
+#include <fcntl.h>          // open
+#include <unistd.h>         // write, close
+#include <errno.h>          // errno
+#include <signal.h>         // Máscara de señales del hilo escritor
+
+#include "Log.h"            // Declaración de funciones de este módulo
+#include "Configuracion.h"  // Nivel, ficheros y política de desbordamiento del log
+
+// Número de líneas del buffer de cada hilo (potencia de 2)
+#define CAPACIDAD_BUFFER_LOG 256
+
+// Tamaño máximo del texto del mensaje (igual que antes de que el log fuera asíncrono)
+#define TAMANO_MENSAJE_LOG 255
+
+// Tamaño máximo de una línea del log de aplicación: cabecera (fecha-hora, nivel y módulo) y mensaje
+#define TAMANO_LINEA_LOG 512
+
+// Tamaño del buffer en el que el hilo escritor junta las líneas antes de escribirlas
+#define TAMANO_LOTE_LOG (64 * 1024)
+
+// Milisegundos que espera el hilo escritor después de escribir un lote, para juntar más líneas en el siguiente
+#define MILISEGUNDOS_ESPERA_LOG 50
+
+// Línea pendiente de escribir
+typedef struct ENTRADA_LOG {
+    uint16_t longitud;              // Bytes de la línea del log de aplicación
+    uint16_t inicio_mensaje;        // Posición del mensaje dentro de la línea (para el log general)
+    uint8_t general;                // 1 si es LOG_GENERAL: también va al log general y a pantalla
+    char fecha_hora_general[23];    // "yyyy-mm-dd:::hh:mm:ss" del log general
+    char linea[TAMANO_LINEA_LOG];
+} EntradaLog;
+
+// Buffer circular de un hilo
+// escritos sólo lo modifica el hilo propietario y leidos sólo el hilo escritor (con mutex_consumidor)
+typedef struct BUFFER_LOG {
+    struct BUFFER_LOG *siguiente;   // Lista de todos los buffers (no se liberan: se reutilizan)
+    int en_uso;                     // 1 mientras un hilo lo tiene asignado
+    uint64_t descartados;           // Mensajes descartados por buffer lleno, pendientes de avisar
+    uint64_t escritos __attribute__((aligned(64)));
+    uint64_t leidos __attribute__((aligned(64)));
+    EntradaLog entradas[CAPACIDAD_BUFFER_LOG];
+} BufferLog;
+
+// Configuración y estado compartido del log
+static pthread_once_t log_iniciado = PTHREAD_ONCE_INIT;
+static int log_preparado = 0;
+unsigned int mascara_niveles_log = ~0u;
+static PoliticaDesbordamientoLog politica_desbordamiento = LOG_DESBORDAMIENTO_ESPERAR;
+static int fd_log_aplicacion = -1;
+static int fd_log_general = -1;
+static BufferLog *lista_buffers = NULL;
+static pthread_key_t clave_buffer_hilo;
+
+// mutex_consumidor sólo lo usan el hilo escritor y vaciar_log; escribirEnLog sólo toma mutex_espera para
+// despertar al hilo escritor cuando está dormido
+static pthread_mutex_t mutex_consumidor = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t mutex_espera = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t condicion_espera = PTHREAD_COND_INITIALIZER;
+
+// 1 mientras el hilo escritor espera sin límite de tiempo porque todos los buffers están vacíos
+// Se cambia con mutex_espera: quien deja una línea en un buffer vacío lo mira y, si hace falta, lo despierta
+static int escritor_dormido = 0;
+
+// Datos propios de cada hilo: su buffer y la fecha-hora formateada del último segundo
+static __thread BufferLog *buffer_hilo = NULL;
+static __thread time_t segundo_cacheado = (time_t)-1;
+static __thread char fecha_hora_cacheada[20];
+static __thread char fecha_hora_general_cacheada[23];
+
+// Niveles que hay que escribir con el nivel de log solicitado (un bit por nivel)
+// Los mensajes de nivel LOG_GENERAL siempre se escriben; con LOG_DEBUG se registran todos los mensajes,
+// con LOG_INFO los de LOG_INFO, LOG_WARNING y LOG_ERROR, y así sucesivamente
+static unsigned int mascara_desde_nivel(NivelLog nivel_log_solicitado) {
+    unsigned int mascara = 1u << LOG_GENERAL;
+    if (nivel_log_solicitado != LOG_GENERAL) {
+        for (int nivel = nivel_log_solicitado; nivel <= LOG_ERROR; nivel++) {
+            mascara |= 1u << nivel;
+        }
+    }
+    return mascara;
+}
+
+// Cadena de nivel de depuración de manera más estética
+static const char *cadena_nivel(NivelLog nivelLog) {
+    switch (nivelLog) {
+        case LOG_DEBUG:
+            return "DEBUG   ";
+        case LOG_INFO:
+            return "INFO    ";
+        case LOG_WARNING:
+            return "WARNING ";
+        case LOG_ERROR:
+            return "ERROR   ";
+        case LOG_GENERAL:
+            return "GENERAL ";
+        default:
+            return "UNKNOWN ";
+    }
+}
+
+// Escribe entero un bloque en un fichero de log
+static void escribir_fichero_log(int fd, const char *datos, size_t tamano) {
+    while (tamano > 0) {
+        ssize_t escritos = write(fd, datos, tamano);
+        if (escritos == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Error al escribir en el archivo de log\n");
+            return;
+        }
+        datos += escritos;
+        tamano -= escritos;
+    }
+}
+
+// Añade un trozo a un lote y, si no cabe, escribe antes el lote
+static void anadir_lote(int fd, char *lote, size_t *tamano_lote, const char *datos, size_t tamano) {
+    if (*tamano_lote + tamano > TAMANO_LOTE_LOG) {
+        escribir_fichero_log(fd, lote, *tamano_lote);
+        *tamano_lote = 0;
+    }
+    memcpy(lote + *tamano_lote, datos, tamano);
+    *tamano_lote += tamano;
+}
+
+// Recoge las líneas pendientes de todos los buffers y las escribe por lotes
+// Devuelve el número de líneas escritas
+static size_t vaciar_buffers() {
+    static char lote_aplicacion[TAMANO_LOTE_LOG];
+    static char lote_general[TAMANO_LOTE_LOG];
+    size_t tamano_aplicacion = 0, tamano_general = 0;
+    size_t num_lineas = 0;
+    int hay_pantalla = 0;
+
+    pthread_mutex_lock(&mutex_consumidor);
+    for (BufferLog *buffer = __atomic_load_n(&lista_buffers, __ATOMIC_ACQUIRE); buffer != NULL; buffer = buffer->siguiente) {
+        uint64_t descartados = __atomic_exchange_n(&buffer->descartados, 0, __ATOMIC_RELAXED);
+        if (descartados > 0) {
+            char fechaHora[20];
+            time_t ahora = time(NULL);
+            struct tm infoTiempo;
+            localtime_r(&ahora, &infoTiempo);
+            strftime(fechaHora, sizeof(fechaHora), "%Y-%m-%d %H:%M:%S", &infoTiempo);
+            char aviso[120];
+            int longitud = snprintf(aviso, sizeof(aviso), "%s - [WARNING ] - log: Descartados %llu mensajes por buffer lleno\n", fechaHora, (unsigned long long)descartados);
+            anadir_lote(fd_log_aplicacion, lote_aplicacion, &tamano_aplicacion, aviso, longitud);
+        }
+
+        uint64_t escritos = __atomic_load_n(&buffer->escritos, __ATOMIC_ACQUIRE);
+        uint64_t leidos = buffer->leidos;
+        for (; leidos < escritos; leidos++) {
+            EntradaLog *entrada = &buffer->entradas[leidos % CAPACIDAD_BUFFER_LOG];
+            anadir_lote(fd_log_aplicacion, lote_aplicacion, &tamano_aplicacion, entrada->linea, entrada->longitud);
+            if (entrada->general) {
+                // Formato fichero log general: FECHA:::HORA:::mensaje
+                size_t longitud_fecha = strlen(entrada->fecha_hora_general);
+                anadir_lote(fd_log_general, lote_general, &tamano_general, entrada->fecha_hora_general, longitud_fecha);
+                anadir_lote(fd_log_general, lote_general, &tamano_general, ":::", 3);
+                anadir_lote(fd_log_general, lote_general, &tamano_general, entrada->linea + entrada->inicio_mensaje, entrada->longitud - entrada->inicio_mensaje);
+                // Escribir por pantalla
+                printf("%s:::%.*s", entrada->fecha_hora_general, (int)(entrada->longitud - entrada->inicio_mensaje), entrada->linea + entrada->inicio_mensaje);
+                hay_pantalla = 1;
+            }
+            num_lineas++;
+        }
+        // La entrada ya se ha copiado: el hilo propietario puede volver a usarla
+        __atomic_store_n(&buffer->leidos, leidos, __ATOMIC_RELEASE);
+    }
+    escribir_fichero_log(fd_log_aplicacion, lote_aplicacion, tamano_aplicacion);
+    escribir_fichero_log(fd_log_general, lote_general, tamano_general);
+    if (hay_pantalla) {
+        fflush(stdout);
+    }
+    pthread_mutex_unlock(&mutex_consumidor);
+    return num_lineas;
+}
+
+// Indica si algún buffer tiene líneas sin escribir
+static int hay_lineas_pendientes() {
+    for (BufferLog *buffer = __atomic_load_n(&lista_buffers, __ATOMIC_ACQUIRE); buffer != NULL; buffer = buffer->siguiente) {
+        if (__atomic_load_n(&buffer->escritos, __ATOMIC_SEQ_CST) != __atomic_load_n(&buffer->leidos, __ATOMIC_RELAXED)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Hilo escritor: vacía los buffers de los hilos
+// Después de escribir un lote espera un momento a que lleguen más líneas; si no queda nada pendiente espera
+// sin límite de tiempo hasta que un hilo deje una línea en un buffer vacío (sin mensajes no se despierta)
+static void *hilo_escritor_log(void *arg) {
+    while (1) {
+        if (vaciar_buffers() > 0) {
+            struct timespec hasta;
+            clock_gettime(CLOCK_REALTIME, &hasta);
+            hasta.tv_nsec += MILISEGUNDOS_ESPERA_LOG * 1000000L;
+            if (hasta.tv_nsec >= 1000000000L) {
+                hasta.tv_sec++;
+                hasta.tv_nsec -= 1000000000L;
+            }
+            pthread_mutex_lock(&mutex_espera);
+            pthread_cond_timedwait(&condicion_espera, &mutex_espera, &hasta);
+            pthread_mutex_unlock(&mutex_espera);
+        } else {
+            // Se marca como dormido antes de volver a mirar los buffers: una línea que llegue después de
+            // mirarlos encuentra la marca y avisa (con el mutex, así que el aviso no se pierde)
+            pthread_mutex_lock(&mutex_espera);
+            __atomic_store_n(&escritor_dormido, 1, __ATOMIC_SEQ_CST);
+            while (!hay_lineas_pendientes()) {
+                pthread_cond_wait(&condicion_espera, &mutex_espera);
+            }
+            __atomic_store_n(&escritor_dormido, 0, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&mutex_espera);
+        }
+    }
+    return NULL;
+}
+
+// Escribe las líneas pendientes de todos los hilos (también se llama al terminar el programa)
+void vaciar_log() {
+    if (fd_log_aplicacion != -1) {
+        vaciar_buffers();
+    }
+}
+
+// Al terminar un hilo, su buffer queda libre para otro hilo (el hilo escritor termina de vaciarlo)
+static void liberar_buffer_hilo(void *buffer) {
+    __atomic_store_n(&((BufferLog *)buffer)->en_uso, 0, __ATOMIC_RELEASE);
+}
+
+// Lee la configuración del log, abre los ficheros y arranca el hilo escritor (sólo con la primera llamada)
+static void iniciar_log() {
+    const Configuracion *configuracion = obtener_configuracion();
+
+    // Los ficheros se mantienen abiertos; con O_APPEND cada escritura va al final aunque otro proceso escriba también
+    fd_log_aplicacion = open(configuracion->fichero_log_aplicacion, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_log_aplicacion == -1) {
+        fprintf(stderr, "Error al abrir el archivo de log de aplicacion\n");
+    }
+    fd_log_general = open(configuracion->fichero_log, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_log_general == -1) {
+        fprintf(stderr, "Error al abrir el archivo de log general\n");
+    }
+    if (fd_log_aplicacion == -1 || fd_log_general == -1) {
+        // Sin ficheros no se escribe nada
+        if (fd_log_aplicacion != -1) {
+            close(fd_log_aplicacion);
+        }
+        fd_log_aplicacion = -1;
+        __atomic_store_n(&mascara_niveles_log, 0u, __ATOMIC_RELAXED);
+        return;
+    }
+
+    pthread_key_create(&clave_buffer_hilo, liberar_buffer_hilo);
+    atexit(vaciar_log);
+
+    // El hilo escritor no atiende señales: se crea con todas bloqueadas para que lleguen a los hilos del programa
+    sigset_t todas, anteriores;
+    sigfillset(&todas);
+    pthread_sigmask(SIG_SETMASK, &todas, &anteriores);
+    pthread_t tid;
+    int error = pthread_create(&tid, NULL, hilo_escritor_log, NULL) != 0 || pthread_detach(tid) != 0;
+    pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+    if (error) {
+        fprintf(stderr, "Error al crear el hilo escritor del log\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // A partir de aquí la macro escribirEnLog descarta sin llamar a la función los niveles que no se escriben
+    // (se vuelve a leer la configuración por si se ha recargado mientras tanto)
+    __atomic_store_n(&log_preparado, 1, __ATOMIC_RELEASE);
+    configuracion = obtener_configuracion();
+    actualizar_configuracion_log(configuracion->nivel_log, configuracion->desbordamiento_log);
+}
+
+// Aplica el nivel y la política de desbordamiento de una configuración recargada
+// Si el log todavía no está preparado no hace nada: los tomará de la configuración al prepararse
+void actualizar_configuracion_log(NivelLog nivel_log_solicitado, PoliticaDesbordamientoLog politica) {
+    if (!__atomic_load_n(&log_preparado, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    __atomic_store_n(&politica_desbordamiento, politica, __ATOMIC_RELAXED);
+    __atomic_store_n(&mascara_niveles_log, mascara_desde_nivel(nivel_log_solicitado), __ATOMIC_RELAXED);
+}
+
+// Devuelve el buffer del hilo que llama, asignándole uno libre (o uno nuevo) la primera vez
+static BufferLog *obtener_buffer_hilo() {
+    if (buffer_hilo != NULL) {
+        return buffer_hilo;
+    }
+    // Reutilizar el buffer de un hilo que ya ha terminado, si está vacío
+    for (BufferLog *buffer = __atomic_load_n(&lista_buffers, __ATOMIC_ACQUIRE); buffer != NULL; buffer = buffer->siguiente) {
+        int libre = 0;
+        if (__atomic_load_n(&buffer->leidos, __ATOMIC_ACQUIRE) == buffer->escritos &&
+            __atomic_compare_exchange_n(&buffer->en_uso, &libre, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            buffer_hilo = buffer;
+            break;
+        }
+    }
+    if (buffer_hilo == NULL) {
+        BufferLog *buffer = calloc(1, sizeof(BufferLog));
+        if (buffer == NULL) {
+            return NULL;
+        }
+        buffer->en_uso = 1;
+        // Añadir al principio de la lista sin bloqueo
+        buffer->siguiente = __atomic_load_n(&lista_buffers, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&lista_buffers, &buffer->siguiente, buffer, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+        buffer_hilo = buffer;
+    }
+    pthread_setspecific(clave_buffer_hilo, buffer_hilo);
+    return buffer_hilo;
+}
+
+/*
+    Función de escritura en el log segura para hilos (se llama a través de la macro escribirEnLog de Log.h)
+        NivelLog es el nivel de log para ese mensaje
+        Módulo es una cadena que describe la parte del programa que ha generado el mensaje de log; ejemplo: hilo_evaluador_patrones
+        Formato es cadena de formato C que aplicaremos para formatear los parametros del mensaje
+    ... Número variable de parametro que compondrán el mensaje de log; ejemplo: numHilo, numRegistrosProcesados, etc
+
+    Ejemplo de como llamar a la función:
+        escribirEnLog(LOG_INFO, "Monitor: hilo_evaluador_patrones", "Incorporados %d registros nuevos\n", num_nuevos);
+*/
+void escribirEnLogNivel(NivelLog nivelLog, const char *modulo, const char *formato, ...) {
+    pthread_once(&log_iniciado, iniciar_log);
+
+    // La primera llamada llega con cualquier nivel: una vez leída la configuración se vuelve a comprobar
+    if (!((__atomic_load_n(&mascara_niveles_log, __ATOMIC_RELAXED) >> nivelLog) & 1u) || fd_log_aplicacion == -1) {
+        return;
+    }
+    BufferLog *buffer = obtener_buffer_hilo();
+    if (buffer == NULL) {
+        return;
+    }
+
+    // Esperar hueco en el buffer o descartar el mensaje, según la política de desbordamiento
+    uint64_t escritos = buffer->escritos;
+    while (escritos - __atomic_load_n(&buffer->leidos, __ATOMIC_ACQUIRE) >= CAPACIDAD_BUFFER_LOG) {
+        if (__atomic_load_n(&politica_desbordamiento, __ATOMIC_RELAXED) == LOG_DESBORDAMIENTO_DESCARTAR) {
+            __atomic_fetch_add(&buffer->descartados, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        pthread_cond_signal(&condicion_espera);
+        struct timespec espera = {0, 100000};
+        nanosleep(&espera, NULL);
+    }
+
+    // Fecha-hora actual: sólo se vuelve a formatear cuando cambia el segundo
+    time_t ahora = time(NULL);
+    if (ahora != segundo_cacheado) {
+        struct tm infoTiempo;
+        localtime_r(&ahora, &infoTiempo);
+        strftime(fecha_hora_cacheada, sizeof(fecha_hora_cacheada), "%Y-%m-%d %H:%M:%S", &infoTiempo);
+        strftime(fecha_hora_general_cacheada, sizeof(fecha_hora_general_cacheada), "%Y-%m-%d:::%H:%M:%S", &infoTiempo);
+        segundo_cacheado = ahora;
+    }
+
+    // Componer la línea del log de aplicación directamente en la entrada del buffer
+    EntradaLog *entrada = &buffer->entradas[escritos % CAPACIDAD_BUFFER_LOG];
+    int inicio = snprintf(entrada->linea, TAMANO_LINEA_LOG - TAMANO_MENSAJE_LOG, "%s - [%s] - %s: ", fecha_hora_cacheada, cadena_nivel(nivelLog), modulo);
+    if (inicio < 0) {
+        return;
+    }
+    if (inicio >= TAMANO_LINEA_LOG - TAMANO_MENSAJE_LOG) {
+        inicio = TAMANO_LINEA_LOG - TAMANO_MENSAJE_LOG - 1;
+    }
+    int longitud = 0;
+    if (formato != NULL) {
+        va_list args;
+        va_start(args, formato);
+        // El mensaje se trunca a TAMANO_MENSAJE_LOG - 1 caracteres, como antes
+        longitud = vsnprintf(entrada->linea + inicio, TAMANO_MENSAJE_LOG, formato, args);
+        va_end(args);
+        if (longitud < 0) {
+            longitud = 0;
+        } else if (longitud >= TAMANO_MENSAJE_LOG) {
+            longitud = TAMANO_MENSAJE_LOG - 1;
+        }
+    }
+    entrada->inicio_mensaje = (uint16_t)inicio;
+    entrada->longitud = (uint16_t)(inicio + longitud);
+    entrada->general = (nivelLog == LOG_GENERAL);
+    if (entrada->general) {
+        memcpy(entrada->fecha_hora_general, fecha_hora_general_cacheada, sizeof(entrada->fecha_hora_general));
+    }
+
+    // Publicar la entrada: el hilo escritor la verá completa
+    __atomic_store_n(&buffer->escritos, escritos + 1, __ATOMIC_SEQ_CST);
+
+    // Si el hilo escritor está dormido (todos los buffers estaban vacíos), despertarlo; si el buffer se ha
+    // llenado hasta la mitad, despertarlo sin esperar a que termine su pausa
+    uint64_t pendientes = escritos + 1 - __atomic_load_n(&buffer->leidos, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&escritor_dormido, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&mutex_espera);
+        pthread_cond_signal(&condicion_espera);
+        pthread_mutex_unlock(&mutex_espera);
+    } else if (pendientes == CAPACIDAD_BUFFER_LOG / 2) {
+        pthread_cond_signal(&condicion_espera);
+    }
+}
@@ -0,0 +1,48 @@
+/**
+Log.h
+
+    Declaración del log asíncrono común a FileProcessor.c y Monitor.c
+*/
+
+// Para evitar que se puedan llegar a declarar las funciones varias veces
+#pragma once
+
+//Damos los posibles valores a el Nivel de Depuración que queremos para los ficheros de log
+typedef enum LOG_LEVEL_TYPE {
+    LOG_GENERAL,
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARNING,
+    LOG_ERROR
+} NivelLog;
+
+// Qué hacer cuando el buffer del hilo que escribe en el log está lleno (clave de .conf LOG_OVERFLOW)
+typedef enum POLITICA_DESBORDAMIENTO_LOG {
+    LOG_DESBORDAMIENTO_ESPERAR,     // BLOCK: el hilo espera a que se vacíe el buffer (no se pierden mensajes)
+    LOG_DESBORDAMIENTO_DESCARTAR    // DROP: el mensaje se descarta y se cuenta
+} PoliticaDesbordamientoLog;
+
+void escribirEnLogNivel(NivelLog nivelLog, const char *modulo, const char *formato, ...) __attribute__((format(printf, 3, 4)));
+void vaciar_log();
+void actualizar_configuracion_log(NivelLog nivel_log_solicitado, PoliticaDesbordamientoLog politica);
+
+// Nivel mínimo de los mensajes que se compilan: con -DLOG_NIVEL_MINIMO=LOG_INFO las llamadas con LOG_DEBUG
+// desaparecen del ejecutable (los mensajes LOG_GENERAL se compilan siempre)
+#ifndef LOG_NIVEL_MINIMO
+#define LOG_NIVEL_MINIMO LOG_DEBUG
+#endif
+
+// Niveles que se escriben según LOG_LEVEL: un bit por nivel (1 << NivelLog)
+// Hasta que se lee la configuración tiene todos los bits a 1 y la primera llamada la ajusta; al recargar
+// la configuración se actualiza con actualizar_configuracion_log
+extern unsigned int mascara_niveles_log;
+
+// escribirEnLog comprueba el nivel antes de evaluar los parámetros del mensaje: si el nivel no se escribe,
+// la llamada cuesta una comparación (y nada si el nivel no se ha compilado)
+#define escribirEnLog(nivelLog, modulo, ...) \
+    do { \
+        if (((nivelLog) == LOG_GENERAL || (nivelLog) >= LOG_NIVEL_MINIMO) && \
+            __builtin_expect((__atomic_load_n(&mascara_niveles_log, __ATOMIC_RELAXED) >> (nivelLog)) & 1u, 0)) { \
+            escribirEnLogNivel((nivelLog), (modulo), __VA_ARGS__); \
+        } \
+    } while (0)
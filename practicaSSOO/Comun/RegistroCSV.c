@@ -0,0 +1,215 @@
+/**
+RegistroCSV.c
+
+    Funcionalidad:
+        Analizador de registros CSV común a FileProcessor y Monitor.
+
+        Separa una línea en campos sin copiarla ni modificarla (a diferencia de strtok), por lo que se
+        puede usar desde varios hilos a la vez y directamente sobre un fichero proyectado en memoria.
+        Los separadores (';' y salto de línea) se buscan de 32 en 32 bytes con AVX2 o de 16 en 16 con
+        SSE2, según con qué se compile, y byte a byte en el resto de casos.
+
+        Además del trozo de cada campo, decodifica los campos que usan los patrones de fraude: las dos
+        fechas-hora (a segundos desde 01/01/1970, sin strptime ni locale), el tipo de operación, el
+        importe ("73 €") y el estado.
+
+    Compilación:
+        Se compila junto con FileProcessor.c y con Monitor.c (ver compilar_FileProcessor.sh y compilar_Monitor.sh)
+*/
+
+#include <string.h>         // memcpy, memset, memcmp
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>      // Instrucciones SIMD (SSE2/AVX2)
+#endif
+
+#include "RegistroCSV.h"    // Declaración de funciones de este módulo
+
+// Copia un campo de texto en un array de tamaño fijo, truncándolo si no cabe
+void copiar_campo(char *destino, size_t tamano_destino, const char *origen, size_t longitud) {
+    if (longitud >= tamano_destino) {
+        longitud = tamano_destino - 1;
+    }
+    memcpy(destino, origen, longitud);
+    destino[longitud] = '\0';
+}
+
+// Convierte a entero el principio de un campo: admite espacios iniciales y signo, y termina en el
+// primer carácter que no sea un dígito (así "73 €" se decodifica como 73)
+int32_t decodificar_entero(const char *texto, size_t longitud) {
+    size_t i = 0;
+    while (i < longitud && texto[i] == ' ') {
+        i++;
+    }
+    int negativo = 0;
+    if (i < longitud && (texto[i] == '-' || texto[i] == '+')) {
+        negativo = (texto[i] == '-');
+        i++;
+    }
+    int64_t valor = 0;
+    while (i < longitud && texto[i] >= '0' && texto[i] <= '9') {
+        if (valor < INT32_MAX) {
+            valor = valor * 10 + (texto[i] - '0');
+        }
+        i++;
+    }
+    if (valor > INT32_MAX) {
+        valor = INT32_MAX;
+    }
+    return (int32_t)(negativo ? -valor : valor);
+}
+
+// Convierte el texto del estado de una operación a su código
+EstadoOperacion decodificar_estado(const char *texto, size_t longitud) {
+    if (longitud == 10 && memcmp(texto, "Finalizado", 10) == 0) {
+        return ESTADO_FINALIZADO;
+    }
+    if (longitud == 8 && memcmp(texto, "Correcto", 8) == 0) {
+        return ESTADO_CORRECTO;
+    }
+    if (longitud == 5 && memcmp(texto, "Error", 5) == 0) {
+        return ESTADO_ERROR;
+    }
+    return ESTADO_DESCONOCIDO;
+}
+
+// Número de días desde el 01/01/1970 de una fecha del calendario gregoriano (algoritmo days_from_civil
+// de H. Hinnant: sólo operaciones enteras, válido también para fechas anteriores a 1970)
+int64_t dias_desde_civil(int64_t anio, int mes, int dia) {
+    anio -= (mes <= 2);
+    int64_t era = (anio >= 0 ? anio : anio - 399) / 400;
+    int64_t anio_era = anio - era * 400;                                        // [0, 399]
+    int64_t dia_anio = (153 * (mes + (mes > 2 ? -3 : 9)) + 2) / 5 + dia - 1;    // [0, 365], empezando en marzo
+    int64_t dia_era = anio_era * 365 + anio_era / 4 - anio_era / 100 + dia_anio; // [0, 146096]
+    return era * 146097 + dia_era - 719468;
+}
+
+// Fecha del calendario gregoriano correspondiente a un número de días desde el 01/01/1970 (inversa de dias_desde_civil)
+void civil_desde_dias(int64_t dias, int64_t *anio, int *mes, int *dia) {
+    dias += 719468;
+    int64_t era = (dias >= 0 ? dias : dias - 146096) / 146097;
+    int64_t dia_era = dias - era * 146097;                                                  // [0, 146096]
+    int64_t anio_era = (dia_era - dia_era / 1460 + dia_era / 36524 - dia_era / 146096) / 365; // [0, 399]
+    int64_t dia_anio = dia_era - (365 * anio_era + anio_era / 4 - anio_era / 100);          // [0, 365]
+    int64_t mes_marzo = (5 * dia_anio + 2) / 153;                                           // [0, 11]
+    *dia = (int)(dia_anio - (153 * mes_marzo + 2) / 5 + 1);
+    *mes = (int)(mes_marzo < 10 ? mes_marzo + 3 : mes_marzo - 9);
+    *anio = anio_era + era * 400 + (*mes <= 2);
+}
+
+// Convierte una fecha-hora "dd/mm/yyyy hh:mm:ss" a segundos desde el 01/01/1970 00:00:00
+// La hora se toma tal cual (sin zona horaria): sólo se usa para ordenar y agrupar por segundo, hora o día
+// Devuelve INSTANTE_NO_VALIDO si el texto no tiene ese formato
+int64_t decodificar_fecha_hora(const char *texto, size_t longitud) {
+    static const char formato[] = "dd/mm/yyyy hh:mm:ss";
+    if (longitud < sizeof(formato) - 1) {
+        return INSTANTE_NO_VALIDO;
+    }
+    int valores[6] = {0};       // día, mes, año, hora, minuto, segundo
+    int campo = 0;
+    for (size_t i = 0; i < sizeof(formato) - 1; i++) {
+        if (formato[i] == '/' || formato[i] == ' ' || formato[i] == ':') {
+            if (texto[i] != formato[i]) {
+                return INSTANTE_NO_VALIDO;
+            }
+            campo++;
+        } else {
+            if (texto[i] < '0' || texto[i] > '9') {
+                return INSTANTE_NO_VALIDO;
+            }
+            valores[campo] = valores[campo] * 10 + (texto[i] - '0');
+        }
+    }
+    int dia = valores[0], mes = valores[1], anio = valores[2];
+    int hora = valores[3], minuto = valores[4], segundo = valores[5];
+    if (mes < 1 || mes > 12 || dia < 1 || dia > 31 || hora > 23 || minuto > 59 || segundo > 60) {
+        return INSTANTE_NO_VALIDO;
+    }
+    return dias_desde_civil(anio, mes, dia) * 86400 + hora * 3600 + minuto * 60 + segundo;
+}
+
+// Devuelve una máscara con un bit a 1 por cada separador (';' o salto de línea) de los "ancho" bytes
+// que empiezan en p, y deja en ancho cuántos bytes se han examinado
+static inline uint32_t buscar_separadores(const char *p, const char *fin, int *ancho) {
+#if defined(__AVX2__)
+    if (fin - p >= 32) {
+        __m256i bloque = _mm256_loadu_si256((const __m256i *)p);
+        __m256i separadores = _mm256_or_si256(_mm256_cmpeq_epi8(bloque, _mm256_set1_epi8(';')),
+                                              _mm256_cmpeq_epi8(bloque, _mm256_set1_epi8('\n')));
+        *ancho = 32;
+        return (uint32_t)_mm256_movemask_epi8(separadores);
+    }
+#endif
+#if defined(__SSE2__)
+    if (fin - p >= 16) {
+        __m128i bloque = _mm_loadu_si128((const __m128i *)p);
+        __m128i separadores = _mm_or_si128(_mm_cmpeq_epi8(bloque, _mm_set1_epi8(';')),
+                                           _mm_cmpeq_epi8(bloque, _mm_set1_epi8('\n')));
+        *ancho = 16;
+        return (uint32_t)_mm_movemask_epi8(separadores);
+    }
+#endif
+    // Sin SIMD, o final del buffer: byte a byte
+    *ancho = 1;
+    return (*p == ';' || *p == '\n') ? 1u : 0u;
+}
+
+// Guarda en la vista el campo que termina en "separador"
+static inline void cerrar_campo(VistaRegistro *vista, int *campo, const char *inicio, const char *separador) {
+    if (*campo < NUM_CAMPOS_REGISTRO) {
+        vista->campos[*campo].texto = inicio;
+        vista->campos[*campo].longitud = separador - inicio;
+    }
+    (*campo)++;
+}
+
+// Separa en campos la línea que empieza en "linea" (el buffer termina en "fin", y puede contener más líneas)
+// primer_campo indica la posición del primer campo de la línea: CAMPO_SUCURSAL para el fichero consolidado
+// y CAMPO_OPERACION para los ficheros de las sucursales, que no llevan el código de sucursal
+// Devuelve el comienzo de la línea siguiente (o fin si es la última)
+const char *parsear_registro_csv(const char *linea, const char *fin, CampoRegistroCSV primer_campo, VistaRegistro *vista) {
+    memset(vista, 0, sizeof(VistaRegistro));
+    for (int i = 0; i < NUM_CAMPOS_REGISTRO; i++) {
+        vista->campos[i].texto = linea;
+    }
+
+    int campo = primer_campo;
+    const char *inicio_campo = linea;
+    const char *p = linea;
+    const char *siguiente = fin;
+    while (p < fin && !vista->completa) {
+        int ancho;
+        uint32_t mascara = buscar_separadores(p, fin, &ancho);
+        while (mascara != 0) {
+            const char *separador = p + __builtin_ctz(mascara);
+            mascara &= mascara - 1;
+            if (*separador == '\n') {
+                // Fin de línea: el último campo no incluye el '\r' de los ficheros con fin de línea de Windows
+                const char *fin_campo = separador;
+                if (fin_campo > inicio_campo && fin_campo[-1] == '\r') {
+                    fin_campo--;
+                }
+                cerrar_campo(vista, &campo, inicio_campo, fin_campo);
+                vista->completa = 1;
+                siguiente = separador + 1;
+                break;
+            }
+            cerrar_campo(vista, &campo, inicio_campo, separador);
+            inicio_campo = separador + 1;
+        }
+        p += ancho;
+    }
+    // Línea sin salto de línea final
+    if (!vista->completa && (inicio_campo < fin || campo > (int)primer_campo)) {
+        cerrar_campo(vista, &campo, inicio_campo, fin);
+    }
+
+    vista->num_campos = ((campo < NUM_CAMPOS_REGISTRO) ? campo : NUM_CAMPOS_REGISTRO) - primer_campo;
+    vista->longitud = siguiente - linea;
+    vista->instante1 = decodificar_fecha_hora(vista->campos[CAMPO_FECHA_HORA1].texto, vista->campos[CAMPO_FECHA_HORA1].longitud);
+    vista->instante2 = decodificar_fecha_hora(vista->campos[CAMPO_FECHA_HORA2].texto, vista->campos[CAMPO_FECHA_HORA2].longitud);
+    vista->tipo_operacion = decodificar_entero(vista->campos[CAMPO_TIPO_OPERACION2].texto, vista->campos[CAMPO_TIPO_OPERACION2].longitud);
+    vista->importe = decodificar_entero(vista->campos[CAMPO_IMPORTE].texto, vista->campos[CAMPO_IMPORTE].longitud);
+    vista->estado = decodificar_estado(vista->campos[CAMPO_ESTADO].texto, vista->campos[CAMPO_ESTADO].longitud);
+    return siguiente;
+}
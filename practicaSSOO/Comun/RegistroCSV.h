@@ -0,0 +1,65 @@
+/**
+RegistroCSV.h
+
+    Declaración del analizador de registros CSV común a FileProcessor.c y Monitor.c
+*/
+
+// Para evitar que se puedan llegar a declarar las funciones varias veces
+#pragma once
+
+#include <stddef.h>         // size_t
+#include <stdint.h>         // Enteros de tamaño fijo
+
+// Posición de cada campo en un registro del fichero consolidado
+// Formato: SU001;OPE0001;12/03/2024 09:47:00;12/03/2024 10:14:00;USER144;COMPRA01;1;73 €;Finalizado
+// Los ficheros de las sucursales no llevan el código de sucursal: empiezan en CAMPO_OPERACION
+typedef enum CAMPO_REGISTRO_CSV {
+    CAMPO_SUCURSAL = 0,
+    CAMPO_OPERACION,
+    CAMPO_FECHA_HORA1,
+    CAMPO_FECHA_HORA2,
+    CAMPO_USUARIO,
+    CAMPO_TIPO_OPERACION1,
+    CAMPO_TIPO_OPERACION2,
+    CAMPO_IMPORTE,
+    CAMPO_ESTADO,
+    NUM_CAMPOS_REGISTRO
+} CampoRegistroCSV;
+
+// Estado de la operación ya decodificado
+typedef enum ESTADO_OPERACION {
+    ESTADO_DESCONOCIDO = 0,
+    ESTADO_FINALIZADO,
+    ESTADO_CORRECTO,
+    ESTADO_ERROR
+} EstadoOperacion;
+
+// Valor de los instantes decodificados cuando la fecha-hora no tiene el formato "dd/mm/yyyy hh:mm:ss"
+#define INSTANTE_NO_VALIDO INT64_MIN
+
+// Trozo de la línea que ocupa un campo (no termina en '\0': la línea no se modifica)
+typedef struct TROZO_CAMPO {
+    const char *texto;
+    size_t longitud;
+} TrozoCampo;
+
+// Vista de un registro: los campos apuntan a la línea original, sin copiarla
+typedef struct VISTA_REGISTRO {
+    TrozoCampo campos[NUM_CAMPOS_REGISTRO];
+    int num_campos;                 // Campos encontrados (contando desde el primer campo pedido)
+    int completa;                   // 1 si la línea termina en salto de línea
+    size_t longitud;                // Bytes de la línea, incluido el salto de línea
+    int64_t instante1;              // CAMPO_FECHA_HORA1 en segundos desde 01/01/1970 00:00:00 (o INSTANTE_NO_VALIDO)
+    int64_t instante2;              // CAMPO_FECHA_HORA2, igual que instante1
+    int32_t tipo_operacion;         // CAMPO_TIPO_OPERACION2 decodificado
+    int32_t importe;                // CAMPO_IMPORTE decodificado, sin el " €"
+    EstadoOperacion estado;         // CAMPO_ESTADO decodificado
+} VistaRegistro;
+
+void copiar_campo(char *destino, size_t tamano_destino, const char *origen, size_t longitud);
+const char *parsear_registro_csv(const char *linea, const char *fin, CampoRegistroCSV primer_campo, VistaRegistro *vista);
+int32_t decodificar_entero(const char *texto, size_t longitud);
+EstadoOperacion decodificar_estado(const char *texto, size_t longitud);
+int64_t dias_desde_civil(int64_t anio, int mes, int dia);
+void civil_desde_dias(int64_t dias, int64_t *anio, int *mes, int *dia);
+int64_t decodificar_fecha_hora(const char *texto, size_t longitud);
@@ -0,0 +1,104 @@
+/**
+Retardo.c
+
+    Funcionalidad:
+        Retardo simulado común a FileProcessor y Monitor.
+
+        El tiempo de servicio que se simula depende de SIMULATE_MODE (ver Retardo.h): ninguno, fijo, uniforme
+        o lognormal. Quien lo llama debe hacerlo fuera de cualquier bloqueo, para que el retardo sólo frene
+        al hilo que lo simula y las medidas muestren la contención real.
+
+        Cada hilo tiene su propio generador de números aleatorios (splitmix64), que se inicia a partir de
+        SIMULATE_SEED y del identificador del hilo: con la misma semilla cada hilo repite la misma secuencia
+        de retardos. Con SIMULATE_SEED=0 la semilla se toma del reloj. Si la semilla cambia al recargar la
+        configuración, cada hilo vuelve a iniciar su generador.
+
+    Compilación:
+        Se compila junto con FileProcessor.c y con Monitor.c (ver compilar_FileProcessor.sh y compilar_Monitor.sh)
+        Necesita la biblioteca matemática (-lm) para el modelo lognormal
+*/
+
+#include <stdint.h>         // Enteros de tamaño fijo
+#include <time.h>           // nanosleep, clock_gettime
+#include <errno.h>          // EINTR
+#include <math.h>           // log, exp, sqrt, cos (modelo lognormal)
+
+#include "Log.h"            // Log asíncrono
+#include "Configuracion.h"  // Parámetros del retardo
+#include "Retardo.h"        // Declaración de funciones de este módulo
+
+// Generador de números aleatorios de cada hilo
+static __thread uint64_t estado_aleatorio = 0;
+static __thread int64_t semilla_hilo = -1;      // SIMULATE_SEED con la que se inició (-1: sin iniciar)
+
+// Siguiente número aleatorio del hilo (splitmix64)
+static uint64_t siguiente_aleatorio() {
+    uint64_t valor = (estado_aleatorio += UINT64_C(0x9e3779b97f4a7c15));
+    valor = (valor ^ (valor >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    valor = (valor ^ (valor >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return valor ^ (valor >> 31);
+}
+
+// Número aleatorio uniforme en (0, 1]
+static double aleatorio_unidad() {
+    return ((siguiente_aleatorio() >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+// Inicia el generador del hilo si todavía no lo está o si ha cambiado la semilla configurada
+static void preparar_generador(int id_hilo, int64_t semilla) {
+    if (semilla == semilla_hilo) {
+        return;
+    }
+    semilla_hilo = semilla;
+    if (semilla != 0) {
+        estado_aleatorio = (uint64_t)semilla;
+    } else {
+        struct timespec ahora;
+        clock_gettime(CLOCK_MONOTONIC, &ahora);
+        estado_aleatorio = (uint64_t)ahora.tv_sec * UINT64_C(1000000000) + (uint64_t)ahora.tv_nsec;
+    }
+    // Secuencia distinta para cada hilo aunque compartan la semilla
+    estado_aleatorio ^= (uint64_t)id_hilo * UINT64_C(0xd1b54a32d192ed03);
+}
+
+// Duración en milisegundos del siguiente retardo del hilo según el modelo configurado
+static int64_t calcular_retardo_ms(const Configuracion *configuracion) {
+    switch (configuracion->modelo_retardo) {
+        case RETARDO_FIJO:
+            return configuracion->retardo_ms;
+
+        case RETARDO_UNIFORME: {
+            int64_t minimo = (int64_t)configuracion->retardo_minimo * 1000;
+            int64_t maximo = (int64_t)configuracion->retardo_maximo * 1000;
+            return minimo + (int64_t)(siguiente_aleatorio() % (uint64_t)(maximo - minimo + 1));
+        }
+
+        case RETARDO_LOGNORMAL: {
+            // Normal estándar con Box-Muller: la mediana del resultado es SIMULATE_SLEEP_MS
+            double normal = sqrt(-2.0 * log(aleatorio_unidad())) * cos(2.0 * M_PI * aleatorio_unidad());
+            return (int64_t)(configuracion->retardo_ms * exp(configuracion->dispersion_retardo / 100.0 * normal));
+        }
+
+        default:
+            return 0;
+    }
+}
+
+// Simula el tiempo de servicio de una operación según los parámetros del fichero de configuración
+// Con SIMULATE_MODE=OFF vuelve sin hacer nada
+void simulaRetardo(int id_hilo, const char *mensaje) {
+    const Configuracion *configuracion = obtener_configuracion();
+    if (configuracion->modelo_retardo == RETARDO_NINGUNO) {
+        return;
+    }
+
+    preparar_generador(id_hilo, configuracion->semilla_retardo);
+    int64_t retardo = calcular_retardo_ms(configuracion);
+
+    escribirEnLog(LOG_INFO, "retardo", "%s entrando en retardo simulado de %lld ms\n", mensaje, (long long)retardo);
+
+    // nanosleep puede terminar antes por una señal: se duerme lo que queda
+    struct timespec pendiente = {retardo / 1000, (retardo % 1000) * 1000000};
+    while (nanosleep(&pendiente, &pendiente) == -1 && errno == EINTR) {
+    }
+}
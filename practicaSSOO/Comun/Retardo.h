@@ -0,0 +1,18 @@
+/**
+Retardo.h
+
+    Declaración del retardo simulado común a FileProcessor.c y Monitor.c
+*/
+
+// Para evitar que se puedan llegar a declarar las funciones varias veces
+#pragma once
+
+// Modelo del tiempo de servicio que se simula (clave de .conf SIMULATE_MODE)
+typedef enum MODELO_RETARDO {
+    RETARDO_NINGUNO,        // OFF: no se simula ningún retardo (producción y medidas de rendimiento)
+    RETARDO_FIJO,           // FIXED: siempre SIMULATE_SLEEP_MS milisegundos
+    RETARDO_UNIFORME,       // UNIFORM: entre SIMULATE_SLEEP_MIN y SIMULATE_SLEEP_MAX segundos
+    RETARDO_LOGNORMAL       // LOGNORMAL: mediana SIMULATE_SLEEP_MS milisegundos y dispersión SIMULATE_SLEEP_SIGMA
+} ModeloRetardo;
+
+void simulaRetardo(int id_hilo, const char *mensaje);
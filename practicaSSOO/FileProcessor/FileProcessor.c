@@ -6,15 +6,23 @@ FileProcessor.c
         lee los ficheros CSV depositados por las sucursales bancarias en la carpeta de datos
         y consolida los resultados en el fichero de consolidación.
 
-        Crea tantos hilos como sucursales bancarias se hayan configurado.
+        Un hilo escáner detecta la llegada de ficheros nuevos mediante inotify (o recorriendo la carpeta
+        en modo POLLING) y los deja en una cola de trabajo compartida, de la que los consume un pool de
+        hilos trabajadores dimensionado según los núcleos disponibles. Un hilo consolidador añade los
+        registros preparados por los trabajadores al fichero consolidado en lotes (group commit), y los
+        publica separados en campos en un anillo de memoria compartida que lee Monitor.
 
         Se comunica con el proceso Monitor utilizando named pipe, y se sincroniza con dicho proceso
-        utilizando un semáforo común.
+        mediante bloqueos de lectura/escritura sobre el fichero consolidado.
+
+        La configuración se puede recargar sin reiniciar (SIGHUP o guardando el fichero): el tamaño del pool,
+        la cola de trabajo, los lotes de consolidación, el retardo simulado y el nivel de log se aplican en caliente.
 
         Escribe datos de la operación en los ficheros de log.
 
     Compilación:
-        gcc FileProcessor.c -o FileProcessor
+        gcc FileProcessor.c ../Comun/RegistroCSV.c ../Comun/Log.c ../Comun/Configuracion.c ../Comun/Retardo.c ../Comun/AnilloRegistros.c -o FileProcessor -pthread -lrt -lm
+        (con -DLOG_NIVEL_MINIMO=LOG_INFO no se compilan los mensajes de depuración del log)
 
     Ejecución:
         ./FileProcessor
@@ -31,6 +39,9 @@ FileProcessor.c
 // Nombre del fichero de configuración
 #define FICHERO_CONFIGURACION "FileProcessor.conf"
 
+// Necesario para IOV_MAX (escritura de varios tramos de memoria con writev)
+#define _GNU_SOURCE
+
 // ------------------------------------------------------------------
 // Librerías necesarias y explicación
 // ------------------------------------------------------------------
@@ -41,15 +52,27 @@ FileProcessor.c
 #include <pthread.h>        // Tratamiento de hilos y mutex
 #include <time.h>           // Tratamiento de datos temporales
 #include <stdarg.h>         // Tratamiento de parámetros opcionales va_init...
-#include <semaphore.h>      // Tratamiento de semáforos
 #include <unistd.h>         // Gestión de procesos, acceso a archivos, pipe, control de señales
 #include <sys/types.h>      // Definiciones de typos de datos: pid_t, size_t...
 #include <sys/stat.h>       // Definiciones y estructuras para trabajar con estados de archivos Linux
 #include <dirent.h>         // Definiciones y estructuras necesarias para trabajar con directorios en Linux
 #include <linux/limits.h>   // Define varias constantes que representan los límites del sistema en sistemas operativos Linux
 #include <fcntl.h>          // Proporciona funciones y constantes para controlar archivos y descriptores de archivo en Linux 
-#include <signal.h>         // Manejo de la señal CTRL-C
-
+#include <signal.h>         // Máscara de señales y espera de CTRL-C/SIGTERM (sigwaitinfo)
+#include <errno.h>          // Códigos de error de las llamadas al sistema (errno)
+#include <sys/inotify.h>    // Notificación de eventos del sistema de ficheros (llegada de ficheros a la carpeta de datos)
+#include <sys/mman.h>       // Proyección de ficheros en memoria (mmap)
+#include <sys/uio.h>        // Escritura de varios tramos de memoria en una sola llamada (writev)
+#include <limits.h>         // IOV_MAX
+#include <stdint.h>         // Enteros de tamaño fijo (longitud de las tramas del pipe)
+#include <poll.h>           // Espera de la recarga de la configuración (SIGHUP o cambio del fichero)
+#include <sys/signalfd.h>   // Recepción de SIGHUP como descriptor
+
+#include "../Comun/RegistroCSV.h"   // Separación en campos de los registros CSV (común con Monitor)
+#include "../Comun/Log.h"           // Log asíncrono (común con Monitor)
+#include "../Comun/Configuracion.h" // Fichero de configuración (común con Monitor)
+#include "../Comun/Retardo.h"       // Retardo simulado (común con Monitor)
+#include "../Comun/AnilloRegistros.h"   // Anillo de registros y bloqueo del fichero consolidado (común con Monitor)
 #include "FileProcessor.h"  // Declaración de funciones de este módulo
 #pragma endregion Librerias
 
@@ -58,101 +81,15 @@ FileProcessor.c
 // ------------------------------------------------------------------
 #pragma region FicheroConfiguracion
 
-// Parámetros máximos del fichero de configuración
-#define MAX_LONGITUD_LINEA 100
-#define MAX_LONGITUD_CLAVE 50
-#define MAX_LONGITUD_VALOR 50
-#define MAX_ENTRADAS_CONFIG 100
-#define MAX_LINE_LENGTH 1024
-
-// Formato de la estructura de una linea del fichero de configuración. p.ej. FicheroConsolidado (clave) = consolidado.csv(valor)
-struct EntradaConfiguracion {
-    char clave[MAX_LONGITUD_CLAVE];
-    char valor[MAX_LONGITUD_VALOR];
-};
-
-// Estructura para guardar el fichero de configuración en memoria y no tener que acceder a el muchas veces en el programa ppal.
-struct EntradaConfiguracion configuracion[MAX_ENTRADAS_CONFIG];
-int num_entradas = 0;
-// Variable que indica que el fichero de configuracion ya está leído
-int ficheroConfiguracionLeido = 0;
-
-//Función que leera el archivo de configuración y sabrá guardar los parámetros de fp.conf
-void leer_archivo_configuracion(const char *nombre_archivo) {
-    
-    // Como este fichero únicamente se lee al inicio del programa antes de crear los threads
-    // no es necesario hacerlo thread safe
-    
-    FILE *archivo = fopen(nombre_archivo, "r");
-    if (archivo == NULL) {
-        //perror muestra un mensaje de error en caso de error al abrir el fichero
-        perror("Error al abrir el archivo de configuración");
-        exit(1);
-    }
-
-    char linea[MAX_LONGITUD_LINEA];
-    //Vamos metiendo cada línea del fichero
-    while (fgets(linea, sizeof(linea), archivo)) {
-        // No leer las líneas vacías y comentarios (controlamos # para linux y ; para los archivos .ini de Windows)
-        if (linea[0] == '\n' || linea[0] == '#' || linea[0] == ';')
-            continue;
-
-        char clave[MAX_LONGITUD_CLAVE];
-        char valor[MAX_LONGITUD_VALOR];
-
-        // Encontrar la posición del primer '=' en la línea; el valor está justo en la primera posición detrás del igual de la clave
-        char *posicion_igual = strchr(linea, '=');
-        if (posicion_igual == NULL) {
-            continue;
-        }
-
-        // Copiar la clave
-        //Con la operación de posicion_igual (posicion del símbolo =) - linea (0 siempre)
-        strncpy(clave, linea, posicion_igual - linea);
-        clave[posicion_igual - linea] = '\0'; // Terminar la clave
-
-        // Leer el valor
-        char *posicion_valor = posicion_igual + 1;
-        //Controlamos que se pueda poner un espacio al meter el valor después del igual
-        if (*posicion_valor == ' ') {
-            posicion_valor++;
-        }
-        //Leo el valor
-        sscanf(posicion_valor, "%[^\n]", valor);
-        //Añadp clave y valor en la estructura
-        if (num_entradas < MAX_ENTRADAS_CONFIG) {
-            strcpy(configuracion[num_entradas].clave, clave);
-            strcpy(configuracion[num_entradas].valor, valor);
-            num_entradas++;
-        } else {
-            printf("Se alcanzó el máximo de entradas\n");
-            break;
-        }
-
-    }
+/*
+    El fichero de configuración es común a FileProcessor y Monitor: ver ../Comun/Configuracion.c
+        Se lee al arrancar y cada clave queda convertida a su tipo en un campo de Configuracion (obtener_configuracion)
+        hilo_configuracion lo vuelve a leer con SIGHUP o cuando se guarda, y aplica los cambios (aplicar_configuracion)
+*/
 
-    // Con esto ya hemos leido el fichero de configuración
-    ficheroConfiguracionLeido = 1;
-    //Cerramos archivo 
-    fclose(archivo);
-}
+// Longitud máxima de los mensajes que se envían a Monitor
+#define MAX_LINE_LENGTH 1024
 
-//Funcion para acceder a los valores de el archivo .conf por Clave y poder usarlos en el resto del programa fácilmente
-// Devuelve el valor de la clave del fichero de configuración 
-// o un valor por defecto
-const char *obtener_valor_configuracion(const char *clave, const char *valor_por_defecto) {
-    // Si no hemos leído todavía el fichero de configuración, leerlo.  La primera vez, siempre se leerá
-    if (ficheroConfiguracionLeido == 0) {
-        leer_archivo_configuracion(FICHERO_CONFIGURACION);
-    }
-    for (int i = 0; i < num_entradas; i++) {
-        if (strcmp(configuracion[i].clave, clave) == 0) {
-            return configuracion[i].valor;
-        }
-    }
-    //Si no he encontrado la clave en el .conf devulevo el valor por defecto
-    return valor_por_defecto;
-}
 #pragma endregion FicheroConfiguracion
 
 
@@ -161,191 +98,13 @@ const char *obtener_valor_configuracion(const char *clave, const char *valor_por
 // ------------------------------------------------------------------
 #pragma region FicherosLog
 /*
-    Vamos a manejar dos ficheros de log:
-        El primero será un log detallado que ayudará a ver el funcionamiento de la aplicación y nos permita depurar (clave de .conf LOG_FILE_APP)
-        El segundo será el log que se pde en la práctica (clave de .conf LOG_FILE)
-
-        Para ello emplearemos una variable adicional de tipo NivelLog con los siguientes valores (clave de .conf LOG_LEVEL)
-            LOG_GENERAL: mensajes generales solicitados en el enunciado de la práctica, se escriben en ambos ficheros de log LOG_FILE_APP y LOG_FILE
-            LOG_DEBUG: mensajes muy detallados utilizados para depurar el funcionamiento de la aplicación en desarrollo, se escribe en LOG_FILE_APP
-            LOG_INFO: mensajes informativos acerca del funcionamiento de la aplicación, se escribe en LOG_FILE_APP
-            LOG_WARNING: mensajes de advertencia (de momento no los he utilizado), se escribe en LOG_FILE_APP
-            LOG_ERROR: mensajes de error que indican que algo ha funcionado incorrectamente, se escribe en LOG_FILE_APP
+    El log es asíncrono y es común a FileProcessor y Monitor: ver ../Comun/Log.c
+        escribirEnLog deja la línea en un buffer del hilo que llama y un hilo escritor la escribe en los ficheros
+        LOG_FILE_APP y LOG_FILE (los mensajes LOG_GENERAL también se muestran por pantalla)
+        Niveles (LOG_LEVEL): GENERAL, DEBUG, INFO, WARNING, ERROR
+        Si el buffer de un hilo se llena, LOG_OVERFLOW indica si se espera (BLOCK) o se descarta el mensaje (DROP)
 */
 
-//Mutex para seguridad de los hilos, garantiza que dos hilos no podrán escribir a la vez en el fichero de log
-pthread_mutex_t mutex_escritura_log = PTHREAD_MUTEX_INITIALIZER;
-
-#define ARCHIVO_LOG "file_log.log"
-#define ARCHIVO_LOG_APP "logfile_app.log"
-
-//Damos los posibles valores a el Nivel de Depuración que queremos para los ficheros de log
-typedef enum LOG_LEVEL_TYPE {
-    LOG_GENERAL,
-    LOG_DEBUG,
-    LOG_INFO,
-    LOG_WARNING,
-    LOG_ERROR
-} NivelLog;
-
-
-/*
-    Función de escritura en fichero de log segura para hilos
-        NivelLog es el nivel de log para ese mensaje
-        Módulo es una cadena que describe la parte del programa que ha generado el mensaje de log; ejemplo: hilopatronfraude
-        Formato es cadena de formato C que aplicaremos para formatear los parametros del mensaje
-    ... Número variable de parametro que compondrán el mensaje de log; ejemplo: numHilo, numRegistrosProcesados, etc
-    
-    Ejemplo de como llamar a la función: 
-        escribirEnLog(LOG_INFO, "hilo_patron_fraude_2", "Hilo %02d: Registro que cumple el patrón Clave: %s, Registros a la vez: %d\n", id_hilo, registro->clave, registro->cantidad);
-*/
-void escribirEnLog(NivelLog nivelLog, const char *modulo, const char *formato, ...) {
-
-    // Primero comparar el nivel de log del mensaje con el nivel de log solicitado 
-    // en el fichero de configuración para escribir en el log únicamente si es necesario
-
-    // Obtener el nivel de log solicitado en el fichero de configuración
-    const char *log_level_configuracion;
-    log_level_configuracion = obtener_valor_configuracion("LOG_LEVEL", "LOG_INFO");
-    // Calculo el nivel_log_solicitado (según typedef) a partir de la cadena log_level_configuracion
-    NivelLog nivel_log_solicitado;
-    if (strcmp(log_level_configuracion, "DEBUG") == 0) {
-        nivel_log_solicitado = LOG_DEBUG;
-    } else if (strcmp(log_level_configuracion, "GENERAL") == 0) {
-        nivel_log_solicitado = LOG_GENERAL;
-    } else if (strcmp(log_level_configuracion, "INFO") == 0) {
-        nivel_log_solicitado = LOG_INFO;
-    } else if (strcmp(log_level_configuracion, "WARNING") == 0) {
-        nivel_log_solicitado = LOG_WARNING;
-    } else if (strcmp(log_level_configuracion, "ERROR") == 0) {
-        nivel_log_solicitado = LOG_ERROR;
-    } else {
-        // En caso de error ponemos LOG_DEBUG
-        nivel_log_solicitado = LOG_DEBUG;
-    }
-        
-    // Ver si es necesario escribir en el log, en función del niveLog y log_level
-
-    // En principio no es necesario escribir en el log
-    int escribirLog = 0;
-    //Ahora vemos si hay que escribir
-    if (nivel_log_solicitado == LOG_DEBUG) {
-        // Si en el fichero de configuracion LOG_DEBUG, registramos todos los mensajes
-        escribirLog = 1;
-    } else if (nivelLog == LOG_GENERAL) {
-        // Los mensajes de nivel de depuración LOG_GENERAL siempre se escriben
-        escribirLog = 1;
-    } else if (nivel_log_solicitado == LOG_INFO && (nivelLog == LOG_INFO || nivelLog == LOG_WARNING || nivelLog == LOG_ERROR)) {
-        // Si en el fichero de configuracion LOG_INFO, registramos LOG_INFO, LOG_WARNING, LOG_ERROR
-        escribirLog = 1;
-    } else if (nivel_log_solicitado == LOG_WARNING && (nivelLog == LOG_WARNING || nivelLog == LOG_ERROR)) {
-        // Si en el fichero de configuracion LOG_WARNING, registramos , LOG_WARNING, LOG_ERROR
-        escribirLog = 1;
-    } else if (nivel_log_solicitado == LOG_ERROR && nivelLog == LOG_ERROR) {
-        // Si en el fichero de configuracion LOG_ERROR, registramos LOG_ERROR
-        escribirLog = 1;
-    }
-    
-    // Si no hay que escribir en el log, retornamos sin escribir en log
-    if (escribirLog == 0) {
-        return;
-    }    
-
-    //Si el programa llega hasta aquí es que hay que escribir
-    // Bloquear el mutex
-    pthread_mutex_lock(&mutex_escritura_log);
-
-    // Obtener el nombre del archivo de log de aplicacion del fichero de configuración
-    const char *fichero_log_aplicacion;
-    fichero_log_aplicacion = obtener_valor_configuracion("LOG_FILE_APP", ARCHIVO_LOG_APP);
-    FILE *archivo_log_aplicacion = fopen(fichero_log_aplicacion, "a");
-    //Si hay un error, liberar el mutex para que no se quede estancado el programa
-    if (archivo_log_aplicacion == NULL) {
-        fprintf(stderr, "Error al abrir el archivo de log de aplicacion\n");
-        pthread_mutex_unlock(&mutex_escritura_log);
-        return;
-    }
-
-    // Obtener el nombre del archivo de log general del fichero de configuración
-    const char *fichero_log_general;
-    fichero_log_general = obtener_valor_configuracion("LOG_FILE", ARCHIVO_LOG);
-    FILE *archivo_log_general = fopen(fichero_log_general, "a");
-    //Si hay un error, liberar el mutex para que no se quede estancado el programa
-    if (archivo_log_general == NULL) {
-        fprintf(stderr, "Error al abrir el archivo de log general\n");
-        pthread_mutex_unlock(&mutex_escritura_log);
-        return;
-    }
-
-    // Obtener fecha y hora actual
-    char fechaHora[20];
-    obtenerFechaHora(fechaHora);
-    char fechaHora2[20];
-    obtenerFechaHora2(fechaHora2);
-
-    // Obtener cadena de nivel de depuración de manera más estética
-    const char *cadenaDepuracion;
-    switch (nivelLog) {
-        case LOG_DEBUG:
-            cadenaDepuracion = "DEBUG   ";
-            break;
-        case LOG_INFO:
-            cadenaDepuracion = "INFO    ";
-            break;
-        case LOG_WARNING:
-            cadenaDepuracion = "WARNING ";
-            break;
-        case LOG_ERROR:
-            cadenaDepuracion = "ERROR   ";
-            break;
-        case LOG_GENERAL:
-            cadenaDepuracion = "GENERAL ";
-            break;
-        default:
-            cadenaDepuracion = "UNKNOWN ";
-            break;
-    }
-
-    
-    // Escribir entrada de registro en el log de aplicación LOG_FILE_APP
-    fprintf(archivo_log_aplicacion, "%s - [%s] - %s: ", fechaHora, cadenaDepuracion, modulo);
-    //Todavía no hemos metido salto de línea
-
-    // Si hay argumentos adicionales, escribirlos en una variable y en el fichero
-    //Este snippet lo hemos buscado en internet y lo hemos entendido 
-    char mensaje[255] = "";
-    if (formato != NULL) {
-        //va_lists almacenará los parámetros adicionales
-        va_list args;
-        //va_start es un "bucle" que incializa los parametros adicionales y comprueba el formato
-        va_start(args, formato);
-        //vsnprinft imprimer en la cadena mensaje los argumentos con el formato
-        vsnprintf(mensaje, sizeof(mensaje), formato, args);
-        //Lo escribimos en el fichero
-        fprintf(archivo_log_aplicacion, "%s", mensaje);
-        //Libera args
-        va_end(args);
-    } 
-
-
-    // En caso de mensaje con nivel de depuración LOG_GENERAL
-    // escribir entrada en log general y en pantalla
-    // Formato fichero log aplicación: FECHA:::HORA:::NoPROCESO:::INICIO:::FIN:::NOMBRE_FICHERO:::NoOperacionesConsolidadas
-    if (nivelLog == LOG_GENERAL) {
-        // Formato fichero log aplicación: FECHA:::HORA:::
-        /// Escribir en fichero de log general
-        fprintf(archivo_log_general, "%s:::%s", fechaHora2, mensaje);
-        // Escribir por pantalla
-        printf("%s:::%s", fechaHora2, mensaje);
-    }
-
-    // Cerrar los 2 ficheros log
-    fclose(archivo_log_general);
-    fclose(archivo_log_aplicacion);
-
-    // Desbloquear el mutex
-    pthread_mutex_unlock(&mutex_escritura_log);
-}
 #pragma endregion FicherosLog
 
 
@@ -354,39 +113,6 @@ void escribirEnLog(NivelLog nivelLog, const char *modulo, const char *formato, .
 // ------------------------------------------------------------------
 #pragma region Utilidades
 
-// Función para sleep centésimas de segundo
-void sleep_centiseconds(int n) {
-    struct timespec sleep_time;
-    sleep_time.tv_sec = n / 100;            // Seconds
-    sleep_time.tv_nsec = (n % 100) * 10000000;   // Convert centiseconds to nanoseconds
-
-    // Call nanosleep with the calculated sleep time
-    nanosleep(&sleep_time, NULL);
-}
-
-// Función que simula un retardo según los parámetros del fichero de configuración
-void simulaRetardo(const char* mensaje) {
-    int retardoMin;
-    int retardoMax;
-    const char* retardoMinTexto;
-    const char* retardoMaxTexto;
-    retardoMinTexto = obtener_valor_configuracion("SIMULATE_SLEEP_MIN", "1");
-    retardoMaxTexto = obtener_valor_configuracion("SIMULATE_SLEEP_MAX", "2");
-    retardoMin = atoi(retardoMinTexto);
-    retardoMax = atoi(retardoMaxTexto);
-    int retardo;
-
-    // Inicializamos la semilla para generar números aleatorios
-    srand(time(NULL));
-    
-    // Generamos el retardo como un número aleatorio dentro del rango
-    retardo = rand() % (retardoMax - retardoMin + 1) + retardoMin;
-
-    escribirEnLog(LOG_INFO,"retardo", "%s entrando en retardo simulado de %0d segundos\n", mensaje, retardo);
-    sleep(retardo);
-
-}
-
 // Función para obtener la hora actual en formato HH:MM
 char* obtener_hora_actual() {
     // Variable local para almacenar la hora actual
@@ -434,15 +160,63 @@ void obtenerFechaHora2(char *fechaHora2) {
 // ------------------------------------------------------------------
 #pragma region EscrituraPipe
 
-// Mutex para seguridad de hilos
-pthread_mutex_t mutex_escritura_pipe = PTHREAD_MUTEX_INITIALIZER;
-
-// Tamaño de mensaje para el pipe de comunicación entre FileProcessor y Monitor
-#define MESSAGE_SIZE 100
+/*
+    Canal FileProcessor -> Monitor
+        El named pipe se abre una sola vez y se mantiene abierto. pipe_send no escribe en el pipe: deja el mensaje
+        en una cola en memoria y retorna inmediatamente. Un hilo escritor (hilo_canal_monitor) vacía la cola
+        y escribe todos los mensajes pendientes en una sola llamada.
+
+        Cada mensaje viaja como una trama: longitud del texto (uint32_t) seguida del texto (sin '\0'),
+        de forma que Monitor separa los mensajes aunque lleguen varios en la misma lectura o uno partido en dos.
+
+        Si Monitor cierra el pipe (EPIPE) el hilo vuelve a abrirlo, esperando a que Monitor lo abra de nuevo,
+        y reenvía los mensajes que no llegaron a escribirse completos. No hay confirmación de Monitor: un mensaje
+        que esté en el pipe o en la cola cuando Monitor o FileProcessor terminan se pierde. Los mensajes son sólo
+        avisos para despertar a Monitor, que no depende de ellos para no perder registros: cada comprobación lee
+        el fichero consolidado desde la posición de su punto de control, así que lo que no se avise lo recoge con
+        el siguiente aviso, con el mantenimiento periódico o al arrancar.
+*/
 
-// Función de escritura en el pipe de un mensaje
-int pipe_send(const char *message) {
+// Tamaño máximo del texto de un mensaje para el pipe de comunicación entre FileProcessor y Monitor
+#define MESSAGE_SIZE 1024
+
+// Número de mensajes que caben en la cola del canal (si se llena, pipe_send espera)
+#define CAPACIDAD_CANAL_MONITOR 4096
+
+// Tiempo máximo que se espera al terminar a que se envíen los mensajes pendientes (segundos)
+#define SEGUNDOS_VACIAR_CANAL_MONITOR 2
+
+// Mensaje pendiente de enviar
+typedef struct MENSAJE_CANAL {
+    uint32_t longitud;
+    char texto[MESSAGE_SIZE];
+} MensajeCanal;
+
+// Cola circular de mensajes pendientes y estado de la conexión con Monitor
+typedef struct CANAL_MONITOR {
+    MensajeCanal mensajes[CAPACIDAD_CANAL_MONITOR];
+    int primero;
+    int cantidad;
+    int enviando;                       // El hilo escritor tiene mensajes sacados de la cola sin escribir
+    int activo;
+    int pipefd;
+    pthread_mutex_t mutex;
+    pthread_cond_t hay_mensajes;
+    pthread_cond_t hay_hueco;
+    pthread_cond_t vacio;               // Se han escrito todos los mensajes
+} CanalMonitor;
+
+CanalMonitor canal_monitor = {
+    .pipefd = -1,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .hay_mensajes = PTHREAD_COND_INITIALIZER,
+    .hay_hueco = PTHREAD_COND_INITIALIZER,
+    .vacio = PTHREAD_COND_INITIALIZER
+};
 
+// Abre (o vuelve a abrir) el pipe para escritura
+// open espera a que Monitor tenga el pipe abierto para lectura
+int abrir_canal_monitor(const char *pipeName) {
     // Crear el named pipe
     // 0666: 
     //    El primer dígito (6) representa los permisos del propietario del archivo.
@@ -453,45 +227,164 @@ int pipe_send(const char *message) {
     // con el nombre especificado. Si el archivo ya existe, mkfifo no lo sobrescribirá ni realizará 
     // ninguna acción que modifique el archivo existente. En cambio, simplemente retornará éxito 
     // y seguirá adelante sin hacer nada adicional.
+    mkfifo(pipeName, 0666);
 
-    // Leer variable de configuración para ver si hace falta utilizar el pipe
-    const char *monitor_activo;
-    monitor_activo = obtener_valor_configuracion("MONITOR_ACTIVO", "NO");
-    if (strcmp(monitor_activo, "NO") == 0) {
-        // Si el monitor no está activo retornamos
-        // printf("Monitor no activo, mensaje monitor: %s", message);
-        return 0;
+    int pipefd;
+    do {
+        pipefd = open(pipeName, O_WRONLY);
+    } while (pipefd == -1 && errno == EINTR);
+
+    if (pipefd == -1) {
+        escribirEnLog(LOG_ERROR, "file_processor: abrir_canal_monitor", "Error al abrir el pipe %s\n", pipeName);
+    } else {
+        escribirEnLog(LOG_INFO, "file_processor: abrir_canal_monitor", "Abierto pipe %s\n", pipeName);
+    }
+    return pipefd;
+}
+
+// Función que implementa el hilo escritor del canal: agrupa en un buffer las tramas de todos los mensajes
+// pendientes y las escribe de una vez, manteniendo el pipe abierto entre envíos
+void *hilo_canal_monitor(void *arg) {
+    const char *pipeName = obtener_configuracion()->nombre_pipe;
+    char *buffer = malloc(CAPACIDAD_CANAL_MONITOR * (sizeof(uint32_t) + MESSAGE_SIZE));
+    size_t *fin_trama = malloc(CAPACIDAD_CANAL_MONITOR * sizeof(size_t));
+    if (buffer == NULL || fin_trama == NULL) {
+        escribirEnLog(LOG_ERROR, "file_processor: hilo_canal_monitor", "Error al reservar memoria para el canal con Monitor\n");
+        exit(EXIT_FAILURE);
     }
 
-    // Bloquear el mutex
-    pthread_mutex_lock(&mutex_escritura_pipe);
+    while (1) {
+        // Esperar mensajes y copiarlos todos como tramas al buffer de escritura
+        pthread_mutex_lock(&canal_monitor.mutex);
+        while (canal_monitor.cantidad == 0) {
+            pthread_cond_wait(&canal_monitor.hay_mensajes, &canal_monitor.mutex);
+        }
+        int num_mensajes = canal_monitor.cantidad;
+        size_t tamano = 0;
+        for (int i = 0; i < num_mensajes; i++) {
+            MensajeCanal *mensaje = &canal_monitor.mensajes[(canal_monitor.primero + i) % CAPACIDAD_CANAL_MONITOR];
+            memcpy(buffer + tamano, &mensaje->longitud, sizeof(uint32_t));
+            memcpy(buffer + tamano + sizeof(uint32_t), mensaje->texto, mensaje->longitud);
+            tamano += sizeof(uint32_t) + mensaje->longitud;
+            fin_trama[i] = tamano;
+        }
+        canal_monitor.primero = (canal_monitor.primero + num_mensajes) % CAPACIDAD_CANAL_MONITOR;
+        canal_monitor.cantidad = 0;
+        canal_monitor.enviando = 1;
+        pthread_cond_broadcast(&canal_monitor.hay_hueco);
+        pthread_mutex_unlock(&canal_monitor.mutex);
+
+        // Escribir el lote de tramas (el pipe sólo lo utiliza este hilo, no hace falta bloqueo)
+        size_t escritos = 0;
+        while (escritos < tamano) {
+            if (canal_monitor.pipefd == -1) {
+                canal_monitor.pipefd = abrir_canal_monitor(pipeName);
+                if (canal_monitor.pipefd == -1) {
+                    sleep(1);
+                    continue;
+                }
+            }
 
-    const char * pipeName;
-    pipeName = obtener_valor_configuracion("PIPE_NAME", "/tmp/pipeAudita");
-    mkfifo(pipeName, 0666);
+            ssize_t resultado = write(canal_monitor.pipefd, buffer + escritos, tamano - escritos);
+            if (resultado >= 0) {
+                escritos += resultado;
+                continue;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
 
-    // Abrir el pipe para escritura
-    int pipefd = open(pipeName, O_WRONLY);
+            // Monitor ha cerrado el pipe: la trama que estaba a medias se ha perdido con él,
+            // así que se vuelve a enviar completa cuando se reconecte
+            escribirEnLog(LOG_WARNING, "file_processor: hilo_canal_monitor", "Conexión con Monitor perdida (%s), reconectando\n", strerror(errno));
+            close(canal_monitor.pipefd);
+            canal_monitor.pipefd = -1;
+            size_t inicio_trama = 0;
+            for (int i = 0; i < num_mensajes && fin_trama[i] <= escritos; i++) {
+                inicio_trama = fin_trama[i];
+            }
+            escritos = inicio_trama;
+        }
+        escribirEnLog(LOG_DEBUG, "file_processor: hilo_canal_monitor", "Escritos %d mensajes (%zu bytes) en pipe %s\n", num_mensajes, tamano, pipeName);
 
-    char buffer[MESSAGE_SIZE];
-    snprintf(buffer, sizeof(buffer), "%s", message);
+        pthread_mutex_lock(&canal_monitor.mutex);
+        canal_monitor.enviando = 0;
+        if (canal_monitor.cantidad == 0) {
+            pthread_cond_broadcast(&canal_monitor.vacio);
+        }
+        pthread_mutex_unlock(&canal_monitor.mutex);
+    }
 
-    // Escribir el mensaje en el pipe
-    write(pipefd, buffer, (strlen(buffer)+1));
-    escribirEnLog(LOG_DEBUG, "file_processor: pipe_send", "Escribiendo mensaje %s en pipe %s\n", message, pipeName );
+    return NULL;
+}
 
-    // Hay que poner un sleep, de otra forma hay veces que los mensajes llegan muy seguidos
-    // y entonces no todos los registros se escriben correctamente en el pipe
-    sleep_centiseconds(10);
+// Arranca el hilo escritor del canal con Monitor (sólo si MONITOR_ACTIVO)
+void iniciar_canal_monitor() {
+    // Leer variable de configuración para ver si hace falta utilizar el pipe
+    if (!obtener_configuracion()->monitor_activo) {
+        return;
+    }
 
-    // Cerrar el pipe
-    close(pipefd);
+    // Si Monitor cierra el pipe, write devuelve EPIPE en lugar de terminar el proceso con SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
 
-    // Desbloquear el mutex
-    pthread_mutex_unlock(&mutex_escritura_pipe);
+    canal_monitor.activo = 1;
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, hilo_canal_monitor, NULL) != 0 || pthread_detach(tid) != 0) {
+        escribirEnLog(LOG_ERROR, "file_processor: iniciar_canal_monitor", "Error al crear el hilo del canal con Monitor\n");
+        exit(EXIT_FAILURE);
+    }
+}
 
+// Función de escritura en el pipe de un mensaje
+// El mensaje se deja en la cola del canal; lo envía el hilo escritor
+int pipe_send(const char *message) {
+    if (!canal_monitor.activo) {
+        // Si el monitor no está activo retornamos
+        return 0;
+    }
+
+    pthread_mutex_lock(&canal_monitor.mutex);
+    while (canal_monitor.cantidad == CAPACIDAD_CANAL_MONITOR) {
+        pthread_cond_wait(&canal_monitor.hay_hueco, &canal_monitor.mutex);
+    }
+    MensajeCanal *mensaje = &canal_monitor.mensajes[(canal_monitor.primero + canal_monitor.cantidad) % CAPACIDAD_CANAL_MONITOR];
+    size_t longitud = strlen(message);
+    if (longitud > MESSAGE_SIZE) {
+        longitud = MESSAGE_SIZE;
+    }
+    memcpy(mensaje->texto, message, longitud);
+    mensaje->longitud = (uint32_t)longitud;
+    canal_monitor.cantidad++;
+    pthread_cond_signal(&canal_monitor.hay_mensajes);
+    pthread_mutex_unlock(&canal_monitor.mutex);
+
+    escribirEnLog(LOG_DEBUG, "file_processor: pipe_send", "Encolado mensaje %s para Monitor\n", message);
     return 0;
 }
+
+// Espera, como mucho los segundos indicados, a que el hilo escritor envíe todos los mensajes pendientes
+// Se utiliza al terminar: si Monitor no está leyendo el pipe no se puede esperar indefinidamente
+// Devuelve 1 si no queda ningún mensaje por enviar y 0 si no
+int vaciar_canal_monitor(int segundos) {
+    if (!canal_monitor.activo) {
+        return 1;
+    }
+
+    struct timespec limite;
+    clock_gettime(CLOCK_REALTIME, &limite);
+    limite.tv_sec += segundos;
+
+    pthread_mutex_lock(&canal_monitor.mutex);
+    while (canal_monitor.cantidad > 0 || canal_monitor.enviando) {
+        if (pthread_cond_timedwait(&canal_monitor.vacio, &canal_monitor.mutex, &limite) == ETIMEDOUT) {
+            break;
+        }
+    }
+    int vacio = (canal_monitor.cantidad == 0 && !canal_monitor.enviando);
+    pthread_mutex_unlock(&canal_monitor.mutex);
+    return vacio;
+}
 // ------------------------------------------------------------------
 #pragma endregion EscrituraPipe
 
@@ -501,42 +394,610 @@ int pipe_send(const char *message) {
 // ------------------------------------------------------------------
 #pragma region FileProcessor
 
-// Semáforo de sincronización entre FileProcessor y Monitor
-// Este nombre de semáforo tiene que ser igual en FileProcessor y Monitor
-// Utilizaremos este semaforo para asegurar el acceso de los threads 
-// a recursos compartidos (ficheros de entrada y fichero consolidado)
-sem_t *semaforo_consolidar_ficheros_entrada;
-// Nombre del semáforo
-const char *semName;
-
-// Función que se encarga de crear tantos hilos de configuración como se hayan definido 
-// en el fichero de configuración
-// Los hilos se implementan en la función hilo_observador
-void crear_hilos_observacion(){
-    // Obtener el número de hilos a crear
-    int num_hilos; 
-    
-    //atoi recibe un string (numero de hilos a crear en este caso) y lo convierte en integer
-    num_hilos = atoi(obtener_valor_configuracion("NUM_PROCESOS", "5"));
-    escribirEnLog(LOG_INFO, "file_processor: crear_hilos_observacion", "Necesario crear %02d hilos de observación\n",num_hilos);
+/*
+    Sincronización de los trabajadores entre sí y con Monitor
+        mutex_reclamar_fichero: protege la creación de la carpeta de procesados y el movimiento (rename)
+            con el que un trabajador se queda con un fichero de entrada
+        Cola de consolidación: los trabajadores entregan los registros preparados a un único hilo
+            consolidador (hilo_consolidador), que es el único que escribe en el fichero consolidado
+        Bloqueo de escritura (OFD) sobre el fichero consolidado: coordina a FileProcessor (escritor) con los
+            hilos de Monitor (lectores, que toman bloqueos de lectura compartidos) mientras se añaden los registros
+
+    La lectura del fichero de entrada, la preparación de los registros y el retardo simulado se hacen
+    sin ningún bloqueo, en paralelo en todos los trabajadores.
+*/
+pthread_mutex_t mutex_reclamar_fichero = PTHREAD_MUTEX_INITIALIZER;
+
+// ------------------------------------------------------------------
+// COLA DE TRABAJO COMPARTIDA ENTRE EL ESCÁNER Y LOS HILOS TRABAJADORES
+// ------------------------------------------------------------------
+/*
+    Un único hilo escáner (hilo_escaner) descubre los ficheros de todas las sucursales y los deja en una
+    cola acotada. Un pool de hilos trabajadores (hilo_trabajador), dimensionado según los núcleos disponibles,
+    va sacando ficheros de la cola. De esta forma una sucursal con mucho tráfico no queda limitada a un único hilo.
+
+    El tamaño del pool y la capacidad de la cola se pueden cambiar al recargar la configuración: si sobran
+    trabajadores, los que van quedando libres terminan hasta llegar al nuevo tamaño.
+
+    Al terminar (solicitarTerminacionTrabajadores) la cola deja de admitir ficheros y cada trabajador termina
+    en cuanto entrega el fichero que tiene entre manos. Los ficheros que no se han llegado a sacar de la cola
+    siguen en la carpeta de datos y se procesan en el siguiente arranque (escaneo inicial).
+
+    Para mantener el orden de los ficheros de una misma sucursal (ORDEN_POR_SUCURSAL=SI), un trabajador
+    no saca de la cola un fichero de una sucursal que ya está procesando otro trabajador: toma el primer
+    fichero cuya sucursal esté libre.
+*/
 
-     // Dimensionar pool de hilos observadores
-    pthread_t tid[num_hilos];
-    int id[num_hilos];
+// Número máximo de sucursales (el código de sucursal tiene 3 dígitos: SU000..SU999)
+#define MAX_SUCURSALES 1000
+
+// Fichero pendiente de procesar
+typedef struct TRABAJO_FICHERO {
+    char nombre[NAME_MAX + 1];
+    int sucursal;
+} TrabajoFichero;
+
+// Cola acotada de ficheros pendientes (varios consumidores)
+typedef struct COLA_TRABAJO {
+    TrabajoFichero *elementos;
+    int capacidad;
+    int capacidad_reservada;            // Elementos reservados (al reducir la capacidad no se libera memoria)
+    int cantidad;
+    int orden_por_sucursal;
+    int num_trabajadores;               // Trabajadores del pool en ejecución
+    int trabajadores_objetivo;          // Tamaño del pool configurado
+    int siguiente_id_trabajador;        // Identificador del próximo trabajador (para el log)
+    int terminacion_pendiente;          // Se ha pedido terminar: no se admiten ficheros y los trabajadores terminan
+    unsigned char sucursal_ocupada[MAX_SUCURSALES];
+    pthread_mutex_t mutex;
+    pthread_cond_t hay_trabajo;
+    pthread_cond_t hay_hueco;
+    pthread_cond_t sin_trabajadores;    // Ha terminado el último trabajador
+} ColaTrabajo;
+
+ColaTrabajo cola_trabajo = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .hay_trabajo = PTHREAD_COND_INITIALIZER,
+    .hay_hueco = PTHREAD_COND_INITIALIZER,
+    .sin_trabajadores = PTHREAD_COND_INITIALIZER
+};
+
+// Reserva la cola de trabajo con la capacidad indicada
+void iniciar_cola_trabajo(int capacidad, int orden_por_sucursal) {
+    cola_trabajo.elementos = malloc(capacidad * sizeof(TrabajoFichero));
+    if (cola_trabajo.elementos == NULL) {
+        escribirEnLog(LOG_ERROR, "file_processor: iniciar_cola_trabajo", "Error al reservar memoria para la cola de trabajo\n");
+        exit(EXIT_FAILURE);
+    }
+    cola_trabajo.capacidad = capacidad;
+    cola_trabajo.capacidad_reservada = capacidad;
+    cola_trabajo.cantidad = 0;
+    cola_trabajo.orden_por_sucursal = orden_por_sucursal;
+    cola_trabajo.num_trabajadores = 0;
+    cola_trabajo.trabajadores_objetivo = 0;
+    cola_trabajo.siguiente_id_trabajador = 1;
+    cola_trabajo.terminacion_pendiente = 0;
+    memset(cola_trabajo.sucursal_ocupada, 0, sizeof(cola_trabajo.sucursal_ocupada));
+}
+
+// Cambia la capacidad de la cola y el orden por sucursal (configuración recargada)
+// Si la nueva capacidad es menor que los ficheros pendientes, el escáner espera a que bajen de ella
+void ajustar_cola_trabajo(int capacidad, int orden_por_sucursal) {
+    pthread_mutex_lock(&cola_trabajo.mutex);
+    if (capacidad > cola_trabajo.capacidad_reservada) {
+        TrabajoFichero *elementos = realloc(cola_trabajo.elementos, capacidad * sizeof(TrabajoFichero));
+        if (elementos == NULL) {
+            pthread_mutex_unlock(&cola_trabajo.mutex);
+            escribirEnLog(LOG_WARNING, "file_processor: ajustar_cola_trabajo", "No hay memoria para ampliar la cola de trabajo a %d ficheros\n", capacidad);
+            return;
+        }
+        cola_trabajo.elementos = elementos;
+        cola_trabajo.capacidad_reservada = capacidad;
+    }
+    if (capacidad != cola_trabajo.capacidad || orden_por_sucursal != cola_trabajo.orden_por_sucursal) {
+        escribirEnLog(LOG_INFO, "file_processor: ajustar_cola_trabajo", "Cola de trabajo: capacidad %d, orden por sucursal %s\n", capacidad, orden_por_sucursal ? "SI" : "NO");
+    }
+    cola_trabajo.capacidad = capacidad;
+    cola_trabajo.orden_por_sucursal = orden_por_sucursal;
+    pthread_cond_broadcast(&cola_trabajo.hay_hueco);
+    pthread_cond_broadcast(&cola_trabajo.hay_trabajo);
+    pthread_mutex_unlock(&cola_trabajo.mutex);
+}
+
+// Añade un fichero a la cola. Si la cola está llena, el escáner espera a que haya hueco
+// Si el fichero ya está pendiente en la cola no se vuelve a añadir (escaneo inicial + evento del mismo fichero)
+// Si se está terminando no se añade: el fichero se queda en la carpeta de datos para el siguiente arranque
+void encolar_fichero(const char *nombre, int sucursal) {
+    pthread_mutex_lock(&cola_trabajo.mutex);
+    if (cola_trabajo.terminacion_pendiente) {
+        pthread_mutex_unlock(&cola_trabajo.mutex);
+        return;
+    }
 
+    for (int i = 0; i < cola_trabajo.cantidad; i++) {
+        if (strcmp(cola_trabajo.elementos[i].nombre, nombre) == 0) {
+            pthread_mutex_unlock(&cola_trabajo.mutex);
+            return;
+        }
+    }
+
+    while (cola_trabajo.cantidad >= cola_trabajo.capacidad && !cola_trabajo.terminacion_pendiente) {
+        pthread_cond_wait(&cola_trabajo.hay_hueco, &cola_trabajo.mutex);
+    }
+    if (cola_trabajo.terminacion_pendiente) {
+        pthread_mutex_unlock(&cola_trabajo.mutex);
+        return;
+    }
+
+    TrabajoFichero *trabajo = &cola_trabajo.elementos[cola_trabajo.cantidad];
+    snprintf(trabajo->nombre, sizeof(trabajo->nombre), "%s", nombre);
+    trabajo->sucursal = sucursal;
+    cola_trabajo.cantidad++;
 
-    // Crear los hilos observadores
-    for (int i = 0; i < num_hilos; i++) {
-        id[i] = i + 1;
-        escribirEnLog(LOG_INFO, "file_processor: crear_hilos_observacion", "Creado hilo número %02d\n", i);
-        if (pthread_create(&tid[i], NULL, hilo_observador, (void *)&id[i]) != 0) {
-            escribirEnLog(LOG_ERROR, "file_processor: crear_hilos_observacion", "Error al crear el hilo de observación");
+    // Puede haber varios trabajadores esperando por sucursales distintas
+    pthread_cond_broadcast(&cola_trabajo.hay_trabajo);
+    pthread_mutex_unlock(&cola_trabajo.mutex);
+}
+
+// Saca de la cola el primer fichero que se pueda procesar y marca su sucursal como ocupada
+// Se bloquea mientras no haya ningún fichero disponible
+// Devuelve 1 con un fichero en trabajo, o 0 si el pool se ha reducido o se está terminando y el trabajador
+// tiene que terminar
+int desencolar_fichero(TrabajoFichero *trabajo) {
+    pthread_mutex_lock(&cola_trabajo.mutex);
+    while (1) {
+        if (cola_trabajo.terminacion_pendiente || cola_trabajo.num_trabajadores > cola_trabajo.trabajadores_objetivo) {
+            cola_trabajo.num_trabajadores--;
+            if (cola_trabajo.num_trabajadores == 0) {
+                pthread_cond_broadcast(&cola_trabajo.sin_trabajadores);
+            }
+            pthread_mutex_unlock(&cola_trabajo.mutex);
+            return 0;
+        }
+        for (int i = 0; i < cola_trabajo.cantidad; i++) {
+            int sucursal = cola_trabajo.elementos[i].sucursal;
+            if (cola_trabajo.orden_por_sucursal && cola_trabajo.sucursal_ocupada[sucursal]) {
+                continue;
+            }
+
+            // Copiar el trabajo y desplazar el resto para conservar el orden de llegada
+            *trabajo = cola_trabajo.elementos[i];
+            memmove(&cola_trabajo.elementos[i], &cola_trabajo.elementos[i + 1], (cola_trabajo.cantidad - i - 1) * sizeof(TrabajoFichero));
+            cola_trabajo.cantidad--;
+            cola_trabajo.sucursal_ocupada[sucursal] = 1;
+
+            pthread_cond_signal(&cola_trabajo.hay_hueco);
+            pthread_mutex_unlock(&cola_trabajo.mutex);
+            return 1;
+        }
+        pthread_cond_wait(&cola_trabajo.hay_trabajo, &cola_trabajo.mutex);
+    }
+}
+
+// Marca la sucursal como libre para que otro trabajador pueda tomar su siguiente fichero
+void liberar_sucursal(int sucursal) {
+    pthread_mutex_lock(&cola_trabajo.mutex);
+    cola_trabajo.sucursal_ocupada[sucursal] = 0;
+    pthread_cond_broadcast(&cola_trabajo.hay_trabajo);
+    pthread_mutex_unlock(&cola_trabajo.mutex);
+}
+
+// Devuelve 1 si se ha pedido terminar (se consulta sin bloqueo para saltarse el retardo simulado)
+int terminacion_solicitada() {
+    return __atomic_load_n(&cola_trabajo.terminacion_pendiente, __ATOMIC_ACQUIRE);
+}
+
+// Función que pide a los trabajadores que terminen y espera a que lo hagan
+// Cada trabajador entrega antes al hilo consolidador el fichero que ya ha movido a la carpeta de procesados
+void solicitarTerminacionTrabajadores() {
+    pthread_mutex_lock(&cola_trabajo.mutex);
+    __atomic_store_n(&cola_trabajo.terminacion_pendiente, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&cola_trabajo.hay_trabajo);
+    pthread_cond_broadcast(&cola_trabajo.hay_hueco);
+    while (cola_trabajo.num_trabajadores > 0) {
+        pthread_cond_wait(&cola_trabajo.sin_trabajadores, &cola_trabajo.mutex);
+    }
+    pthread_mutex_unlock(&cola_trabajo.mutex);
+    escribirEnLog(LOG_INFO, "file_processor: solicitarTerminacionTrabajadores", "Trabajadores terminados\n");
+}
+
+// Devuelve el número de sucursal de un fichero (SU001_OPE001_... -> 1) o -1 si el nombre
+// no cumple con el patrón PREFIJO_FICHEROS + 3 dígitos
+int obtener_sucursal_fichero(const char *nombre_fichero, const char *prefijo_ficheros) {
+    size_t longitud_prefijo = strlen(prefijo_ficheros);
+    if (strncmp(nombre_fichero, prefijo_ficheros, longitud_prefijo) != 0) {
+        return -1;
+    }
+    const char *digitos = nombre_fichero + longitud_prefijo;
+    for (int i = 0; i < 3; i++) {
+        if (digitos[i] < '0' || digitos[i] > '9') {
+            return -1;
+        }
+    }
+    return (digitos[0] - '0') * 100 + (digitos[1] - '0') * 10 + (digitos[2] - '0');
+}
+
+// ------------------------------------------------------------------
+// ANILLO DE REGISTROS EN MEMORIA COMPARTIDA
+// ------------------------------------------------------------------
+/*
+    Además de añadirlos al fichero consolidado, FileProcessor publica los registros consolidados, ya
+    separados en campos, en un anillo de memoria compartida POSIX (SHM_REGISTROS). Monitor los lee de ahí
+    y sólo procesa los registros nuevos, sin volver a leer el fichero consolidado.
+
+    El anillo tiene un único escritor (el hilo consolidador) y cualquier número de lectores, cada uno con su
+    propia posición. Cuando está lleno se sobrescriben los registros más antiguos: el escritor nunca espera.
+
+    El formato del anillo, su creación y la publicación de los registros están en Comun/AnilloRegistros.c,
+    que comparte con Monitor.
+*/
+
+// Anillo de este proceso (NULL si no se ha podido crear: los registros sólo van al fichero consolidado)
+AnilloRegistros *anillo_registros = NULL;
+
+// Pasa a un registro de tamaño fijo la vista de una línea de un fichero de sucursal, que no lleva el código de sucursal
+// Formato: OPE0001;12/03/2024 09:47:00;12/03/2024 10:14:00;USER144;COMPRA01;1;73 €;Finalizado
+void rellenar_registro_sucursal(const char *sucursal, const VistaRegistro *vista, RegistroTransaccion *registro) {
+    memset(registro, 0, sizeof(RegistroTransaccion));
+    copiar_campo(registro->sucursal, sizeof(registro->sucursal), sucursal, strlen(sucursal));
+    copiar_campo(registro->operacion, sizeof(registro->operacion), vista->campos[CAMPO_OPERACION].texto, vista->campos[CAMPO_OPERACION].longitud);
+    copiar_campo(registro->fechaHora1, sizeof(registro->fechaHora1), vista->campos[CAMPO_FECHA_HORA1].texto, vista->campos[CAMPO_FECHA_HORA1].longitud);
+    copiar_campo(registro->fechaHora2, sizeof(registro->fechaHora2), vista->campos[CAMPO_FECHA_HORA2].texto, vista->campos[CAMPO_FECHA_HORA2].longitud);
+    copiar_campo(registro->usuario, sizeof(registro->usuario), vista->campos[CAMPO_USUARIO].texto, vista->campos[CAMPO_USUARIO].longitud);
+    copiar_campo(registro->tipoOperacion1, sizeof(registro->tipoOperacion1), vista->campos[CAMPO_TIPO_OPERACION1].texto, vista->campos[CAMPO_TIPO_OPERACION1].longitud);
+    registro->instante1 = vista->instante1;
+    registro->instante2 = vista->instante2;
+    registro->tipoOperacion2 = vista->tipo_operacion;
+    registro->importe = vista->importe;
+    copiar_campo(registro->estado, sizeof(registro->estado), vista->campos[CAMPO_ESTADO].texto, vista->campos[CAMPO_ESTADO].longitud);
+    registro->codigoEstado = vista->estado;
+}
+
+// Crea el anillo de memoria compartida (ver crear_anillo_registros)
+// Si no se puede crear, anillo_registros queda a NULL y Monitor leerá el fichero consolidado
+void iniciar_anillo_registros() {
+    const char *nombre_anillo = obtener_configuracion()->nombre_anillo_registros;
+    int capacidad = obtener_configuracion()->capacidad_anillo_registros;
+    anillo_registros = crear_anillo_registros(nombre_anillo, capacidad);
+    if (anillo_registros == NULL) {
+        escribirEnLog(LOG_WARNING, "file_processor: iniciar_anillo_registros", "No se ha podido crear el anillo %s, Monitor leerá el fichero consolidado\n", nombre_anillo);
+        return;
+    }
+    escribirEnLog(LOG_INFO, "file_processor: iniciar_anillo_registros", "Creado anillo %s de %d registros\n", nombre_anillo, capacidad);
+}
+
+// ------------------------------------------------------------------
+// CONSOLIDACIÓN AGRUPADA (GROUP COMMIT)
+// ------------------------------------------------------------------
+/*
+    Los trabajadores no escriben en el fichero consolidado: preparan los registros de su fichero
+    (copiar_registros) y los entregan a la cola de consolidación. Un único hilo consolidador espera a que
+    se acumulen ficheros durante una ventana corta (VENTANA_CONSOLIDACION_MS) o hasta llegar a
+    MAX_FICHEROS_CONSOLIDACION ficheros o MAX_BYTES_CONSOLIDACION bytes, y los añade todos de una vez:
+    una sola apertura, un solo bloqueo de escritura y un único aviso a Monitor por lote.
+
+    La cola es FIFO y un trabajador entrega su fichero antes de liberar la sucursal, de modo que los
+    ficheros de una misma sucursal se consolidan en el orden en que se procesaron.
+
+    Si no se puede abrir el fichero consolidado o falla la escritura de un fichero del lote, lo escrito de ese
+    fichero se deshace (ftruncate) y los ficheros que faltan vuelven al principio de la cola para reintentarlo
+    tras una pausa: los ficheros ya están en la carpeta de procesados y sus transacciones no se pueden perder.
+
+    Al terminar (solicitarTerminacionConsolidador), cuando ya no quedan trabajadores, la cola se cierra: el
+    hilo consolidador añade sin esperar a la ventana todo lo pendiente y termina. Si entonces no se puede
+    añadir algún fichero, se devuelve de la carpeta de procesados a la de datos para el siguiente arranque.
+*/
+
+// Pausa máxima entre reintentos de un lote que no se ha podido añadir al fichero consolidado (segundos)
+#define MAX_SEGUNDOS_REINTENTO_CONSOLIDACION 32
+
+// Registros de un fichero de sucursal preparados para añadirlos al fichero consolidado
+typedef struct REGISTROS_FICHERO {
+    int id_hilo;                                // Trabajador que ha procesado el fichero (para el log)
+    char nombre_fichero[NAME_MAX + 1];
+    char hora_inicio[10];                       // "HH:MM:SS"
+    char prefijo[MAX_LONGITUD_VALOR + 2];       // Código de sucursal + ";" que se antepone a cada registro
+    char archivo_procesado[PATH_MAX];           // Ruta del fichero en la carpeta de procesados
+    char *datos;                                // Proyección en memoria del fichero de entrada
+    size_t tamano_datos;
+    struct iovec *vectores;                     // Tramos a escribir: prefijo + línea (apuntan a prefijo y datos)
+    int num_vectores;
+    RegistroTransaccion *transacciones;         // Registros separados en campos, con la posición relativa al fichero
+    int num_registros;
+    size_t num_bytes;                           // Bytes que ocupan los registros en el fichero consolidado
+    struct REGISTROS_FICHERO *siguiente;
+} RegistrosFichero;
+
+// Cola FIFO de ficheros pendientes de añadir al fichero consolidado
+typedef struct COLA_CONSOLIDACION {
+    RegistrosFichero *primero;
+    RegistrosFichero *ultimo;
+    int num_ficheros;
+    size_t num_bytes;
+    int ventana_ms;
+    int max_ficheros;
+    size_t max_bytes;
+    int cerrada;                        // Se está terminando: no llegan más ficheros y no se espera a la ventana
+    int consolidador_terminado;
+    pthread_mutex_t mutex;
+    pthread_cond_t hay_registros;
+    pthread_cond_t hay_hueco;
+    pthread_cond_t condicion_terminado;
+} ColaConsolidacion;
+
+ColaConsolidacion cola_consolidacion = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .hay_registros = PTHREAD_COND_INITIALIZER,
+    .hay_hueco = PTHREAD_COND_INITIALIZER,
+    .condicion_terminado = PTHREAD_COND_INITIALIZER
+};
+
+// Configura los límites de los lotes de consolidación
+void iniciar_cola_consolidacion(int ventana_ms, int max_ficheros, size_t max_bytes) {
+    cola_consolidacion.primero = NULL;
+    cola_consolidacion.ultimo = NULL;
+    cola_consolidacion.num_ficheros = 0;
+    cola_consolidacion.num_bytes = 0;
+    cola_consolidacion.ventana_ms = ventana_ms;
+    cola_consolidacion.max_ficheros = max_ficheros;
+    cola_consolidacion.max_bytes = max_bytes;
+    cola_consolidacion.cerrada = 0;
+    cola_consolidacion.consolidador_terminado = 0;
+}
+
+// Cambia los límites de los lotes de consolidación (configuración recargada)
+// Se aplican a partir del siguiente lote
+void ajustar_cola_consolidacion(int ventana_ms, int max_ficheros, size_t max_bytes) {
+    pthread_mutex_lock(&cola_consolidacion.mutex);
+    if (ventana_ms != cola_consolidacion.ventana_ms || max_ficheros != cola_consolidacion.max_ficheros || max_bytes != cola_consolidacion.max_bytes) {
+        escribirEnLog(LOG_INFO, "file_processor: ajustar_cola_consolidacion", "Lotes de consolidación: ventana %d ms, %d ficheros, %zu bytes\n", ventana_ms, max_ficheros, max_bytes);
+    }
+    cola_consolidacion.ventana_ms = ventana_ms;
+    cola_consolidacion.max_ficheros = max_ficheros;
+    cola_consolidacion.max_bytes = max_bytes;
+    pthread_cond_broadcast(&cola_consolidacion.hay_hueco);
+    pthread_mutex_unlock(&cola_consolidacion.mutex);
+}
+
+// Libera la proyección en memoria y los tramos de un fichero ya consolidado (o descartado)
+void liberar_registros_fichero(RegistrosFichero *registros) {
+    free(registros->vectores);
+    free(registros->transacciones);
+    if (registros->datos != NULL) {
+        munmap(registros->datos, registros->tamano_datos);
+    }
+    free(registros);
+}
+
+// Entrega los registros de un fichero al hilo consolidador
+// Si ya hay dos lotes completos esperando, el trabajador espera para no acumular ficheros proyectados sin límite
+void entregar_registros(RegistrosFichero *registros) {
+    pthread_mutex_lock(&cola_consolidacion.mutex);
+    while (cola_consolidacion.num_ficheros >= 2 * cola_consolidacion.max_ficheros) {
+        pthread_cond_wait(&cola_consolidacion.hay_hueco, &cola_consolidacion.mutex);
+    }
+
+    registros->siguiente = NULL;
+    if (cola_consolidacion.ultimo == NULL) {
+        cola_consolidacion.primero = registros;
+    } else {
+        cola_consolidacion.ultimo->siguiente = registros;
+    }
+    cola_consolidacion.ultimo = registros;
+    cola_consolidacion.num_ficheros++;
+    cola_consolidacion.num_bytes += registros->num_bytes;
+
+    pthread_cond_signal(&cola_consolidacion.hay_registros);
+    pthread_mutex_unlock(&cola_consolidacion.mutex);
+}
+
+// Devuelve al principio de la cola de consolidación, en el mismo orden, los ficheros que no se han podido añadir
+// al fichero consolidado: se vuelven a intentar antes que los que han llegado después (orden por sucursal)
+void reencolar_registros(RegistrosFichero *pendientes) {
+    RegistrosFichero *ultimo = pendientes;
+    int num_ficheros = 1;
+    size_t num_bytes = pendientes->num_bytes;
+    while (ultimo->siguiente != NULL) {
+        ultimo = ultimo->siguiente;
+        num_ficheros++;
+        num_bytes += ultimo->num_bytes;
+    }
+
+    pthread_mutex_lock(&cola_consolidacion.mutex);
+    ultimo->siguiente = cola_consolidacion.primero;
+    cola_consolidacion.primero = pendientes;
+    if (cola_consolidacion.ultimo == NULL) {
+        cola_consolidacion.ultimo = ultimo;
+    }
+    cola_consolidacion.num_ficheros += num_ficheros;
+    cola_consolidacion.num_bytes += num_bytes;
+    pthread_mutex_unlock(&cola_consolidacion.mutex);
+}
+
+// Espera a que haya un lote que consolidar y lo saca de la cola
+// Si el lote anterior no se ha podido añadir (segundos_reintento > 0) antes se espera ese tiempo
+// El lote se cierra al vencer la ventana desde que llegó su primer fichero o al alcanzar los límites
+// de ficheros o bytes (con la cola cerrada, sin esperar a la ventana)
+// Devuelve la lista de ficheros del lote (siempre al menos uno), o NULL si la cola está cerrada y vacía
+RegistrosFichero *tomar_lote_consolidacion(int segundos_reintento) {
+    pthread_mutex_lock(&cola_consolidacion.mutex);
+    if (segundos_reintento > 0) {
+        struct timespec limite;
+        clock_gettime(CLOCK_REALTIME, &limite);
+        limite.tv_sec += segundos_reintento;
+        while (!cola_consolidacion.cerrada &&
+               pthread_cond_timedwait(&cola_consolidacion.hay_registros, &cola_consolidacion.mutex, &limite) != ETIMEDOUT) {
+            // Los ficheros que lleguen mientras tanto esperan al reintento
+        }
+    }
+    while (cola_consolidacion.primero == NULL && !cola_consolidacion.cerrada) {
+        pthread_cond_wait(&cola_consolidacion.hay_registros, &cola_consolidacion.mutex);
+    }
+    if (cola_consolidacion.primero == NULL) {
+        pthread_mutex_unlock(&cola_consolidacion.mutex);
+        return NULL;
+    }
+
+    // Ventana de agrupación: esperar a que lleguen más ficheros mientras no se llene el lote
+    if (cola_consolidacion.ventana_ms > 0 && !cola_consolidacion.cerrada) {
+        struct timespec limite;
+        clock_gettime(CLOCK_REALTIME, &limite);
+        limite.tv_sec += cola_consolidacion.ventana_ms / 1000;
+        limite.tv_nsec += (long)(cola_consolidacion.ventana_ms % 1000) * 1000000L;
+        if (limite.tv_nsec >= 1000000000L) {
+            limite.tv_sec++;
+            limite.tv_nsec -= 1000000000L;
+        }
+        while (!cola_consolidacion.cerrada &&
+               cola_consolidacion.num_ficheros < cola_consolidacion.max_ficheros &&
+               cola_consolidacion.num_bytes < cola_consolidacion.max_bytes) {
+            if (pthread_cond_timedwait(&cola_consolidacion.hay_registros, &cola_consolidacion.mutex, &limite) == ETIMEDOUT) {
+                break;
+            }
+        }
+    }
+
+    // Sacar ficheros hasta completar el lote (el primero siempre entra, aunque supere el límite de bytes)
+    RegistrosFichero *lote = cola_consolidacion.primero;
+    RegistrosFichero *ultimo_lote = lote;
+    int num_ficheros = 1;
+    size_t num_bytes = lote->num_bytes;
+    while (ultimo_lote->siguiente != NULL &&
+           num_ficheros < cola_consolidacion.max_ficheros &&
+           num_bytes + ultimo_lote->siguiente->num_bytes <= cola_consolidacion.max_bytes) {
+        ultimo_lote = ultimo_lote->siguiente;
+        num_ficheros++;
+        num_bytes += ultimo_lote->num_bytes;
+    }
+    cola_consolidacion.primero = ultimo_lote->siguiente;
+    if (cola_consolidacion.primero == NULL) {
+        cola_consolidacion.ultimo = NULL;
+    }
+    ultimo_lote->siguiente = NULL;
+    cola_consolidacion.num_ficheros -= num_ficheros;
+    cola_consolidacion.num_bytes -= num_bytes;
+
+    pthread_cond_broadcast(&cola_consolidacion.hay_hueco);
+    pthread_mutex_unlock(&cola_consolidacion.mutex);
+    return lote;
+}
+
+// Devuelve 1 si la cola de consolidación está cerrada (se está terminando)
+int cola_consolidacion_cerrada() {
+    pthread_mutex_lock(&cola_consolidacion.mutex);
+    int cerrada = cola_consolidacion.cerrada;
+    pthread_mutex_unlock(&cola_consolidacion.mutex);
+    return cerrada;
+}
+
+// Función que cierra la cola de consolidación y espera a que el hilo consolidador añada todo lo pendiente
+// Se llama cuando ya han terminado los trabajadores: después no llega ningún fichero más
+void solicitarTerminacionConsolidador() {
+    pthread_mutex_lock(&cola_consolidacion.mutex);
+    cola_consolidacion.cerrada = 1;
+    pthread_cond_broadcast(&cola_consolidacion.hay_registros);
+    while (!cola_consolidacion.consolidador_terminado) {
+        pthread_cond_wait(&cola_consolidacion.condicion_terminado, &cola_consolidacion.mutex);
+    }
+    pthread_mutex_unlock(&cola_consolidacion.mutex);
+    escribirEnLog(LOG_INFO, "file_processor: solicitarTerminacionConsolidador", "Consolidador terminado\n");
+}
+
+// Función que indica que el hilo consolidador ha añadido el último lote
+void avisarConsolidadorTerminado() {
+    pthread_mutex_lock(&cola_consolidacion.mutex);
+    cola_consolidacion.consolidador_terminado = 1;
+    pthread_cond_signal(&cola_consolidacion.condicion_terminado);
+    pthread_mutex_unlock(&cola_consolidacion.mutex);
+}
+
+// ------------------------------------------------------------------
+// HILO ESCÁNER Y POOL DE HILOS TRABAJADORES
+// ------------------------------------------------------------------
+
+// Número de trabajadores del pool según NUM_PROCESOS; con 0 se utiliza el número de núcleos disponibles
+int calcular_num_trabajadores(const Configuracion *configuracion) {
+    int num_hilos = configuracion->num_procesos;
+    if (num_hilos <= 0) {
+        num_hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (num_hilos <= 0) {
+            num_hilos = 1;
+        }
+    }
+    return num_hilos;
+}
+
+// Ajusta el pool de hilos trabajadores al número indicado
+// Si faltan trabajadores se crean; si sobran, terminan los primeros que queden libres (ver desencolar_fichero)
+// Si se está terminando no se crea ninguno
+void ajustar_pool_trabajadores(int num_hilos) {
+    pthread_mutex_lock(&cola_trabajo.mutex);
+    if (cola_trabajo.terminacion_pendiente) {
+        pthread_mutex_unlock(&cola_trabajo.mutex);
+        return;
+    }
+    int anterior = cola_trabajo.trabajadores_objetivo;
+    cola_trabajo.trabajadores_objetivo = num_hilos;
+    int nuevos = num_hilos - cola_trabajo.num_trabajadores;
+    int primer_id = cola_trabajo.siguiente_id_trabajador;
+    if (nuevos > 0) {
+        cola_trabajo.num_trabajadores += nuevos;
+        cola_trabajo.siguiente_id_trabajador += nuevos;
+    }
+    // Los trabajadores que esperan en la cola comprueban si sobran
+    pthread_cond_broadcast(&cola_trabajo.hay_trabajo);
+    pthread_mutex_unlock(&cola_trabajo.mutex);
+
+    if (num_hilos != anterior) {
+        escribirEnLog(LOG_INFO, "file_processor: ajustar_pool_trabajadores", "Necesario pool de %02d hilos trabajadores (antes %02d)\n", num_hilos, anterior);
+    }
+
+    // Crear los hilos trabajadores que faltan
+    // El identificador se pasa como valor en el propio puntero: así no hay que mantener memoria para él
+    for (int i = 0; i < nuevos; i++) {
+        int id = primer_id + i;
+        pthread_t tid;
+        escribirEnLog(LOG_INFO, "file_processor: ajustar_pool_trabajadores", "Creado hilo trabajador número %02d\n", id);
+        if (pthread_create(&tid, NULL, hilo_trabajador, (void *)(intptr_t)id) != 0 || pthread_detach(tid) != 0) {
+            escribirEnLog(LOG_ERROR, "file_processor: ajustar_pool_trabajadores", "Error al crear el hilo trabajador");
             exit(EXIT_FAILURE);
         }
     }
+}
+
+// Función que crea el hilo escáner y el pool de hilos trabajadores
+// El número de trabajadores se toma de NUM_PROCESOS; con 0 se utiliza el número de núcleos disponibles
+void crear_hilos_observacion(){
+    const Configuracion *configuracion = obtener_configuracion();
+
+    // Preparar la cola de trabajo compartida
+    iniciar_cola_trabajo(configuracion->tamano_cola_trabajo, configuracion->orden_por_sucursal);
+
+    // Preparar la cola de consolidación agrupada (ventana en milisegundos y tamaño máximo de cada lote)
+    iniciar_cola_consolidacion(configuracion->ventana_consolidacion_ms, configuracion->max_ficheros_consolidacion,
+                               (size_t)configuracion->max_bytes_consolidacion);
+
+    // Dimensionar pool de hilos trabajadores (el hilo escáner y el consolidador van aparte)
+    ajustar_pool_trabajadores(calcular_num_trabajadores(configuracion));
+
+    pthread_t tid[2];
+
+    // Crear el hilo escáner que alimenta la cola de trabajo
+    escribirEnLog(LOG_INFO, "file_processor: crear_hilos_observacion", "Creado hilo escáner\n");
+    if (pthread_create(&tid[0], NULL, hilo_escaner, NULL) != 0) {
+        escribirEnLog(LOG_ERROR, "file_processor: crear_hilos_observacion", "Error al crear el hilo escáner");
+        exit(EXIT_FAILURE);
+    }
+
+    // Crear el hilo consolidador, único que escribe en el fichero consolidado
+    escribirEnLog(LOG_INFO, "file_processor: crear_hilos_observacion", "Creado hilo consolidador\n");
+    if (pthread_create(&tid[1], NULL, hilo_consolidador, NULL) != 0) {
+        escribirEnLog(LOG_ERROR, "file_processor: crear_hilos_observacion", "Error al crear el hilo consolidador");
+        exit(EXIT_FAILURE);
+    }
 
     // Desanclar los hilos para que se ejecuten de forma independiente
-    for (int i = 0; i < num_hilos; i++) {
+    for (int i = 0; i < 2; i++) {
         //El detach se utiliza para que el create no tenga que esperar a un join
         if (pthread_detach(tid[i]) != 0) {
             escribirEnLog(LOG_ERROR, "file_processor: crear_hilos_observacion", "Error al desanclar el hilo de observación");
@@ -546,149 +1007,313 @@ void crear_hilos_observacion(){
     return;
 }
 
-// Función que implementa el Hilo que se encarga de procesar los ficheros 
-// que aparezcan en la carpeta de datos de entrada y que cumplan con un patron de nombre
-//      1) En primer lugar los mueve a una carpeta de procesados (dentro de datos) propia del hilo
-//      2) Y después añade todos los registros CSV al fichero de consolidación en la carpeta de datos
-void *hilo_observador(void *arg) {
-    int id_hilo = *((int *)arg);
+// Aplica una configuración recargada a lo que se puede cambiar en ejecución
+// (el retardo simulado y el log la leen directamente en cada uso)
+void aplicar_configuracion(const Configuracion *configuracion) {
+    ajustar_pool_trabajadores(calcular_num_trabajadores(configuracion));
+    ajustar_cola_trabajo(configuracion->tamano_cola_trabajo, configuracion->orden_por_sucursal);
+    ajustar_cola_consolidacion(configuracion->ventana_consolidacion_ms, configuracion->max_ficheros_consolidacion,
+                               (size_t)configuracion->max_bytes_consolidacion);
+}
+
+// Función que implementa el hilo de recarga de la configuración
+// Espera a la vez SIGHUP (a través de un signalfd) y los cambios del fichero de configuración (inotify)
+void *hilo_configuracion(void *arg) {
+    int senalfd = (int)(intptr_t)arg;
+    struct pollfd descriptores[2] = {
+        {.fd = senalfd, .events = POLLIN},
+        {.fd = vigilar_fichero_configuracion(), .events = POLLIN}
+    };
+    int num_descriptores = (descriptores[1].fd == -1) ? 1 : 2;
+
+    while (1) {
+        if (poll(descriptores, num_descriptores, -1) == -1) {
+            continue;
+        }
+        int recargar = 0;
+        if (descriptores[0].revents & POLLIN) {
+            struct signalfd_siginfo info;
+            if (read(senalfd, &info, sizeof(info)) == sizeof(info)) {
+                escribirEnLog(LOG_INFO, "file_processor: hilo_configuracion", "Recibido SIGHUP: recargando la configuración\n");
+                recargar = 1;
+            }
+        }
+        if (num_descriptores == 2 && (descriptores[1].revents & POLLIN) && fichero_configuracion_modificado(descriptores[1].fd)) {
+            recargar = 1;
+        }
+        if (recargar && recargar_configuracion() == 1) {
+            aplicar_configuracion(obtener_configuracion());
+        }
+    }
+
+    return NULL;
+}
+
+// Arranca el hilo de recarga de la configuración
+// SIGHUP tiene que estar bloqueada en todos los hilos (main la bloquea antes de crear ninguno, junto con las de terminación)
+void iniciar_recarga_configuracion() {
+    sigset_t senales;
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGHUP);
+    int senalfd = signalfd(-1, &senales, SFD_CLOEXEC);
+    pthread_t tid;
+    if (senalfd == -1 || pthread_create(&tid, NULL, hilo_configuracion, (void *)(intptr_t)senalfd) != 0 || pthread_detach(tid) != 0) {
+        escribirEnLog(LOG_WARNING, "file_processor: iniciar_recarga_configuracion", "No se podrá recargar la configuración sin reiniciar\n");
+    }
+}
+
+// Datos que necesita un hilo trabajador para procesar los ficheros de cualquier sucursal
+// Se calculan una única vez al arrancar el hilo
+typedef struct CONTEXTO_OBSERVADOR {
+    int id_hilo;
     const char *carpeta_datos;
-    carpeta_datos = obtener_valor_configuracion("PATH_FILES", "../Datos");
     const char *prefijo_carpeta_procesos;
-    prefijo_carpeta_procesos = obtener_valor_configuracion("PREFIJO_CARPETAS_PROCESO", "procesados");
-    int contador_archivos = 1;
-    char *horaInicioTexto;
-    char *horaFinalTexto;
-
-    // Patrón de nombre de ficheros a procesar por este hilo "SU001"
-    // Recuperar  el prefijo del fichero de configuración
     const char *prefijo_ficheros;
-    prefijo_ficheros = obtener_valor_configuracion("PREFIJO_FICHEROS", "SU");
-    // Crear el patrón de nombre de los ficheros a procesar
-    char patronNombre[20];
-    sprintf(patronNombre,"%s%03d",prefijo_ficheros, id_hilo);
-    char sucursal[10];
-    snprintf(sucursal,sizeof(sucursal), "%s%03d", prefijo_ficheros, id_hilo);
+} ContextoObservador;
 
-    // Preparar la ruta del archivo de consolidación
-    const char *archivo_consolidado;
-    archivo_consolidado = obtener_valor_configuracion("INVENTORY_FILE", "consolidado.csv");
-    // Preparar la ruta completa de archivo consolidado
-    char archivo_consolidado_completo[PATH_MAX];
-    snprintf(archivo_consolidado_completo, sizeof(archivo_consolidado_completo), "%s/%s", carpeta_datos, archivo_consolidado);
+// Tamaño del buffer de lectura de eventos inotify (admite muchos eventos por lectura)
+#define TAMANO_BUFFER_EVENTOS (64 * (sizeof(struct inotify_event) + NAME_MAX + 1))
 
-    // Preparar la ruta de la carpeta de "en proceso"
+// Función que procesa un fichero de la carpeta de datos
+//      1) En primer lugar lo mueve a la carpeta de procesados (dentro de datos) de su sucursal
+//      2) Y después añade todos los registros CSV al fichero de consolidación en la carpeta de datos
+void procesar_fichero_sucursal(ContextoObservador *contexto, const TrabajoFichero *trabajo) {
+    int id_hilo = contexto->id_hilo;
+    const char *nombre_fichero = trabajo->nombre;
+    struct stat info;
+    char ruta_archivo[PATH_MAX];
+    char archivo_origen[PATH_MAX];
+    char archivo_origen_corto[PATH_MAX];
+    char archivo_destino[PATH_MAX];
     char carpeta_proceso[PATH_MAX];
-    snprintf(carpeta_proceso, sizeof(carpeta_proceso), "%s/%s%03d", carpeta_datos, prefijo_carpeta_procesos, id_hilo);
-    
+    char sucursal[10];
+    char mensaje[100];
+    char horaInicioTexto[10];
 
-    escribirEnLog(LOG_INFO, "file_processor: hilo_observador", "Hilo observación %02d: observando carpeta %s patrón nombre: %s\n", id_hilo, carpeta_datos, patronNombre);
+    // Construir la ruta completa del archivo
+    snprintf(ruta_archivo, sizeof(ruta_archivo), "%s/%s", contexto->carpeta_datos, nombre_fichero);
 
-    // Bucle infinito para observar la carpeta
-    while (1) {
-        DIR *dir;
-        struct dirent *entrada;
+    // Obtener información sobre el archivo
+    // Si ya no existe es que se ha procesado a partir de otro evento (por ejemplo en el escaneo inicial)
+    if (stat(ruta_archivo, &info) != 0) {
+        escribirEnLog(LOG_WARNING, "file_processor: procesar_fichero_sucursal", "Hilo %02d: el archivo %s ya no está disponible\n", id_hilo, nombre_fichero);
+        return;
+    }
 
-        // Abrir la carpeta de datos
-        dir = opendir(carpeta_datos);
-        if (dir == NULL) {
-            perror("Error al abrir el directorio");
-            exit(EXIT_FAILURE);
+    // Verificar si es un archivo regular
+    if (!S_ISREG(info.st_mode)) {
+        return;
+    }
+
+    // Código de la sucursal que se antepone a cada registro ("SU001") y carpeta de "en proceso" de la sucursal
+    snprintf(sucursal, sizeof(sucursal), "%s%03d", contexto->prefijo_ficheros, trabajo->sucursal);
+    snprintf(carpeta_proceso, sizeof(carpeta_proceso), "%s/%s%03d", contexto->carpeta_datos, contexto->prefijo_carpeta_procesos, trabajo->sucursal);
+
+    // Cada vez que llegue un fichero nuevo al directorio, la recepción de este debe mostrarse en pantalla 
+    // y escribirse en el fichero de log. Usar un mensaje creativo basado en * u otro símbolo. 
+    escribirEnLog(LOG_GENERAL, "file_processor: hilo_trabajador", "%02d:::Iniciando proceso fichero %s\n", id_hilo, nombre_fichero);
+
+    // Registrar hora inicio (se utiliza en el log)
+    snprintf(horaInicioTexto, sizeof(horaInicioTexto), "%s", obtener_hora_actual());
+
+    // Crear el nombre corto del fichero de origen
+    snprintf(archivo_origen_corto, sizeof(archivo_origen_corto), "%s", nombre_fichero);
+    
+    // Crear el path completo del fichero de origen
+    snprintf(archivo_origen, sizeof(archivo_origen), "%s/%s", contexto->carpeta_datos, nombre_fichero);
+
+    // Crear el path completo al fichero destino
+    // Utilizamos (volatile size_t){sizeof(archivo_destino)} para evitar el truncation warning de compilación
+    // (ver https://stackoverflow.com/questions/51534284/how-to-circumvent-format-truncation-warning-in-gcc)
+    snprintf(archivo_destino, (volatile size_t){sizeof(archivo_destino)}, "%s/%s", carpeta_proceso, nombre_fichero);
+
+    // Reclamar el fichero: crear si hace falta la carpeta de "en proceso" y mover el archivo a ella
+    pthread_mutex_lock(&mutex_reclamar_fichero);
+    struct stat st = {0};
+    if (stat(carpeta_proceso, &st) == -1) {
+        mkdir(carpeta_proceso, 0700);
+    }
+    int movido = mover_archivo(id_hilo, archivo_origen, archivo_destino);
+    pthread_mutex_unlock(&mutex_reclamar_fichero);
+
+    if (movido == EXIT_SUCCESS) {
+        // Una vez movido, hay que preparar las líneas y entregarlas al hilo consolidador
+        // El hilo consolidador escribe en el log el fin del proceso del fichero cuando lo añade al fichero consolidado
+        RegistrosFichero *registros = malloc(sizeof(RegistrosFichero));
+        if (registros == NULL) {
+            escribirEnLog(LOG_ERROR, "file_processor: hilo_trabajador", "Hilo %02d: Error al reservar memoria para los registros de %s\n", id_hilo, nombre_fichero);
+        } else if (copiar_registros(id_hilo, sucursal, archivo_destino, registros) == -1) {
+            // Devuelve -1 en caso de error
+            liberar_registros_fichero(registros);
+        } else {
+            // Copia de los registros correcta
+            registros->id_hilo = id_hilo;
+            snprintf(registros->nombre_fichero, sizeof(registros->nombre_fichero), "%s", nombre_fichero);
+            snprintf(registros->hora_inicio, sizeof(registros->hora_inicio), "%s", horaInicioTexto);
+            snprintf(registros->archivo_procesado, sizeof(registros->archivo_procesado), "%s", archivo_destino);
+            entregar_registros(registros);
         }
+        
+        //Cada proceso simulará el tiempo de servicio del fichero según SIMULATE_MODE (nada con OFF)
+        // El retardo se hace fuera de cualquier bloqueo para no frenar al resto de trabajadores ni a Monitor
+        // Si se está terminando no se simula: sólo retrasaría la salida
+        if (!terminacion_solicitada()) {
+            snprintf(mensaje, sizeof(mensaje), "file_processor: hilo_trabajador: Hilo %02d: ", id_hilo);
+            simulaRetardo(id_hilo, mensaje);
+        }
+    }
+}
 
-        // Comprobar archivos en la carpeta de datos
-        while ((entrada = readdir(dir)) != NULL) {
-            struct stat info;
-            char ruta_archivo[PATH_MAX];
-            char archivo_origen[PATH_MAX];
-            char archivo_origen_corto[PATH_MAX];
-            char archivo_destino[PATH_MAX];
-            char mensaje[100];
-            
-            // Verificar si el nombre del archivo cumple con el patrón del nombre
-            if (strncmp(entrada->d_name, patronNombre, 5) == 0) {
-
-                // Cada vez que llegue un fichero nuevo al directorio, la recepción de este debe mostrarse en pantalla 
-                // y escribirse en el fichero de log. Usar un mensaje creativo basado en * u otro símbolo. 
-                escribirEnLog(LOG_GENERAL, "file_processor: hilo_observador", "%02d:::Iniciando proceso fichero %s\n", id_hilo, entrada->d_name);
-
-                // Registrar hora inicio (se utiliza en el log)
-                horaInicioTexto = obtener_hora_actual();
-
-                // Construir la ruta completa del archivo
-                snprintf(ruta_archivo, sizeof(ruta_archivo), "%s/%s", carpeta_datos, entrada->d_name);
-                
-                // Crear el nombre corto del fichero de origen
-                snprintf(archivo_origen_corto, sizeof(archivo_origen_corto), "%s", entrada->d_name);
-                
-                // Crear el path completo del fichero de origen
-                snprintf(archivo_origen, sizeof(archivo_origen), "%s/%s", carpeta_datos, entrada->d_name);
-
-                // Crear el path completo al fichero destino
-                // Utilizamos (volatile size_t){sizeof(archivo_destino)} para evitar el truncation warning de compilación
-                // (ver https://stackoverflow.com/questions/51534284/how-to-circumvent-format-truncation-warning-in-gcc)
-                snprintf(archivo_destino, (volatile size_t){sizeof(archivo_destino)}, "%s/%s", carpeta_proceso, entrada->d_name);
-
-                // Obtener información sobre el archivo
-                if (stat(ruta_archivo, &info) != 0) {
-                    escribirEnLog(LOG_ERROR, "file_processor: hilo_observador", "Hilo %02d: Error al obtener información del archivo\n", id_hilo);
-                    exit(EXIT_FAILURE);
-                }
+// Función que implementa los hilos trabajadores del pool: sacan ficheros de la cola de trabajo
+// y los consolidan, sea cual sea su sucursal
+void *hilo_trabajador(void *arg) {
+    ContextoObservador contexto;
+    contexto.id_hilo = (int)(intptr_t)arg;
+    const Configuracion *configuracion = obtener_configuracion();
+    contexto.carpeta_datos = configuracion->carpeta_datos;
+    contexto.prefijo_carpeta_procesos = configuracion->prefijo_carpetas_proceso;
+    contexto.prefijo_ficheros = configuracion->prefijo_ficheros;
+
+    escribirEnLog(LOG_INFO, "file_processor: hilo_trabajador", "Hilo trabajador %02d: esperando ficheros en la cola de trabajo\n", contexto.id_hilo);
+
+    // Bucle de procesamiento de ficheros (sólo termina si se reduce el pool o al terminar el programa)
+    TrabajoFichero trabajo;
+    while (desencolar_fichero(&trabajo)) {
+        escribirEnLog(LOG_DEBUG, "file_processor: hilo_trabajador", "Hilo %02d: tomado fichero %s de la cola\n", contexto.id_hilo, trabajo.nombre);
+        procesar_fichero_sucursal(&contexto, &trabajo);
+        liberar_sucursal(trabajo.sucursal);
+    }
 
-                // Verificar si es un archivo regular
-                if (S_ISREG(info.st_mode)) {
-
-                    // Esperar en el semáforo para evitar colisiones
-                    escribirEnLog(LOG_INFO, "file_processor: hilo_observador", "Hilo %02d: esperando semáforo...\n", id_hilo);
-                    sem_wait(semaforo_consolidar_ficheros_entrada);
-
-                    // Comprobar si la carpeta de "en proceso" existe, en caso contrario la creamos
-                    struct stat st = {0};
-                    if (stat(carpeta_proceso, &st) == -1) {
-                        mkdir(carpeta_proceso, 0700);
-                    }
-
-                    // Mover el archivo a la carpeta de "en proceso"
-                    if (mover_archivo(id_hilo, archivo_origen, archivo_destino) == EXIT_SUCCESS) {
-                        // Una vez movido, hay que copiar las líneas al fichero de consolidación
-                        int num_registros;
-                        
-                        num_registros = copiar_registros(id_hilo, sucursal, archivo_destino, archivo_consolidado_completo);
-                        // Devuelve -1 en caso de error
-                        if (num_registros != -1) {
-                            // Copia de los registros correcta
-                            contador_archivos++;
-
-                            // Escribir el log
-                            // Registrar hora final (se utiliza en el log)
-                            horaFinalTexto = obtener_hora_actual();
-                            // Formato: NoPROCESO:::INICIO:::FIN:::NOMBRE_FICHERO:::NoOperacionesConsolidadas 
-                            escribirEnLog(LOG_GENERAL, "file_processor: hilo_observador", "%02d:::%s:::%s:::%s:::%0d\n", id_hilo, horaInicioTexto, horaFinalTexto, archivo_origen_corto, num_registros);
-
-                            // Informar al Monitor
-                            // Utilizamos (volatile size_t){sizeof(mensaje)} para evitar el truncation warning de compilación
-                            // (ver https://stackoverflow.com/questions/51534284/how-to-circumvent-format-truncation-warning-in-gcc)
-                            snprintf(mensaje, (volatile size_t){sizeof(mensaje)}, "file_processor: hilo_observador  %02d: fichero %s consolidado\n", id_hilo, archivo_origen_corto);
-                        }
-                        
-                        //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-                        char mensaje[100];
-                        snprintf(mensaje, sizeof(mensaje), "file_processor: hilo_observador: Hilo %02d: ", id_hilo);
-                        simulaRetardo(mensaje);
-                    }
-
-                    // Liberar el semáforo
-                    sem_post(semaforo_consolidar_ficheros_entrada);
-                    escribirEnLog(LOG_INFO, "file_processor: hilo_observador", "Hilo %02d: liberado semáforo.\n", id_hilo);
-                }
+    escribirEnLog(LOG_INFO, "file_processor: hilo_trabajador", "Hilo trabajador %02d: terminado\n", contexto.id_hilo);
+    return NULL;
+}
+
+// Comparación de nombres de fichero para qsort
+int comparar_nombres_fichero(const void *a, const void *b) {
+    return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+// Función que recorre la carpeta de datos completa y encola los ficheros de las sucursales
+// Se utiliza en el escaneo inicial (ficheros que ya estaban antes de arrancar), en el modo POLLING
+// y cuando se desbordan los eventos de inotify.
+// Los nombres se ordenan antes de encolarlos para respetar la secuencia de ficheros de cada sucursal
+void escanear_carpeta_datos(const char *carpeta_datos, const char *prefijo_ficheros) {
+    DIR *dir;
+    struct dirent *entrada;
+    char **nombres = NULL;
+    int num_nombres = 0;
+    int capacidad_nombres = 0;
+
+    // Abrir la carpeta de datos
+    dir = opendir(carpeta_datos);
+    if (dir == NULL) {
+        perror("Error al abrir el directorio");
+        exit(EXIT_FAILURE);
+    }
+
+    // Comprobar archivos en la carpeta de datos
+    while ((entrada = readdir(dir)) != NULL) {
+        if (obtener_sucursal_fichero(entrada->d_name, prefijo_ficheros) == -1) {
+            continue;
+        }
+        if (num_nombres == capacidad_nombres) {
+            capacidad_nombres = capacidad_nombres == 0 ? 64 : capacidad_nombres * 2;
+            char **nuevos_nombres = realloc(nombres, capacidad_nombres * sizeof(char *));
+            if (nuevos_nombres == NULL) {
+                escribirEnLog(LOG_ERROR, "file_processor: escanear_carpeta_datos", "Error al reservar memoria para los nombres de fichero\n");
+                exit(EXIT_FAILURE);
             }
+            nombres = nuevos_nombres;
+        }
+        nombres[num_nombres++] = strdup(entrada->d_name);
+    }
+
+    // Cerrar la carpeta de datos
+    closedir(dir);
+
+    qsort(nombres, num_nombres, sizeof(char *), comparar_nombres_fichero);
+    for (int i = 0; i < num_nombres; i++) {
+        encolar_fichero(nombres[i], obtener_sucursal_fichero(nombres[i], prefijo_ficheros));
+        free(nombres[i]);
+    }
+    free(nombres);
+}
+
+// Función que implementa el hilo escáner: único productor de la cola de trabajo
+//
+// Con MODO_OBSERVACION=INOTIFY (valor por defecto) el hilo se queda bloqueado en inotify y recibe
+// el nombre de cada fichero en cuanto se termina de escribir (IN_CLOSE_WRITE) o se mueve a la carpeta (IN_MOVED_TO),
+// sin consumir CPU mientras la carpeta está inactiva.
+// Con MODO_OBSERVACION=POLLING (o si inotify no está disponible) se recorre la carpeta una vez por segundo.
+void *hilo_escaner(void *arg) {
+    const char *carpeta_datos;
+    carpeta_datos = obtener_configuracion()->carpeta_datos;
+    const char *prefijo_ficheros;
+    prefijo_ficheros = obtener_configuracion()->prefijo_ficheros;
+
+    escribirEnLog(LOG_INFO, "file_processor: hilo_escaner", "Hilo escáner: observando carpeta %s prefijo de ficheros: %s\n", carpeta_datos, prefijo_ficheros);
+
+    // Preparar la observación por eventos si está configurada
+    int fd_inotify = -1;
+    const char *modo_observacion;
+    modo_observacion = obtener_configuracion()->modo_observacion;
+    if (strcmp(modo_observacion, "POLLING") != 0) {
+        // La vigilancia se registra antes del escaneo inicial para no perder ningún fichero
+        // que llegue mientras se recorre la carpeta
+        fd_inotify = inotify_init1(IN_CLOEXEC);
+        if (fd_inotify != -1 && inotify_add_watch(fd_inotify, carpeta_datos, IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+            close(fd_inotify);
+            fd_inotify = -1;
         }
+        if (fd_inotify == -1) {
+            escribirEnLog(LOG_WARNING, "file_processor: hilo_escaner", "Hilo escáner: inotify no disponible, se utiliza el modo POLLING\n");
+        }
+    }
+
+    // Escaneo inicial: ficheros que ya estaban en la carpeta antes de arrancar
+    escanear_carpeta_datos(carpeta_datos, prefijo_ficheros);
 
-        // Cerrar la carpeta de datos
-        closedir(dir);
+    if (fd_inotify == -1) {
+        // Modo POLLING: bucle infinito para observar la carpeta
+        while (1) {
+            // Dormir por 1 segundo antes de revisar nuevamente
+            sleep(1);
+            escanear_carpeta_datos(carpeta_datos, prefijo_ficheros);
+        }
+    }
+
+    escribirEnLog(LOG_INFO, "file_processor: hilo_escaner", "Hilo escáner: esperando eventos inotify en %s\n", carpeta_datos);
+
+    // Bucle infinito de espera de eventos: read se bloquea hasta que llegue algún fichero
+    // El buffer tiene que estar alineado para poder recorrer las estructuras inotify_event
+    char buffer[TAMANO_BUFFER_EVENTOS] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (1) {
+        ssize_t leidos = read(fd_inotify, buffer, sizeof(buffer));
+        if (leidos <= 0) {
+            if (leidos == -1 && errno == EINTR) {
+                continue;
+            }
+            escribirEnLog(LOG_ERROR, "file_processor: hilo_escaner", "Hilo escáner: error leyendo eventos inotify\n");
+            exit(EXIT_FAILURE);
+        }
 
-        // Dormir por 1 segundo antes de revisar nuevamente
-        sleep(1);
+        // Recorrer todos los eventos recibidos en esta lectura
+        for (char *puntero = buffer; puntero < buffer + leidos; ) {
+            struct inotify_event *evento = (struct inotify_event *)puntero;
+            puntero += sizeof(struct inotify_event) + evento->len;
+
+            if (evento->mask & IN_Q_OVERFLOW) {
+                // Se han perdido eventos: recorrer la carpeta completa
+                escribirEnLog(LOG_WARNING, "file_processor: hilo_escaner", "Hilo escáner: desbordamiento de eventos inotify, recorriendo la carpeta\n");
+                escanear_carpeta_datos(carpeta_datos, prefijo_ficheros);
+            } else if (evento->len > 0) {
+                int sucursal = obtener_sucursal_fichero(evento->name, prefijo_ficheros);
+                if (sucursal != -1) {
+                    escribirEnLog(LOG_DEBUG, "file_processor: hilo_escaner", "Hilo escáner: encolando fichero %s\n", evento->name);
+                    encolar_fichero(evento->name, sucursal);
+                }
+            }
+        }
     }
 
     return NULL;
@@ -710,57 +1335,303 @@ int mover_archivo(int id_hilo, const char *archivo_origen, const char *archivo_d
     return EXIT_SUCCESS;
 }
 
-// Función que copia los registros CSV de un archivo en otro
-// Se utiliza para copiar los registros de los ficheros CSV de las sucursales al 
-// fichero consolidado
-int copiar_registros(int id_hilo, const char *sucursal, const char *archivo_origen, const char *archivo_consolidado) {
-    escribirEnLog(LOG_INFO, "hilo_observacion", "Hilo %02d: Copiando registros CSV de %s a %s\n", id_hilo, archivo_origen, archivo_consolidado);
+// Escribe en fd todos los tramos de vectores (writev) gestionando las escrituras parciales
+// Se envían como mucho IOV_MAX tramos en cada llamada
+// Los tramos se ajustan en una copia, así que vectores queda intacto para poder reintentar la escritura completa
+// Devuelve 0 si todo va bien y -1 en caso de error
+int escribir_vectores(int fd, const struct iovec *vectores, int num_vectores) {
+    struct iovec tramos[IOV_MAX];
+    while (num_vectores > 0) {
+        int num_llamada = (num_vectores > IOV_MAX) ? IOV_MAX : num_vectores;
+        memcpy(tramos, vectores, num_llamada * sizeof(struct iovec));
+        vectores += num_llamada;
+        num_vectores -= num_llamada;
+
+        struct iovec *tramo = tramos;
+        int num_tramos = num_llamada;
+        while (num_tramos > 0) {
+            ssize_t escritos = writev(fd, tramo, num_tramos);
+            if (escritos == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+
+            // Saltar los tramos completos ya escritos y ajustar el tramo que haya quedado a medias
+            while (num_tramos > 0 && escritos >= (ssize_t)tramo->iov_len) {
+                escritos -= tramo->iov_len;
+                tramo++;
+                num_tramos--;
+            }
+            if (num_tramos > 0) {
+                tramo->iov_base = (char *)tramo->iov_base + escritos;
+                tramo->iov_len -= escritos;
+            }
+        }
+    }
+    return 0;
+}
 
-    FILE *archivo_entrada, *archivo_salida;
+// Función que copia los registros CSV de un archivo en otro
+// Se utiliza para preparar los registros de los ficheros CSV de las sucursales antes de añadirlos al
+// fichero consolidado (lo hace el hilo consolidador)
+// El fichero de entrada se proyecta en memoria (mmap) y cada registro se escribirá como dos tramos
+// (prefijo de sucursal + línea original) con writev, sin copiar las líneas a buffers intermedios
+// Devuelve el número de registros o -1 en caso de error
+int copiar_registros(int id_hilo, const char *sucursal, const char *archivo_origen, RegistrosFichero *registros) {
+    escribirEnLog(LOG_INFO, "hilo_observacion", "Hilo %02d: Preparando registros CSV de %s\n", id_hilo, archivo_origen);
+
+    registros->datos = NULL;
+    registros->tamano_datos = 0;
+    registros->vectores = NULL;
+    registros->num_vectores = 0;
+    registros->transacciones = NULL;
+    registros->num_registros = 0;
+    registros->num_bytes = 0;
 
     // Abre el archivo de entrada en modo lectura
-    archivo_entrada = fopen(archivo_origen, "r");
-    if (archivo_entrada == NULL) {
+    int fd_entrada = open(archivo_origen, O_RDONLY);
+    if (fd_entrada == -1) {
         escribirEnLog(LOG_ERROR, "hilo_observacion", "Hilo %02d: Error al abrir el archivo de entrada\n", id_hilo);
         return -1;
     }
 
-    // Abre el archivo de salida en modo anexar (append)
-    archivo_salida = fopen(archivo_consolidado, "a");
-    if (archivo_salida == NULL) {
-        escribirEnLog(LOG_ERROR, "hilo_observacion", "Hilo %02d: Error al abrir el archivo de salida", id_hilo);
-        fclose(archivo_entrada);
+    struct stat info_entrada;
+    if (fstat(fd_entrada, &info_entrada) == -1) {
+        escribirEnLog(LOG_ERROR, "hilo_observacion", "Hilo %02d: Error al obtener el tamaño del archivo de entrada\n", id_hilo);
+        close(fd_entrada);
         return -1;
     }
 
-    // Lee línea por línea del archivo de entrada
-    char linea[MAX_LINE_LENGTH];
-    char linea_escribir[MAX_LINE_LENGTH];
-    int num_registros = 0;
-    while (fgets(linea, MAX_LINE_LENGTH, archivo_entrada) != NULL) {
-        // Escribe la línea leída en el archivo de salida
-        
-        // Primero hay que escribir el número de la sucursal
-        // Utilizamos (volatile size_t){sizeof(linea_escribir)} para evitar el truncation warning de compilación
-        // (ver https://stackoverflow.com/questions/51534284/how-to-circumvent-format-truncation-warning-in-gcc)
-        snprintf(linea_escribir, (volatile size_t){sizeof(linea_escribir)}, "%s;%s",sucursal, linea);
+    // Proyectar el fichero completo en memoria (un fichero vacío no se puede proyectar y no tiene registros)
+    size_t tamano_entrada = info_entrada.st_size;
+    char *datos = NULL;
+    if (tamano_entrada > 0) {
+        datos = mmap(NULL, tamano_entrada, PROT_READ, MAP_PRIVATE, fd_entrada, 0);
+        if (datos == MAP_FAILED) {
+            escribirEnLog(LOG_ERROR, "hilo_observacion", "Hilo %02d: Error al proyectar en memoria el archivo de entrada\n", id_hilo);
+            close(fd_entrada);
+            return -1;
+        }
+        madvise(datos, tamano_entrada, MADV_SEQUENTIAL);
+    }
+    close(fd_entrada);
+    registros->datos = datos;
+    registros->tamano_datos = tamano_entrada;
+
+    // Preparar los tramos de escritura: prefijo de sucursal + línea, que apunta directamente a la proyección
+    // Esta parte se hace sin bloqueos, en paralelo con el resto de trabajadores
+    snprintf(registros->prefijo, sizeof(registros->prefijo), "%s;", sucursal);
+    size_t longitud_prefijo = strlen(registros->prefijo);
+    static char salto_linea[] = "\n";
+
+    int capacidad_vectores = 0;
+    int capacidad_transacciones = 0;
+    size_t posicion = 0;
+    while (posicion < tamano_entrada) {
+        char *inicio = datos + posicion;
+        size_t longitud;
+        int completa;
+        VistaRegistro vista;
+        if (anillo_registros != NULL) {
+            // Separar el registro en campos para publicarlo en el anillo: la misma pasada localiza el final de la línea
+            parsear_registro_csv(inicio, datos + tamano_entrada, CAMPO_OPERACION, &vista);
+            longitud = vista.longitud;
+            completa = vista.completa;
+        } else {
+            char *fin = memchr(inicio, '\n', tamano_entrada - posicion);
+            longitud = (fin != NULL) ? (size_t)(fin - inicio) + 1 : tamano_entrada - posicion;
+            completa = (fin != NULL);
+        }
 
-        fputs(linea_escribir, archivo_salida);
-        num_registros++;
+        // Hasta 3 tramos por registro (el tercero sólo si la última línea no termina en salto de línea)
+        if (registros->num_vectores + 3 > capacidad_vectores) {
+            capacidad_vectores = (capacidad_vectores == 0) ? 4096 : capacidad_vectores * 2;
+            struct iovec *nuevos_vectores = realloc(registros->vectores, capacidad_vectores * sizeof(struct iovec));
+            if (nuevos_vectores == NULL) {
+                escribirEnLog(LOG_ERROR, "hilo_observacion", "Hilo %02d: Error al reservar memoria para los registros\n", id_hilo);
+                return -1;
+            }
+            registros->vectores = nuevos_vectores;
+        }
+        if (anillo_registros != NULL && registros->num_registros == capacidad_transacciones) {
+            capacidad_transacciones = (capacidad_transacciones == 0) ? 1024 : capacidad_transacciones * 2;
+            RegistroTransaccion *nuevas_transacciones = realloc(registros->transacciones, capacidad_transacciones * sizeof(RegistroTransaccion));
+            if (nuevas_transacciones == NULL) {
+                escribirEnLog(LOG_ERROR, "hilo_observacion", "Hilo %02d: Error al reservar memoria para los registros\n", id_hilo);
+                return -1;
+            }
+            registros->transacciones = nuevas_transacciones;
+        }
+        // Registro para el anillo (la posición es relativa al inicio de este fichero)
+        if (anillo_registros != NULL) {
+            RegistroTransaccion *transaccion = &registros->transacciones[registros->num_registros];
+            rellenar_registro_sucursal(sucursal, &vista, transaccion);
+            transaccion->offset_inicio = registros->num_bytes;
+            transaccion->offset_fin = registros->num_bytes + longitud_prefijo + longitud + (completa ? 0 : 1);
+        }
+
+        struct iovec *vector = &registros->vectores[registros->num_vectores];
+        vector[0].iov_base = registros->prefijo;
+        vector[0].iov_len = longitud_prefijo;
+        vector[1].iov_base = inicio;
+        vector[1].iov_len = longitud;
+        registros->num_vectores += 2;
+        registros->num_bytes += longitud_prefijo + longitud;
+        if (!completa) {
+            vector[2].iov_base = salto_linea;
+            vector[2].iov_len = 1;
+            registros->num_vectores++;
+            registros->num_bytes++;
+        }
+
+        posicion += longitud;
+        registros->num_registros++;
     }
-    // Cierra los archivos
-    fclose(archivo_entrada);
-    fclose(archivo_salida);
-    
 
-    escribirEnLog(LOG_INFO, "hilo_observacion", "Hilo %02d: Copiados registros CSV de %s a %s\n", id_hilo, archivo_origen, archivo_consolidado);
+    escribirEnLog(LOG_INFO, "hilo_observacion", "Hilo %02d: Preparados %d registros CSV de %s\n", id_hilo, registros->num_registros, archivo_origen);
+    return registros->num_registros;
+}
+
+// Añade al fichero consolidado los ficheros de un lote con un único bloqueo de escritura y publica sus registros en el anillo
+// Si no se puede abrir el fichero o falla la escritura de un fichero, se quita lo que se haya llegado a escribir
+// de ese fichero (con el bloqueo tomado, así que Monitor no lo ve) y no se sigue con el resto del lote
+// En *consolidados deja la lista de los ficheros añadidos (NULL si ninguno) y devuelve la de los que faltan
+// por añadir (NULL si se han añadido todos)
+RegistrosFichero *anadir_lote_consolidado(const char *archivo_consolidado, RegistrosFichero *lote, RegistrosFichero **consolidados) {
+    *consolidados = NULL;
+
+    // Abre el archivo de salida en modo anexar (append)
+    int fd_salida = open(archivo_consolidado, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd_salida == -1) {
+        escribirEnLog(LOG_ERROR, "file_processor: hilo_consolidador", "Error al abrir el archivo de salida %s (%s)\n", archivo_consolidado, strerror(errno));
+        return lote;
+    }
+
+    // Bloqueo de escritura: Monitor no lee el fichero consolidado mientras se añade el lote
+    bloquear_fichero(fd_salida, F_WRLCK);
+    // Con el bloqueo tomado nadie más añade registros: el final actual es donde empieza el lote
+    off_t offset_lote = lseek(fd_salida, 0, SEEK_END);
+    RegistrosFichero *pendientes = lote;
+    RegistrosFichero *ultimo_consolidado = NULL;
+    if (offset_lote == -1) {
+        escribirEnLog(LOG_ERROR, "file_processor: hilo_consolidador", "Error al obtener el final del archivo de salida %s (%s)\n", archivo_consolidado, strerror(errno));
+    }
+    while (offset_lote != -1 && pendientes != NULL) {
+        RegistrosFichero *registros = pendientes;
+        if (escribir_vectores(fd_salida, registros->vectores, registros->num_vectores) == -1) {
+            escribirEnLog(LOG_ERROR, "file_processor: hilo_consolidador", "Error al escribir en el archivo de salida los registros de %s (%s)\n", registros->nombre_fichero, strerror(errno));
+            // Quitar la parte del fichero que se haya llegado a escribir para no dejar una línea a medias
+            if (ftruncate(fd_salida, offset_lote) == -1) {
+                escribirEnLog(LOG_ERROR, "file_processor: hilo_consolidador", "No se ha podido deshacer la escritura de %s: %s puede tener una línea incompleta (%s)\n", registros->nombre_fichero, archivo_consolidado, strerror(errno));
+            }
+            break;
+        }
+
+        // Publicar los registros en el anillo antes de liberar el bloqueo, con su posición real en el fichero
+        if (anillo_registros != NULL) {
+            for (int i = 0; i < registros->num_registros; i++) {
+                RegistroTransaccion *transaccion = &registros->transacciones[i];
+                transaccion->offset_inicio += offset_lote;
+                transaccion->offset_fin += offset_lote;
+                publicar_registro_anillo(anillo_registros, transaccion);
+            }
+        }
+        offset_lote += registros->num_bytes;
+        ultimo_consolidado = registros;
+        pendientes = registros->siguiente;
+    }
+    bloquear_fichero(fd_salida, F_UNLCK);
+    close(fd_salida);
 
-    // Enviar mensaje a Monitor a través del named pipe
-    snprintf(linea_escribir, (volatile size_t){sizeof(linea_escribir)}, "Fichero consolidado actualizado por FileProcessor Hilo %02d con %01d registros", id_hilo, num_registros);
-    pipe_send(linea_escribir);
-    escribirEnLog(LOG_INFO, "hilo_observacion", "Hilo %02d: Escrito mensaje en pipe: %s\n", id_hilo, linea_escribir);
+    if (ultimo_consolidado != NULL) {
+        ultimo_consolidado->siguiente = NULL;
+        *consolidados = lote;
+    }
+    return pendientes;
+}
 
-    return num_registros;
+// Devuelve a la carpeta de datos los ficheros que no se han podido añadir al fichero consolidado al terminar,
+// para que se vuelvan a procesar en el siguiente arranque, y libera sus recursos
+void devolver_ficheros_entrada(RegistrosFichero *pendientes) {
+    const char *carpeta_datos = obtener_configuracion()->carpeta_datos;
+    while (pendientes != NULL) {
+        RegistrosFichero *siguiente = pendientes->siguiente;
+        char archivo_entrada[PATH_MAX];
+        snprintf(archivo_entrada, (volatile size_t){sizeof(archivo_entrada)}, "%s/%s", carpeta_datos, pendientes->nombre_fichero);
+        if (mover_archivo(pendientes->id_hilo, pendientes->archivo_procesado, archivo_entrada) == EXIT_SUCCESS) {
+            escribirEnLog(LOG_WARNING, "file_processor: hilo_consolidador", "Fichero %s sin consolidar: devuelto a %s para el siguiente arranque\n", pendientes->nombre_fichero, carpeta_datos);
+        } else {
+            escribirEnLog(LOG_ERROR, "file_processor: hilo_consolidador", "Fichero %s sin consolidar: se queda en %s\n", pendientes->nombre_fichero, pendientes->archivo_procesado);
+        }
+        liberar_registros_fichero(pendientes);
+        pendientes = siguiente;
+    }
+}
+
+// Función que implementa el hilo consolidador: añade al fichero consolidado los lotes de ficheros
+// que entregan los trabajadores y avisa a Monitor una vez por lote
+// Termina cuando se cierra la cola de consolidación, después de añadir el último lote
+void *hilo_consolidador(void *arg) {
+    // Preparar la ruta completa del archivo de consolidación
+    char archivo_consolidado[PATH_MAX];
+    snprintf(archivo_consolidado, sizeof(archivo_consolidado), "%s/%s",
+             obtener_configuracion()->carpeta_datos,
+             obtener_configuracion()->fichero_consolidado);
+
+    escribirEnLog(LOG_INFO, "file_processor: hilo_consolidador", "Hilo consolidador: esperando registros en la cola de consolidación\n");
+
+    int segundos_reintento = 0;
+    RegistrosFichero *lote;
+    while ((lote = tomar_lote_consolidacion(segundos_reintento)) != NULL) {
+        RegistrosFichero *consolidados;
+        RegistrosFichero *pendientes = anadir_lote_consolidado(archivo_consolidado, lote, &consolidados);
+
+        // Registrar en el log el fin de cada fichero añadido y liberar sus recursos
+        char *horaFinalTexto = obtener_hora_actual();
+        int num_ficheros = 0;
+        int num_registros = 0;
+        RegistrosFichero *registros = consolidados;
+        while (registros != NULL) {
+            RegistrosFichero *siguiente = registros->siguiente;
+            // Formato: NoPROCESO:::INICIO:::FIN:::NOMBRE_FICHERO:::NoOperacionesConsolidadas
+            escribirEnLog(LOG_GENERAL, "file_processor: hilo_trabajador", "%02d:::%s:::%s:::%s:::%0d\n", registros->id_hilo, registros->hora_inicio, horaFinalTexto, registros->nombre_fichero, registros->num_registros);
+            num_ficheros++;
+            num_registros += registros->num_registros;
+            liberar_registros_fichero(registros);
+            registros = siguiente;
+        }
+
+        // Los ficheros que faltan vuelven al principio de la cola y se reintentan tras una pausa, cada vez
+        // más larga mientras siga fallando; si se está terminando, vuelven a la carpeta de datos
+        if (pendientes != NULL && cola_consolidacion_cerrada()) {
+            devolver_ficheros_entrada(pendientes);
+        } else if (pendientes != NULL) {
+            segundos_reintento = (segundos_reintento == 0) ? 1 : segundos_reintento * 2;
+            if (segundos_reintento > MAX_SEGUNDOS_REINTENTO_CONSOLIDACION) {
+                segundos_reintento = MAX_SEGUNDOS_REINTENTO_CONSOLIDACION;
+            }
+            escribirEnLog(LOG_WARNING, "file_processor: hilo_consolidador", "No se han podido añadir los registros de %s y siguientes: se reintentará dentro de %d s\n", pendientes->nombre_fichero, segundos_reintento);
+            reencolar_registros(pendientes);
+        } else {
+            segundos_reintento = 0;
+        }
+
+        if (num_ficheros == 0) {
+            continue;
+        }
+        escribirEnLog(LOG_INFO, "file_processor: hilo_consolidador", "Consolidado lote de %d ficheros con %d registros en %s\n", num_ficheros, num_registros, archivo_consolidado);
+
+        // Enviar un único mensaje a Monitor a través del named pipe por cada lote
+        char linea_escribir[MAX_LINE_LENGTH];
+        snprintf(linea_escribir, sizeof(linea_escribir), "Fichero consolidado actualizado por FileProcessor con %d registros de %d ficheros", num_registros, num_ficheros);
+        pipe_send(linea_escribir);
+        escribirEnLog(LOG_INFO, "file_processor: hilo_consolidador", "Escrito mensaje en pipe: %s\n", linea_escribir);
+    }
+
+    avisarConsolidadorTerminado();
+    return NULL;
 }
 
 //-------------------------------------------------------------------------------------------------------------------------------
@@ -842,18 +1713,20 @@ int procesarParametrosLlamada(int argc, char *argv[]) {
 }
 
 
-// Función de manejador de señal CTRL-C
+// Función que termina el programa al recibir una señal de terminación (CTRL-C o SIGTERM)
+// Se llama desde main, que espera las señales con sigwaitinfo, no desde un manejador de señal
+// Antes de salir deja de admitir ficheros, espera a los trabajadores, añade al fichero consolidado todo lo
+// que ya se ha movido a procesados y da un plazo para que lleguen a Monitor los últimos avisos
 void ctrlc_handler(int sig) {
-    printf("file_processor: Se ha presionado CTRL-C. Terminando la ejecución.\n");
-    escribirEnLog(LOG_INFO, "file_processor: ctrlc_handler", "Se ha pulsado CTRL-C\n");
-
-    // Acciones que hay que realizar al terminar el programa
-    // Cerrar el semáforo
-    sem_close(semaforo_consolidar_ficheros_entrada);
-    // Borrar el semáforo
-    sem_unlink(semName);
-    
-    escribirEnLog(LOG_INFO, "file_processor: ctrlc_handler", "Semáforo semaforo_consolidar_ficheros_entrada cerrado y borrado\n");
+    printf("file_processor: Se ha recibido la señal %s. Terminando la ejecución.\n", (sig == SIGINT) ? "CTRL-C" : "SIGTERM");
+    escribirEnLog(LOG_INFO, "file_processor: ctrlc_handler", "Se ha recibido la señal %d\n", sig);
+
+    solicitarTerminacionTrabajadores();
+    solicitarTerminacionConsolidador();
+    if (!vaciar_canal_monitor(SEGUNDOS_VACIAR_CANAL_MONITOR)) {
+        escribirEnLog(LOG_WARNING, "file_processor: ctrlc_handler", "No se han podido enviar a Monitor los últimos avisos\n");
+    }
+
     escribirEnLog(LOG_INFO, "file_processor: ctrlc_handler", "Proceso terminado\n");
 
     // Fin del programa
@@ -863,6 +1736,19 @@ void ctrlc_handler(int sig) {
 // Función main
 int main(int argc, char *argv[]) //argc es el contador de parámetros y argv es el valor de estos parámetros
 {
+    // Leer el fichero de configuración (antes que nada: el log también depende de él)
+    cargar_configuracion(FICHERO_CONFIGURACION);
+
+    // Las señales de terminación (CTRL-C y SIGTERM) y la de recarga de la configuración (SIGHUP) se bloquean
+    // antes de crear ningún hilo, para que ninguno las reciba de forma asíncrona: main espera las de
+    // terminación con sigwaitinfo y hilo_configuracion atiende SIGHUP a través de un signalfd
+    sigset_t senales;
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGINT);
+    sigaddset(&senales, SIGTERM);
+    sigaddset(&senales, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &senales, NULL);
+
     // Procesar parámetros de llamada
     if (procesarParametrosLlamada(argc, argv) == 1) {
         // Ha habido un error con los parámetros
@@ -873,37 +1759,35 @@ int main(int argc, char *argv[]) //argc es el contador de parámetros y argv es
     // Escritura en log de inicio de ejecución
     escribirEnLog(LOG_GENERAL, "file_processor: main", "Iniciando ejecución FileProcessor\n");
 
-    // Registra el manejador de señal para SIGINT para CTRL-C
-    if (signal(SIGINT, ctrlc_handler) == SIG_ERR) {
-        escribirEnLog(LOG_ERROR, "file_processor: main", "No se pudo capturar SIGINT\n");
-        return EXIT_FAILURE;
-    }
-
+    // Canal persistente con Monitor a través del named pipe
+    iniciar_canal_monitor();
 
-    // Vamos a crear un semáforo con un nombre común para file procesor y monitor de forma que podamos utilizarlo
-    // para asegurar el acceso a recursos comunes desde ambos procesos. 
-    // Creamos un semáforo de 1 recursos con nombre definido en SEMAPHOR_NAME y permisos de lectura y escritura
-    semName = obtener_valor_configuracion("SEMAPHORE_NAME", "/semaforo");
-    semaforo_consolidar_ficheros_entrada = sem_open(semName, O_CREAT , 0644, 1);
-    if (semaforo_consolidar_ficheros_entrada == SEM_FAILED){
-        perror("semaforo");
-        escribirEnLog(LOG_ERROR, "file_processor: main", "Error al abrir el semáforo\n");
-        exit(EXIT_FAILURE);
-    }
-    escribirEnLog(LOG_INFO, "file_processor:main", "Semáforo %s creado\n", semName);
+    // Anillo de memoria compartida en el que se publican los registros consolidados para Monitor
+    iniciar_anillo_registros();
 
     //Creación de los hilos de observación de ficheros de las sucursales
     crear_hilos_observacion();
+
+    // Recarga de la configuración con SIGHUP o al guardar el fichero
+    iniciar_recarga_configuracion();
     
     //Bucle infinito para que el proceso sea un demonio
     escribirEnLog(LOG_INFO, "file_processor: main", "Entrando en ejecucion indefinida\n");
 
-    while (1){
-        sleep(10); //Solo para evitar que el main salga y se consuma mucha CPU
+    // main queda bloqueado hasta que llega CTRL-C o SIGTERM: sin señales no consume CPU
+    sigset_t senales_terminacion;
+    sigemptyset(&senales_terminacion);
+    sigaddset(&senales_terminacion, SIGINT);
+    sigaddset(&senales_terminacion, SIGTERM);
+    while (1) {
+        int senal = sigwaitinfo(&senales_terminacion, NULL);
+        if (senal == SIGINT || senal == SIGTERM) {
+            ctrlc_handler(senal);
+        }
     }
 
     // Código inaccesible, el programa lo acabará le usuario con CTRL+C 
-    // de forma que los semáforos y recursos se liberarán en el manejador
+    // de forma que los recursos se liberarán en ctrlc_handler
     return 0;
 
 }
@@ -7,14 +7,55 @@ FileProcessor.h
 // Para evitar que se puedan llegar a declarar  las funciones varias veces
 #pragma once
 
-void *hilo_observador(void *arg);
+void *hilo_escaner(void *arg);
+void *hilo_trabajador(void *arg);
+struct CONTEXTO_OBSERVADOR;
+struct TRABAJO_FICHERO;
+void procesar_fichero_sucursal(struct CONTEXTO_OBSERVADOR *contexto, const struct TRABAJO_FICHERO *trabajo);
+void escanear_carpeta_datos(const char *carpeta_datos, const char *prefijo_ficheros);
+void iniciar_cola_trabajo(int capacidad, int orden_por_sucursal);
+void ajustar_cola_trabajo(int capacidad, int orden_por_sucursal);
+void encolar_fichero(const char *nombre, int sucursal);
+int desencolar_fichero(struct TRABAJO_FICHERO *trabajo);
+void liberar_sucursal(int sucursal);
+int terminacion_solicitada();
+void solicitarTerminacionTrabajadores();
+int obtener_sucursal_fichero(const char *nombre_fichero, const char *prefijo_ficheros);
 int mover_archivo(int id_hilo, const char *archivo_origen, const char *archivo_destino);
-int copiar_registros(int id_hilo, const char *sucursal, const char *archivo_origen, const char *archivo_consolidado);
+struct iovec;
+struct REGISTRO_TRANSACCION;
+struct VISTA_REGISTRO;
+void rellenar_registro_sucursal(const char *sucursal, const struct VISTA_REGISTRO *vista, struct REGISTRO_TRANSACCION *registro);
+void iniciar_anillo_registros();
+struct REGISTROS_FICHERO;
+int escribir_vectores(int fd, const struct iovec *vectores, int num_vectores);
+void iniciar_cola_consolidacion(int ventana_ms, int max_ficheros, size_t max_bytes);
+void ajustar_cola_consolidacion(int ventana_ms, int max_ficheros, size_t max_bytes);
+void liberar_registros_fichero(struct REGISTROS_FICHERO *registros);
+void entregar_registros(struct REGISTROS_FICHERO *registros);
+void reencolar_registros(struct REGISTROS_FICHERO *pendientes);
+struct REGISTROS_FICHERO *tomar_lote_consolidacion(int segundos_reintento);
+int cola_consolidacion_cerrada();
+void solicitarTerminacionConsolidador();
+void avisarConsolidadorTerminado();
+int copiar_registros(int id_hilo, const char *sucursal, const char *archivo_origen, struct REGISTROS_FICHERO *registros);
+struct REGISTROS_FICHERO *anadir_lote_consolidado(const char *archivo_consolidado, struct REGISTROS_FICHERO *lote, struct REGISTROS_FICHERO **consolidados);
+void devolver_ficheros_entrada(struct REGISTROS_FICHERO *pendientes);
+void *hilo_consolidador(void *arg);
+struct CONFIGURACION;
+int calcular_num_trabajadores(const struct CONFIGURACION *configuracion);
+void ajustar_pool_trabajadores(int num_hilos);
+void crear_hilos_observacion();
+void aplicar_configuracion(const struct CONFIGURACION *configuracion);
+void *hilo_configuracion(void *arg);
+void iniciar_recarga_configuracion();
 void imprimirUso();
 int procesarParametrosLlamada(int argc, char *argv[]);
+int abrir_canal_monitor(const char *pipeName);
+void *hilo_canal_monitor(void *arg);
+void iniciar_canal_monitor();
 int pipe_send(const char *message);
-void simulaRetardo(const char *mensaje);
-void sleep_centiseconds(int n);
+int vaciar_canal_monitor(int segundos);
 void obtenerFechaHora2(char * fechaHora2);
 void obtenerFechaHora(char * fechaHora);
 char * obtener_hora_actual();
@@ -0,0 +1,752 @@
+/**
+GeneradorTransacciones.c
+
+    Funcionalidad:
+        Genera ficheros de transacciones de las sucursales (SUxxx_OPExxx_ddmmyyyy_nnn.csv) con el mismo formato
+        que genera_ficheros_prueba.sh, pero sin lanzar procesos por cada línea: las líneas se componen en un
+        buffer en memoria y se escriben por bloques, así que se pueden preparar millones de registros en
+        segundos para las pruebas de carga.
+
+        Todo se obtiene de un generador de números aleatorios (splitmix64) que se inicia a partir de la semilla
+        y de la sucursal, el tipo de operación y el número de fichero: con la misma semilla, fecha y parámetros
+        se obtienen exactamente los mismos ficheros, y cada fichero sale igual aunque se generen más o menos
+        sucursales, tipos de operación o ficheros.
+
+        Además de las transacciones normales, inyecta casos de cada uno de los cinco patrones de fraude con la
+        frecuencia indicada (casos por cada 1000 líneas). Cada caso usa un usuario propio formado por la sucursal,
+        el tipo de operación y el número del fichero y el número del caso dentro del fichero (F00100200300001,
+        F00100200300002...) y está preparado para que sólo cumpla su patrón. Los casos inyectados se anotan en un
+        manifiesto (FICHERO;RESULTADO) en el que RESULTADO es la línea que Monitor debe escribir en el fichero
+        resultado del patrón. Las transacciones normales también pueden cumplir patrones (sobre todo el 3 y
+        el 5): ésas no están en el manifiesto.
+
+        Cada fichero se escribe con un nombre temporal oculto y después se renombra, para que FileProcessor
+        no lo lea a medias.
+
+    Compilación:
+        gcc GeneradorTransacciones.c -o GeneradorTransacciones -O2 -lm
+
+    Ejecución:
+        ./GeneradorTransacciones
+        ./GeneradorTransacciones -s 5 -o 2 -f 10 -l 100000 --semilla 7 --fraude 1:0.5 --fraude 5:2
+        ./GeneradorTransacciones --sucursales 3 --lineas 20 --path ../Datos/ --manifiesto ../Datos/manifiesto.csv
+
+    Parámetros (y valores por defecto):
+        -l  / --lineas <número de líneas normales de cada fichero> (20)
+        -s  / --sucursales <número de sucursales> (3)
+        -o  / --operaciones <número de tipos de operación> (4)
+        -f  / --ficheros <número de ficheros por sucursal y tipo de operación> (3)
+        -p  / --path <carpeta en la que se dejan los ficheros> (../Datos/)
+        -up / --usernamePrefix <prefijo de los usuarios> (USER)
+        -uf / --userFrom <desde usuario número> (100)
+        -ut / --userTo <hasta usuario número> (200)
+        -S  / --semilla <semilla> (1)
+        -d  / --fecha <ddmmyyyy> (hoy)
+        -e  / --estados <% Finalizado,% Correcto,% Error> (70,20,10)
+        -im / --importeMinimo <importe> (-250)
+        -iM / --importeMaximo <importe> (250)
+        -di / --distribucionImporte UNIFORME|NORMAL (UNIFORME; NORMAL: media en el centro y 1/6 del rango de desviación)
+        -fr / --fraude <patrón>:<casos por cada 1000 líneas> (se puede repetir; por defecto 0 para todos)
+        -m  / --manifiesto <fichero del manifiesto> (<path>manifiesto_fraude.csv)
+*/
+
+// Necesario para M_PI
+#define _GNU_SOURCE
+
+// Número de patrones de fraude
+#define NUM_PATRONES_FRAUDE 5
+
+// Tamaño del buffer de escritura de cada fichero
+#define TAMANO_BUFFER_ESCRITURA (1 << 20)
+
+// Espacio que se deja libre al final del buffer: una línea nunca ocupa más
+#define MAX_LONGITUD_LINEA 256
+
+// Importe máximo de las transacciones de los casos de fraude
+#define IMPORTE_MAXIMO_FRAUDE 250
+
+// Prefijo de los usuarios de los casos de fraude
+// El usuario completo (prefijo, sucursal, tipo de operación, fichero y caso) ocupa 15 caracteres, lo máximo
+// que admite el campo usuario de FileProcessor y Monitor
+#define PREFIJO_USUARIO_FRAUDE "F"
+
+// Dígitos del número de caso en el usuario de fraude y número máximo de casos de un fichero
+#define DIGITOS_CASO_FRAUDE 5
+#define MAX_CASOS_FRAUDE_FICHERO 99999
+
+// ------------------------------------------------------------------
+// Librerías necesarias y explicación
+// ------------------------------------------------------------------
+#pragma region Librerias
+#include <stdio.h>          // Funciones estándar de entrada y salida
+#include <stdlib.h>         // Funciones útiles para varias operaciones: strtoll, malloc, qsort...
+#include <string.h>         // Tratamiento de cadenas de caracteres
+#include <stdint.h>         // Enteros de tamaño fijo
+#include <time.h>           // Fecha por defecto y medida del tiempo
+#include <math.h>           // log, sqrt, cos (distribución normal de los importes)
+#include <unistd.h>         // write, close
+#include <fcntl.h>          // open
+#include <errno.h>          // errno
+#include <linux/limits.h>   // PATH_MAX
+
+#include "GeneradorTransacciones.h"  // Declaración de funciones de este módulo
+#pragma endregion Librerias
+
+
+// ------------------------------------------------------------------
+// PARÁMETROS DE LA GENERACIÓN
+// ------------------------------------------------------------------
+#pragma region Parametros
+
+// Estados de las transacciones
+enum { ESTADO_FINALIZADO, ESTADO_CORRECTO, ESTADO_ERROR };
+static const char *textos_estado[] = {"Finalizado", "Correcto", "Error"};
+
+// Distribución de los importes de las transacciones normales
+typedef enum DISTRIBUCION_IMPORTE {
+    IMPORTE_UNIFORME,
+    IMPORTE_NORMAL
+} DistribucionImporte;
+
+// Parámetros de la llamada
+typedef struct PARAMETROS_GENERADOR {
+    int64_t num_lineas;
+    int num_sucursales;
+    int num_operaciones;
+    int num_ficheros;
+    char path[PATH_MAX];
+    const char *prefijo_usuario;
+    uint64_t usuario_desde;
+    uint64_t usuario_hasta;
+    uint64_t semilla;
+    int dia, mes, anio;
+    int porcentaje_estados[3];      // Finalizado, Correcto, Error
+    int64_t importe_minimo;
+    int64_t importe_maximo;
+    DistribucionImporte distribucion_importe;
+    double tasa_fraude[NUM_PATRONES_FRAUDE + 1];   // Casos por cada 1000 líneas (índice = patrón)
+    char manifiesto[PATH_MAX + 32];
+} ParametrosGenerador;
+
+ParametrosGenerador parametros = {
+    .num_lineas = 20,
+    .num_sucursales = 3,
+    .num_operaciones = 4,
+    .num_ficheros = 3,
+    .path = "../Datos/",
+    .prefijo_usuario = "USER",
+    .usuario_desde = 100,
+    .usuario_hasta = 200,
+    .semilla = 1,
+    .porcentaje_estados = {70, 20, 10},
+    .importe_minimo = -250,
+    .importe_maximo = 250,
+    .distribucion_importe = IMPORTE_UNIFORME,
+};
+
+// Manifiesto de los casos de fraude inyectados
+FILE *fichero_manifiesto = NULL;
+
+// Totales para el resumen final
+uint64_t total_lineas = 0;
+uint64_t total_bytes = 0;
+uint64_t total_casos[NUM_PATRONES_FRAUDE + 1];
+
+#pragma endregion Parametros
+
+
+// ------------------------------------------------------------------
+// GENERADOR DE NÚMEROS ALEATORIOS
+// ------------------------------------------------------------------
+#pragma region Aleatorios
+
+// Siguiente número aleatorio (splitmix64)
+uint64_t siguiente_aleatorio(uint64_t *estado) {
+    uint64_t valor = (*estado += UINT64_C(0x9e3779b97f4a7c15));
+    valor = (valor ^ (valor >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    valor = (valor ^ (valor >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return valor ^ (valor >> 31);
+}
+
+// Número aleatorio entre minimo y maximo (ambos incluidos)
+// Se multiplica en lugar de usar el resto, que es más lento (el sesgo es despreciable)
+uint64_t aleatorio_rango(uint64_t *estado, uint64_t minimo, uint64_t maximo) {
+    uint64_t rango = maximo - minimo + 1;
+    return minimo + (uint64_t)(((unsigned __int128)siguiente_aleatorio(estado) * rango) >> 64);
+}
+
+// Número aleatorio uniforme en (0, 1]
+double aleatorio_unidad(uint64_t *estado) {
+    return ((siguiente_aleatorio(estado) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+#pragma endregion Aleatorios
+
+
+// ------------------------------------------------------------------
+// ESCRITURA DE LOS FICHEROS
+// ------------------------------------------------------------------
+#pragma region Escritura
+
+// Estado de la generación de un fichero
+typedef struct GENERADOR {
+    uint64_t aleatorio;             // Estado del generador de números aleatorios del fichero
+    int fd;
+    char *buffer;
+    size_t usados;
+    int error;                      // 1 si ha fallado alguna escritura
+    uint64_t operacion;             // Número de la siguiente operación (OPExxxx)
+    char prefijo_fraude[16];        // Prefijo de los usuarios de fraude del fichero: F + sucursal, operación y fichero
+    uint64_t ultimo_caso_fraude;    // Número del último caso de fraude del fichero (cada caso tiene su usuario)
+    char fecha[11];                 // dd/mm/yyyy
+    const char *nombre_fichero;     // Para el manifiesto
+} Generador;
+
+// Escribe en el fichero lo que hay en el buffer
+void vaciar_buffer(Generador *generador) {
+    size_t escritos = 0;
+    while (escritos < generador->usados && !generador->error) {
+        ssize_t resultado = write(generador->fd, generador->buffer + escritos, generador->usados - escritos);
+        if (resultado == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            generador->error = 1;
+            break;
+        }
+        escritos += resultado;
+    }
+    total_bytes += generador->usados;
+    generador->usados = 0;
+}
+
+void anadir_texto(Generador *generador, const char *texto, size_t longitud) {
+    memcpy(generador->buffer + generador->usados, texto, longitud);
+    generador->usados += longitud;
+}
+
+// Añade un entero en decimal con al menos digitos_minimos cifras (completando con ceros)
+void anadir_entero(Generador *generador, int64_t valor, int digitos_minimos) {
+    char cifras[24];
+    int num_cifras = 0;
+    uint64_t absoluto = (valor < 0) ? -(uint64_t)valor : (uint64_t)valor;
+    do {
+        cifras[num_cifras++] = '0' + absoluto % 10;
+        absoluto /= 10;
+    } while (absoluto > 0);
+    while (num_cifras < digitos_minimos) {
+        cifras[num_cifras++] = '0';
+    }
+    char *destino = generador->buffer + generador->usados;
+    if (valor < 0) {
+        *destino++ = '-';
+    }
+    for (int i = num_cifras - 1; i >= 0; i--) {
+        *destino++ = cifras[i];
+    }
+    generador->usados = destino - generador->buffer;
+}
+
+// Añade la fecha del fichero y la hora (dd/mm/yyyy HH:MM:00) de un minuto del día
+void anadir_fecha_hora(Generador *generador, int minuto_dia) {
+    char *destino = generador->buffer + generador->usados;
+    memcpy(destino, generador->fecha, 10);
+    destino[10] = ' ';
+    destino[11] = '0' + minuto_dia / 600;
+    destino[12] = '0' + (minuto_dia / 60) % 10;
+    destino[13] = ':';
+    destino[14] = '0' + (minuto_dia % 60) / 10;
+    destino[15] = '0' + minuto_dia % 10;
+    memcpy(destino + 16, ":00", 3);
+    generador->usados += 19;
+}
+
+// Escribe una transacción con el formato de los ficheros de las sucursales:
+// OPExxxx;FechaInicio;FechaFin;Usuario;TipoOperacion1;TipoOperacion2;Importe €;Estado
+// La fecha-hora de fin está entre 0 y 59 minutos después de la de inicio (dentro del mismo día)
+void escribir_linea(Generador *generador, const char *prefijo_usuario, uint64_t numero_usuario, int digitos_usuario,
+                    int minuto_inicio, int tipo_operacion1, int tipo_operacion2, int64_t importe, int estado) {
+    int minuto_fin = minuto_inicio + (int)aleatorio_rango(&generador->aleatorio, 0, 59);
+    if (minuto_fin > 24 * 60 - 1) {
+        minuto_fin = 24 * 60 - 1;
+    }
+
+    anadir_texto(generador, "OPE", 3);
+    anadir_entero(generador, generador->operacion++, 4);
+    anadir_texto(generador, ";", 1);
+    anadir_fecha_hora(generador, minuto_inicio);
+    anadir_texto(generador, ";", 1);
+    anadir_fecha_hora(generador, minuto_fin);
+    anadir_texto(generador, ";", 1);
+    anadir_texto(generador, prefijo_usuario, strlen(prefijo_usuario));
+    anadir_entero(generador, numero_usuario, digitos_usuario);
+    anadir_texto(generador, ";COMPRA0", 8);
+    anadir_entero(generador, tipo_operacion1, 1);
+    anadir_texto(generador, ";", 1);
+    anadir_entero(generador, tipo_operacion2, 1);
+    anadir_texto(generador, ";", 1);
+    anadir_entero(generador, importe, 1);
+    anadir_texto(generador, " €;", strlen(" €;"));
+    anadir_texto(generador, textos_estado[estado], strlen(textos_estado[estado]));
+    anadir_texto(generador, "\n", 1);
+
+    total_lineas++;
+    if (generador->usados > TAMANO_BUFFER_ESCRITURA - MAX_LONGITUD_LINEA) {
+        vaciar_buffer(generador);
+    }
+}
+
+#pragma endregion Escritura
+
+
+// ------------------------------------------------------------------
+// TRANSACCIONES NORMALES
+// ------------------------------------------------------------------
+#pragma region TransaccionesNormales
+
+// Importe de una transacción normal según la distribución elegida
+int64_t generar_importe(Generador *generador) {
+    if (parametros.distribucion_importe == IMPORTE_NORMAL) {
+        // Box-Muller: media en el centro del rango y el rango son 6 desviaciones
+        double media = (parametros.importe_minimo + parametros.importe_maximo) / 2.0;
+        double desviacion = (parametros.importe_maximo - parametros.importe_minimo) / 6.0;
+        double normal = sqrt(-2.0 * log(aleatorio_unidad(&generador->aleatorio))) * cos(2.0 * M_PI * aleatorio_unidad(&generador->aleatorio));
+        int64_t importe = (int64_t)llround(media + desviacion * normal);
+        if (importe < parametros.importe_minimo) {
+            importe = parametros.importe_minimo;
+        } else if (importe > parametros.importe_maximo) {
+            importe = parametros.importe_maximo;
+        }
+        return importe;
+    }
+    return parametros.importe_minimo + (int64_t)aleatorio_rango(&generador->aleatorio, 0, parametros.importe_maximo - parametros.importe_minimo);
+}
+
+// Estado de una transacción normal según los porcentajes elegidos
+int generar_estado(Generador *generador) {
+    int total = parametros.porcentaje_estados[0] + parametros.porcentaje_estados[1] + parametros.porcentaje_estados[2];
+    int valor = (int)aleatorio_rango(&generador->aleatorio, 0, total - 1);
+    if (valor < parametros.porcentaje_estados[0]) {
+        return ESTADO_FINALIZADO;
+    }
+    if (valor < parametros.porcentaje_estados[0] + parametros.porcentaje_estados[1]) {
+        return ESTADO_CORRECTO;
+    }
+    return ESTADO_ERROR;
+}
+
+// Transacción de un usuario cualquiera (como genera_transacciones.sh)
+void generar_linea_normal(Generador *generador) {
+    uint64_t usuario = aleatorio_rango(&generador->aleatorio, parametros.usuario_desde, parametros.usuario_hasta);
+    int minuto_inicio = (int)aleatorio_rango(&generador->aleatorio, 0, 24 * 60 - 1);
+    int tipo_operacion1 = (int)aleatorio_rango(&generador->aleatorio, 1, 2);
+    int tipo_operacion2 = (int)aleatorio_rango(&generador->aleatorio, 1, 2);
+    int64_t importe = generar_importe(generador);
+    escribir_linea(generador, parametros.prefijo_usuario, usuario, 0, minuto_inicio, tipo_operacion1, tipo_operacion2, importe, generar_estado(generador));
+}
+
+#pragma endregion TransaccionesNormales
+
+
+// ------------------------------------------------------------------
+// CASOS DE FRAUDE
+// ------------------------------------------------------------------
+#pragma region CasosFraude
+/*
+    Cada caso usa un usuario nuevo y sólo cumple su patrón (mismos criterios que Monitor.c):
+        Patrón 1: 6 transacciones en menos de una hora, con importes positivos
+        Patrón 2: 4 retiradas a la misma hora:minuto:segundo y un ingreso que las compensa (saldo 0)
+        Patrón 3: 4 transacciones con error en el día, con importes positivos
+        Patrón 4: 4 transacciones sin error con tipo de operación 2 = 1, 2, 3 y 4, con importes positivos
+        Patrón 5: un ingreso y una retirada mayor (saldo negativo)
+    Las transacciones de un caso se escriben seguidas y en orden de hora. En el manifiesto se anota, por cada
+    caso, el fichero y la línea que Monitor debe escribir en el fichero resultado del patrón
+*/
+
+// Caso de fraude que se inyecta en un fichero, antes de la línea normal número posicion
+typedef struct CASO_FRAUDE {
+    int64_t posicion;
+    int patron;
+} CasoFraude;
+
+// Escribe la línea del manifiesto de un caso: FICHERO;RESULTADO
+static void anotar_caso_fraude(const Generador *generador, int patron, uint64_t usuario, const char *clave_hora, const char *detalle) {
+    fprintf(fichero_manifiesto, "%s;%02d:::Registro fraude patrón %d:::Clave=%s%0*llu@%s%s:::%s\n", generador->nombre_fichero,
+            patron, patron, generador->prefijo_fraude, DIGITOS_CASO_FRAUDE, (unsigned long long)usuario, generador->fecha, clave_hora, detalle);
+    total_casos[patron]++;
+}
+
+// Importe positivo de una transacción de un caso de fraude
+static inline int64_t importe_fraude(Generador *generador) {
+    return (int64_t)aleatorio_rango(&generador->aleatorio, 1, IMPORTE_MAXIMO_FRAUDE);
+}
+
+void generar_caso_fraude(Generador *generador, int patron) {
+    uint64_t usuario = ++generador->ultimo_caso_fraude;
+    uint64_t *aleatorio = &generador->aleatorio;
+    char clave_hora[16] = "";
+    char detalle[64];
+    int minutos[6];
+
+    switch (patron) {
+        case 1: {
+            // La primera a la hora de comienzo y las demás en los 50 minutos siguientes, en orden
+            minutos[0] = (int)aleatorio_rango(aleatorio, 0, 24 * 60 - 60);
+            for (int i = 1; i < 6; i++) {
+                int minuto = minutos[0] + (int)aleatorio_rango(aleatorio, 0, 50);
+                int j = i;
+                while (j > 1 && minutos[j - 1] > minuto) {
+                    minutos[j] = minutos[j - 1];
+                    j--;
+                }
+                minutos[j] = minuto;
+            }
+            for (int i = 0; i < 6; i++) {
+                escribir_linea(generador, generador->prefijo_fraude, usuario, DIGITOS_CASO_FRAUDE, minutos[i], (int)aleatorio_rango(aleatorio, 1, 2),
+                               (int)aleatorio_rango(aleatorio, 1, 2), importe_fraude(generador), ESTADO_FINALIZADO);
+            }
+            snprintf(clave_hora, sizeof(clave_hora), " %02d:%02d:00", minutos[0] / 60, minutos[0] % 60);
+            snprintf(detalle, sizeof(detalle), "Registros en la Misma Hora=6");
+            break;
+        }
+
+        case 2: {
+            int minuto = (int)aleatorio_rango(aleatorio, 0, 24 * 60 - 60);
+            int64_t retirado = 0;
+            for (int i = 0; i < 4; i++) {
+                int64_t importe = importe_fraude(generador);
+                retirado += importe;
+                escribir_linea(generador, generador->prefijo_fraude, usuario, DIGITOS_CASO_FRAUDE, minuto, (int)aleatorio_rango(aleatorio, 1, 2),
+                               (int)aleatorio_rango(aleatorio, 1, 2), -importe, ESTADO_FINALIZADO);
+            }
+            escribir_linea(generador, generador->prefijo_fraude, usuario, DIGITOS_CASO_FRAUDE, minuto + (int)aleatorio_rango(aleatorio, 1, 59),
+                           (int)aleatorio_rango(aleatorio, 1, 2), (int)aleatorio_rango(aleatorio, 1, 2), retirado, ESTADO_FINALIZADO);
+            snprintf(clave_hora, sizeof(clave_hora), " %02d:%02d:00", minuto / 60, minuto % 60);
+            snprintf(detalle, sizeof(detalle), "Registros a la vez=4");
+            break;
+        }
+
+        case 3:
+        case 4:
+            // Una transacción en cada cuarto del día: nunca hay más de una en la misma hora
+            for (int i = 0; i < 4; i++) {
+                int minuto = i * 360 + (int)aleatorio_rango(aleatorio, 0, 359);
+                int tipo_operacion2 = (patron == 4) ? i + 1 : (int)aleatorio_rango(aleatorio, 1, 2);
+                int estado = (patron == 3) ? ESTADO_ERROR : ESTADO_FINALIZADO;
+                escribir_linea(generador, generador->prefijo_fraude, usuario, DIGITOS_CASO_FRAUDE, minuto, (int)aleatorio_rango(aleatorio, 1, 2),
+                               tipo_operacion2, importe_fraude(generador), estado);
+            }
+            snprintf(detalle, sizeof(detalle), (patron == 3) ? "Registros con Error=4" : "Registros con Todos los Tipos de Operaciones");
+            break;
+
+        case 5: {
+            int64_t ingresado = importe_fraude(generador);
+            int64_t retirado = ingresado + importe_fraude(generador);
+            int minuto = (int)aleatorio_rango(aleatorio, 0, 12 * 60 - 1);
+            escribir_linea(generador, generador->prefijo_fraude, usuario, DIGITOS_CASO_FRAUDE, minuto, (int)aleatorio_rango(aleatorio, 1, 2),
+                           (int)aleatorio_rango(aleatorio, 1, 2), ingresado, ESTADO_FINALIZADO);
+            escribir_linea(generador, generador->prefijo_fraude, usuario, DIGITOS_CASO_FRAUDE, minuto + (int)aleatorio_rango(aleatorio, 60, 11 * 60),
+                           (int)aleatorio_rango(aleatorio, 1, 2), (int)aleatorio_rango(aleatorio, 1, 2), -retirado, ESTADO_FINALIZADO);
+            snprintf(detalle, sizeof(detalle), "Saldo negativo=%lld", (long long)(ingresado - retirado));
+            break;
+        }
+    }
+
+    anotar_caso_fraude(generador, patron, usuario, clave_hora, detalle);
+}
+
+// Orden de los casos de un fichero por posición
+int comparar_casos_fraude(const void *a, const void *b) {
+    const CasoFraude *caso_a = a;
+    const CasoFraude *caso_b = b;
+    if (caso_a->posicion != caso_b->posicion) {
+        return (caso_a->posicion < caso_b->posicion) ? -1 : 1;
+    }
+    return caso_a->patron - caso_b->patron;
+}
+
+#pragma endregion CasosFraude
+
+
+// ------------------------------------------------------------------
+// GENERACIÓN DE UN FICHERO
+// ------------------------------------------------------------------
+#pragma region Ficheros
+
+// Genera un fichero de una sucursal con sus líneas normales y sus casos de fraude
+// El generador de números aleatorios se inicia con la semilla y con la sucursal, el tipo de operación y el número
+// de fichero, y los usuarios de fraude llevan esos tres números: el fichero no depende de los demás que se generen
+// Devuelve 0 si se ha escrito correctamente y -1 si no
+int generar_fichero(int sucursal, int operacion, int fichero) {
+    char nombre_fichero[64];
+    char nombre_completo[PATH_MAX + 64];
+    char nombre_temporal[PATH_MAX + 80];
+    snprintf(nombre_fichero, sizeof(nombre_fichero), "SU%03d_OPE%03d_%02d%02d%04d_%03d.csv", sucursal, operacion,
+             parametros.dia, parametros.mes, parametros.anio, fichero);
+    snprintf(nombre_completo, sizeof(nombre_completo), "%s%s", parametros.path, nombre_fichero);
+    // Nombre oculto: no empieza por el prefijo de los ficheros de las sucursales
+    snprintf(nombre_temporal, sizeof(nombre_temporal), "%s.%s.tmp", parametros.path, nombre_fichero);
+
+    Generador generador = {0};
+    uint64_t clave_fichero = ((uint64_t)sucursal * 1000 + (uint64_t)operacion) * 1000 + (uint64_t)fichero;
+    generador.aleatorio = parametros.semilla ^ (clave_fichero * UINT64_C(0xd1b54a32d192ed03));
+    generador.operacion = 1;
+    snprintf(generador.prefijo_fraude, sizeof(generador.prefijo_fraude), "%s%03d%03d%03d", PREFIJO_USUARIO_FRAUDE, sucursal, operacion, fichero);
+    generador.nombre_fichero = nombre_fichero;
+    snprintf(generador.fecha, sizeof(generador.fecha), "%02d/%02d/%04d", parametros.dia, parametros.mes, parametros.anio);
+    generador.buffer = malloc(TAMANO_BUFFER_ESCRITURA);
+    generador.fd = open(nombre_temporal, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (generador.buffer == NULL || generador.fd == -1) {
+        fprintf(stderr, "Error al crear el fichero %s: %s\n", nombre_temporal, strerror(errno));
+        free(generador.buffer);
+        if (generador.fd != -1) {
+            close(generador.fd);
+        }
+        return -1;
+    }
+
+    // Casos de fraude del fichero: la parte decimal de lo esperado se reparte al azar
+    size_t num_casos = 0;
+    size_t capacidad_casos = 0;
+    CasoFraude *casos = NULL;
+    for (int patron = 1; patron <= NUM_PATRONES_FRAUDE; patron++) {
+        double esperados = parametros.tasa_fraude[patron] * parametros.num_lineas / 1000.0;
+        uint64_t cantidad = (uint64_t)esperados;
+        if (aleatorio_unidad(&generador.aleatorio) <= esperados - (double)cantidad) {
+            cantidad++;
+        }
+        for (uint64_t i = 0; i < cantidad; i++) {
+            if (num_casos == capacidad_casos) {
+                capacidad_casos = (capacidad_casos == 0) ? 64 : capacidad_casos * 2;
+                CasoFraude *ampliados = realloc(casos, capacidad_casos * sizeof(CasoFraude));
+                if (ampliados == NULL) {
+                    fprintf(stderr, "Error al reservar memoria para los casos de fraude\n");
+                    exit(EXIT_FAILURE);
+                }
+                casos = ampliados;
+            }
+            casos[num_casos].posicion = (int64_t)aleatorio_rango(&generador.aleatorio, 0, parametros.num_lineas);
+            casos[num_casos].patron = patron;
+            num_casos++;
+        }
+    }
+    qsort(casos, num_casos, sizeof(CasoFraude), comparar_casos_fraude);
+
+    // Líneas normales con los casos de fraude intercalados en su posición
+    size_t siguiente_caso = 0;
+    for (int64_t linea = 0; linea <= parametros.num_lineas && !generador.error; linea++) {
+        while (siguiente_caso < num_casos && casos[siguiente_caso].posicion == linea) {
+            generar_caso_fraude(&generador, casos[siguiente_caso++].patron);
+        }
+        if (linea < parametros.num_lineas) {
+            generar_linea_normal(&generador);
+        }
+    }
+    vaciar_buffer(&generador);
+    free(casos);
+    free(generador.buffer);
+
+    if (close(generador.fd) == -1 || generador.error) {
+        fprintf(stderr, "Error al escribir el fichero %s\n", nombre_temporal);
+        unlink(nombre_temporal);
+        return -1;
+    }
+    if (rename(nombre_temporal, nombre_completo) == -1) {
+        fprintf(stderr, "Error al renombrar %s a %s: %s\n", nombre_temporal, nombre_completo, strerror(errno));
+        unlink(nombre_temporal);
+        return -1;
+    }
+    return 0;
+}
+
+#pragma endregion Ficheros
+
+
+// ------------------------------------------------------------------
+// MAIN: PROCESAMIENTO DE PARÁMETROS Y GENERACIÓN DE LOS FICHEROS
+// ------------------------------------------------------------------
+#pragma region Main
+
+// Imprime en la consola la forma de utilizar el generador
+void imprimirUso() {
+    printf("Uso: ./GeneradorTransacciones -l/--lineas <NUMERO LINEAS> -s/--sucursales <NUMERO SUCURSALES> -o/--operaciones <NUMERO OPERACIONES>\n"
+           "    -f/--ficheros <FICHEROS POR SUCURSAL> -p/--path <CARPETA> -up/--usernamePrefix <PREFIJO> -uf/--userFrom <DESDE> -ut/--userTo <HASTA>\n"
+           "    -S/--semilla <SEMILLA> -d/--fecha <DDMMYYYY> -e/--estados <%%FINALIZADO,%%CORRECTO,%%ERROR>\n"
+           "    -im/--importeMinimo <IMPORTE> -iM/--importeMaximo <IMPORTE> -di/--distribucionImporte UNIFORME|NORMAL\n"
+           "    -fr/--fraude <PATRON>:<CASOS POR 1000 LINEAS> -m/--manifiesto <FICHERO> -h/--help\n");
+}
+
+// Convierte un parámetro numérico comprobando que sea válido
+static int leer_entero(const char *texto, int64_t minimo, int64_t maximo, int64_t *valor) {
+    char *fin;
+    errno = 0;
+    long long numero = strtoll(texto, &fin, 10);
+    if (fin == texto || *fin != '\0' || errno == ERANGE || numero < minimo || numero > maximo) {
+        return -1;
+    }
+    *valor = numero;
+    return 0;
+}
+
+// Procesamiento de los parámetros de llamada desde la línea de comando
+// Devuelve 0 si son correctos y 1 si no (o si sólo se ha pedido la ayuda)
+int procesarParametrosLlamada(int argc, char *argv[]) {
+    int manifiesto_indicado = 0;
+    time_t ahora = time(NULL);
+    struct tm *hoy = localtime(&ahora);
+    parametros.dia = hoy->tm_mday;
+    parametros.mes = hoy->tm_mon + 1;
+    parametros.anio = hoy->tm_year + 1900;
+
+    for (int i = 1; i < argc; i++) {
+        const char *parametro = argv[i];
+        if (strcmp(parametro, "-h") == 0 || strcmp(parametro, "--help") == 0) {
+            imprimirUso();
+            return 1;
+        }
+        // El resto de parámetros llevan un valor
+        if (i + 1 >= argc) {
+            printf("Error: Falta el valor del parámetro %s.\n", parametro);
+            return 1;
+        }
+        const char *valor = argv[++i];
+        int64_t numero;
+        int correcto = 1;
+
+        if (strcmp(parametro, "-l") == 0 || strcmp(parametro, "--lineas") == 0) {
+            correcto = leer_entero(valor, 0, INT64_MAX / 2, &parametros.num_lineas) == 0;
+        } else if (strcmp(parametro, "-s") == 0 || strcmp(parametro, "--sucursales") == 0) {
+            correcto = leer_entero(valor, 1, 999, &numero) == 0;
+            parametros.num_sucursales = (int)numero;
+        } else if (strcmp(parametro, "-o") == 0 || strcmp(parametro, "--operaciones") == 0) {
+            correcto = leer_entero(valor, 1, 999, &numero) == 0;
+            parametros.num_operaciones = (int)numero;
+        } else if (strcmp(parametro, "-f") == 0 || strcmp(parametro, "--ficheros") == 0) {
+            correcto = leer_entero(valor, 1, 999, &numero) == 0;
+            parametros.num_ficheros = (int)numero;
+        } else if (strcmp(parametro, "-p") == 0 || strcmp(parametro, "--path") == 0) {
+            // La carpeta siempre termina en '/' para formar los nombres
+            size_t longitud = strlen(valor);
+            correcto = longitud > 0 && longitud < sizeof(parametros.path) - 1;
+            if (correcto) {
+                snprintf(parametros.path, sizeof(parametros.path), "%s%s", valor, (valor[longitud - 1] == '/') ? "" : "/");
+            }
+        } else if (strcmp(parametro, "-up") == 0 || strcmp(parametro, "--usernamePrefix") == 0) {
+            parametros.prefijo_usuario = valor;
+            correcto = strlen(valor) < 32;
+        } else if (strcmp(parametro, "-uf") == 0 || strcmp(parametro, "--userFrom") == 0) {
+            correcto = leer_entero(valor, 0, INT64_MAX, &numero) == 0;
+            parametros.usuario_desde = (uint64_t)numero;
+        } else if (strcmp(parametro, "-ut") == 0 || strcmp(parametro, "--userTo") == 0) {
+            correcto = leer_entero(valor, 0, INT64_MAX, &numero) == 0;
+            parametros.usuario_hasta = (uint64_t)numero;
+        } else if (strcmp(parametro, "-S") == 0 || strcmp(parametro, "--semilla") == 0) {
+            correcto = leer_entero(valor, 0, INT64_MAX, &numero) == 0;
+            parametros.semilla = (uint64_t)numero;
+        } else if (strcmp(parametro, "-d") == 0 || strcmp(parametro, "--fecha") == 0) {
+            correcto = strlen(valor) == 8 && sscanf(valor, "%2d%2d%4d", &parametros.dia, &parametros.mes, &parametros.anio) == 3 &&
+                       parametros.dia >= 1 && parametros.dia <= 31 && parametros.mes >= 1 && parametros.mes <= 12;
+        } else if (strcmp(parametro, "-e") == 0 || strcmp(parametro, "--estados") == 0) {
+            int *estados = parametros.porcentaje_estados;
+            correcto = sscanf(valor, "%d,%d,%d", &estados[0], &estados[1], &estados[2]) == 3 &&
+                       estados[0] >= 0 && estados[1] >= 0 && estados[2] >= 0 && estados[0] + estados[1] + estados[2] > 0;
+        } else if (strcmp(parametro, "-im") == 0 || strcmp(parametro, "--importeMinimo") == 0) {
+            correcto = leer_entero(valor, -1000000000, 1000000000, &parametros.importe_minimo) == 0;
+        } else if (strcmp(parametro, "-iM") == 0 || strcmp(parametro, "--importeMaximo") == 0) {
+            correcto = leer_entero(valor, -1000000000, 1000000000, &parametros.importe_maximo) == 0;
+        } else if (strcmp(parametro, "-di") == 0 || strcmp(parametro, "--distribucionImporte") == 0) {
+            if (strcmp(valor, "UNIFORME") == 0) {
+                parametros.distribucion_importe = IMPORTE_UNIFORME;
+            } else if (strcmp(valor, "NORMAL") == 0) {
+                parametros.distribucion_importe = IMPORTE_NORMAL;
+            } else {
+                correcto = 0;
+            }
+        } else if (strcmp(parametro, "-fr") == 0 || strcmp(parametro, "--fraude") == 0) {
+            int patron;
+            double tasa;
+            correcto = sscanf(valor, "%d:%lf", &patron, &tasa) == 2 && patron >= 1 && patron <= NUM_PATRONES_FRAUDE && tasa >= 0;
+            if (correcto) {
+                parametros.tasa_fraude[patron] = tasa;
+            }
+        } else if (strcmp(parametro, "-m") == 0 || strcmp(parametro, "--manifiesto") == 0) {
+            correcto = strlen(valor) < sizeof(parametros.manifiesto);
+            snprintf(parametros.manifiesto, sizeof(parametros.manifiesto), "%s", valor);
+            manifiesto_indicado = 1;
+        } else {
+            printf("Parámetro desconocido: %s\n", parametro);
+            imprimirUso();
+            return 1;
+        }
+
+        if (!correcto) {
+            printf("Error: Valor no válido para el parámetro %s: %s\n", parametro, valor);
+            return 1;
+        }
+    }
+
+    if (parametros.usuario_hasta < parametros.usuario_desde || parametros.importe_maximo < parametros.importe_minimo) {
+        printf("Error: Rango de usuarios o de importes no válido.\n");
+        return 1;
+    }
+    // Cada caso de fraude de un fichero tiene su número de usuario, con DIGITOS_CASO_FRAUDE dígitos
+    double casos_fichero = 0;
+    for (int patron = 1; patron <= NUM_PATRONES_FRAUDE; patron++) {
+        casos_fichero += (parametros.tasa_fraude[patron] > 0) ? parametros.tasa_fraude[patron] * parametros.num_lineas / 1000.0 + 1 : 0;
+    }
+    if (casos_fichero > MAX_CASOS_FRAUDE_FICHERO) {
+        printf("Error: Demasiados casos de fraude por fichero (como mucho %d).\n", MAX_CASOS_FRAUDE_FICHERO);
+        return 1;
+    }
+    if (!manifiesto_indicado) {
+        snprintf(parametros.manifiesto, sizeof(parametros.manifiesto), "%smanifiesto_fraude.csv", parametros.path);
+    }
+    return 0;
+}
+
+// Función main
+int main(int argc, char *argv[]) {
+    if (procesarParametrosLlamada(argc, argv) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    fichero_manifiesto = fopen(parametros.manifiesto, "w");
+    if (fichero_manifiesto == NULL) {
+        fprintf(stderr, "Error al crear el manifiesto %s: %s\n", parametros.manifiesto, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    struct timespec inicio, fin;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+
+    // Se recorren sucursales, tipos de operación y ficheros igual que en genera_ficheros_prueba.sh
+    uint64_t num_ficheros = 0;
+    int errores = 0;
+    for (int sucursal = 1; sucursal <= parametros.num_sucursales; sucursal++) {
+        for (int operacion = 1; operacion <= parametros.num_operaciones; operacion++) {
+            for (int fichero = 1; fichero <= parametros.num_ficheros; fichero++) {
+                errores += (generar_fichero(sucursal, operacion, fichero) != 0);
+                num_ficheros++;
+            }
+        }
+    }
+
+    if (fclose(fichero_manifiesto) != 0) {
+        fprintf(stderr, "Error al escribir el manifiesto %s\n", parametros.manifiesto);
+        errores++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+    double segundos = (fin.tv_sec - inicio.tv_sec) + (fin.tv_nsec - inicio.tv_nsec) / 1e9;
+    printf("Generados %llu ficheros en %s: %llu líneas, %.1f MB en %.2f s (%.1f MB/s)\n", (unsigned long long)num_ficheros, parametros.path,
+           (unsigned long long)total_lineas, total_bytes / 1e6, segundos, (segundos > 0) ? total_bytes / 1e6 / segundos : 0.0);
+    printf("Casos de fraude inyectados (%s):", parametros.manifiesto);
+    for (int patron = 1; patron <= NUM_PATRONES_FRAUDE; patron++) {
+        printf(" patrón %d=%llu", patron, (unsigned long long)total_casos[patron]);
+    }
+    printf("\n");
+
+    return (errores == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#pragma endregion Main
@@ -0,0 +1,31 @@
+/**
+GeneradorTransacciones.h
+
+    Declaración de funciones de GeneradorTransacciones.c
+*/
+
+// Para evitar que se puedan llegar a declarar  las funciones varias veces
+#pragma once
+
+#include <stdint.h>         // Enteros de tamaño fijo
+#include <stddef.h>         // size_t
+
+struct GENERADOR;
+struct CASO_FRAUDE;
+uint64_t siguiente_aleatorio(uint64_t *estado);
+uint64_t aleatorio_rango(uint64_t *estado, uint64_t minimo, uint64_t maximo);
+double aleatorio_unidad(uint64_t *estado);
+void vaciar_buffer(struct GENERADOR *generador);
+void anadir_texto(struct GENERADOR *generador, const char *texto, size_t longitud);
+void anadir_entero(struct GENERADOR *generador, int64_t valor, int digitos_minimos);
+void anadir_fecha_hora(struct GENERADOR *generador, int minuto_dia);
+void escribir_linea(struct GENERADOR *generador, const char *prefijo_usuario, uint64_t numero_usuario, int digitos_usuario,
+                    int minuto_inicio, int tipo_operacion1, int tipo_operacion2, int64_t importe, int estado);
+int64_t generar_importe(struct GENERADOR *generador);
+int generar_estado(struct GENERADOR *generador);
+void generar_linea_normal(struct GENERADOR *generador);
+void generar_caso_fraude(struct GENERADOR *generador, int patron);
+int comparar_casos_fraude(const void *a, const void *b);
+int generar_fichero(int sucursal, int operacion, int fichero);
+void imprimirUso();
+int procesarParametrosLlamada(int argc, char *argv[]);
@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Script para compilar GeneradorTransacciones.c en GeneradorTransacciones
+
+# Nombre del archivo del programa C
+archivo_programa="GeneradorTransacciones.c"
+
+# Nombre del ejecutable después de la compilación
+ejecutable="GeneradorTransacciones"
+
+# Opciones de compilación: optimizado, para generar los ficheros lo más rápido posible
+cflags="-O2"
+
+# Opciones de enlace para la biblioteca matemática (distribución normal de los importes)
+ldflags="-lm"
+
+# Compilar el programa C
+gcc "$archivo_programa" -o "$ejecutable" $cflags $ldflags
+
+# Verificar si hubo errores durante la compilación
+if [ $? -eq 0 ]; then
+    echo "El programa $archivo_programa se ha compilado correctamente en $ejecutable."
+else
+    echo "Hubo errores durante la compilación."
+fi
@@ -79,20 +79,26 @@ for ((sucursal=1; sucursal<=numeroSucursales; sucursal++)); do
             textoNumeroFichero="$(printf "%03d" $fichero)"
             nombreFichero="${textoSucursal}_${textoOperacion}_${fechaFormateada}_${textoNumeroFichero}.csv"
             nombreCompletoFichero="${pathFichero}${nombreFichero}"
+
+            # El fichero se escribe con un nombre oculto y se renombra al terminar: FileProcessor recoge los
+            # ficheros en cuanto se cierran, y sólo debe ver el nombre definitivo con el contenido completo
+            nombreTemporal="${pathFichero}.${nombreFichero}.tmp"
             
             # Crea el fichero
-            ./genera_transacciones.sh --usernamePrefix USER --userFrom 100 --userTo 200 --lineas $numeroRegistros > $nombreCompletoFichero
+            ./genera_transacciones.sh --usernamePrefix USER --userFrom 100 --userTo 200 --lineas $numeroRegistros > $nombreTemporal
 
             # Añadir transacciones de fraude a la primera sucursal
             if [ $sucursal -eq "1" ] && [ $operacion -eq "1" ] && [ $fichero -eq "1" ] 
             then
-                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_1 --usuario FRAU001 --numeroOperacionComienzo 500 >> $nombreCompletoFichero
-                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_2 --usuario FRAU002 --numeroOperacionComienzo 600 >> $nombreCompletoFichero
-                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_3 --usuario FRAU003 --numeroOperacionComienzo 700 >> $nombreCompletoFichero
-                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_4 --usuario FRAU004 --numeroOperacionComienzo 800 >> $nombreCompletoFichero
-                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_5 --usuario FRAU005 --numeroOperacionComienzo 900 >> $nombreCompletoFichero
+                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_1 --usuario FRAU001 --numeroOperacionComienzo 500 >> $nombreTemporal
+                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_2 --usuario FRAU002 --numeroOperacionComienzo 600 >> $nombreTemporal
+                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_3 --usuario FRAU003 --numeroOperacionComienzo 700 >> $nombreTemporal
+                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_4 --usuario FRAU004 --numeroOperacionComienzo 800 >> $nombreTemporal
+                ./genera_transacciones_fraude.sh --patronFraude patron_fraude_5 --usuario FRAU005 --numeroOperacionComienzo 900 >> $nombreTemporal
+                mv $nombreTemporal $nombreCompletoFichero
                 echo "Fichero (con transacciones fraudulentas) generado: $nombreCompletoFichero"
             else 
+                mv $nombreTemporal $nombreCompletoFichero
                 echo "Fichero (sin transacciones fraudulentas) generado: $nombreCompletoFichero"
             fi
 
@@ -6,13 +6,28 @@ Monitor.c
         espera una señal de FileProcessor a través de un named pipe y, cuando recibe la señal
         se encarga de detectar los patrones de fraude definidos.
 
+        Los registros nuevos se leen del anillo de memoria compartida en el que los publica FileProcessor, y
+        un único hilo los aplica, en una sola pasada, a todos los patrones; cada patrón mantiene su diccionario
+        entre señales y el fichero consolidado sólo se lee si faltan registros.
+
         Se comunica con el proceso FileProcessor utilizando named pipe, y se sincroniza con dicho proceso
-        utilizando un semáforo común.
+        mediante bloqueos de lectura/escritura sobre el fichero consolidado.
+
+        El hilo principal es un bucle de eventos (epoll) que espera a la vez en el pipe, en las señales de
+        terminación (signalfd) y en un temporizador (timerfd) para el mantenimiento periódico: mientras no
+        ocurre nada no consume CPU. También recarga la configuración con SIGHUP o cuando se guarda el fichero.
+
+        Además de los ficheros resultado de cada patrón, añade a un flujo de alertas (ALERTS_FILE) sólo las
+        alertas nuevas o que han cambiado, numeradas, para que otros procesos lo sigan desde la última que
+        leyeron. El punto de control se guarda en el mismo paso en que se escriben alertas y también al
+        terminar con SIGINT/SIGTERM, así que al reiniciar no se repiten; sólo un fallo entre la escritura de
+        las alertas y la del punto de control puede hacer que se repitan las de esa comprobación.
 
         Escribe datos de la operación en los ficheros de log.
 
     Compilación:
-        gcc Monitor.c -o Monitor
+        gcc Monitor.c ../Comun/RegistroCSV.c ../Comun/Log.c ../Comun/Configuracion.c ../Comun/Retardo.c ../Comun/AnilloRegistros.c -o Monitor -pthread -lrt -lm
+        (con -DLOG_NIVEL_MINIMO=LOG_INFO no se compilan los mensajes de depuración del log)
 
     Ejecución:
         ./Monitor
@@ -27,9 +42,6 @@ Monitor.c
 // Número de patrones de fraude implementados
 #define NUM_PATRONES_FRAUDE 5
 
-// Segundos que debe dormir el hilo cuando no está activo
-#define SEGUNDOS_HILO_DORMIDO 5
-
 // ------------------------------------------------------------------
 // Librerías necesarias y explicación
 // ------------------------------------------------------------------
@@ -40,7 +52,6 @@ Monitor.c
 #include <pthread.h>        // Tratamiento de hilos y mutex
 #include <time.h>           // Tratamiento de datos temporales
 #include <stdarg.h>         // Tratamiento de parámetros opcionales va_init...
-#include <semaphore.h>      // Tratamiento de semáforos
 #include <unistd.h>         // Gestión de procesos, acceso a archivos, pipe, control de señales
 #include <sys/types.h>      // Definiciones de typos de datos: pid_t, size_t...
 #include <sys/stat.h>       // Definiciones y estructuras para trabajar con estados de archivos Linux
@@ -48,8 +59,20 @@ Monitor.c
 #include <linux/limits.h>   // Define varias constantes que representan los límites del sistema en sistemas operativos Linux
 #include <fcntl.h>          // Proporciona funciones y constantes para controlar archivos y descriptores de archivo en Linux 
 #include <signal.h>         // Manejo de la señal CTRL-C
-#include <glib.h>           // Manejo de diccionarios GLib utilizado para la detección de patrones de fraude
-
+#include <errno.h>          // Códigos de error de las llamadas al sistema (errno)
+#include <stdint.h>         // Enteros de tamaño fijo (longitud de las tramas del pipe)
+#include <malloc.h>         // malloc_trim (devolver al sistema la memoria liberada al compactar los diccionarios)
+#include <sys/mman.h>       // Proyección del fichero consolidado y del anillo de registros en memoria (mmap)
+#include <sys/epoll.h>      // Bucle de eventos del hilo principal
+#include <sys/signalfd.h>   // Señales recibidas como eventos (signalfd)
+#include <sys/timerfd.h>    // Temporizador del mantenimiento periódico (timerfd)
+#include <sys/sendfile.h>   // Copia de las alertas cerradas al fichero resultado sin pasar por memoria (sendfile)
+
+#include "../Comun/RegistroCSV.h"   // Separación en campos de los registros CSV (común con FileProcessor)
+#include "../Comun/Log.h"           // Log asíncrono (común con FileProcessor)
+#include "../Comun/Configuracion.h" // Fichero de configuración (común con FileProcessor)
+#include "../Comun/Retardo.h"       // Retardo simulado (común con FileProcessor)
+#include "../Comun/AnilloRegistros.h"   // Anillo de registros y bloqueo del fichero consolidado (común con FileProcessor)
 #include "Monitor.h"        // Declaración de funciones de este módulo
 #pragma endregion Librerias
 
@@ -59,101 +82,12 @@ Monitor.c
 // ------------------------------------------------------------------
 #pragma region FicheroConfiguracion
 
-// Parámetros máximos del fichero de configuración
-#define MAX_LONGITUD_LINEA 100
-#define MAX_LONGITUD_CLAVE 50
-#define MAX_LONGITUD_VALOR 50
-#define MAX_ENTRADAS_CONFIG 100
-#define MAX_LINE_LENGTH 1024
-
-// Formato de la estructura de una linea del fichero de configuración. p.ej. FicheroConsolidado (clave) = consolidado.csv(valor)
-struct EntradaConfiguracion {
-    char clave[MAX_LONGITUD_CLAVE];
-    char valor[MAX_LONGITUD_VALOR];
-};
-
-// Estructura para guardar el fichero de configuración en memoria y no tener que acceder a el muchas veces en el programa ppal.
-struct EntradaConfiguracion configuracion[MAX_ENTRADAS_CONFIG];
-int num_entradas = 0;
-// Variable que indica que el fichero de configuracion ya está leído
-int ficheroConfiguracionLeido = 0;
-
-//Función que leera el archivo de configuración y sabrá guardar los parámetros de fp.conf
-void leer_archivo_configuracion(const char *nombre_archivo) {
-    
-    // Como este fichero únicamente se lee al inicio del programa antes de crear los threads
-    // no es necesario hacerlo thread safe
-
-    FILE *archivo = fopen(nombre_archivo, "r");
-    if (archivo == NULL) {
-        //perror muestra un mensaje de error en caso de error al abrir el fichero
-        perror("Error al abrir el archivo de configuración");
-        exit(1);
-    }
-
-    char linea[MAX_LONGITUD_LINEA];
-    //Vamos metiendo cada línea del fichero
-    while (fgets(linea, sizeof(linea), archivo)) {
-        // No leer las líneas vacías y comentarios (controlamos # para linux y ; para los archivos .ini de Windows)
-        if (linea[0] == '\n' || linea[0] == '#' || linea[0] == ';')
-            continue;
-
-        char clave[MAX_LONGITUD_CLAVE];
-        char valor[MAX_LONGITUD_VALOR];
-
-        // Encontrar la posición del primer '=' en la línea; el valor está justo en la primera posición detrás del igual de la clave
-        char *posicion_igual = strchr(linea, '=');
-        if (posicion_igual == NULL) {
-            continue;
-        }
-
-        // Copiar la clave
-        //Con la operación de posicion_igual (posicion del símbolo =) - linea (0 siempre)
-        strncpy(clave, linea, posicion_igual - linea);
-        clave[posicion_igual - linea] = '\0'; // Terminar la clave
-
-        // Leer el valor
-        char *posicion_valor = posicion_igual + 1;
-        //Controlamos que se pueda poner un espacio al meter el valor después del igual
-        if (*posicion_valor == ' ') {
-            posicion_valor++;
-        }
-        //Leo el valor
-        sscanf(posicion_valor, "%[^\n]", valor);
-        //Añadp clave y valor en la estructura
-        if (num_entradas < MAX_ENTRADAS_CONFIG) {
-            strcpy(configuracion[num_entradas].clave, clave);
-            strcpy(configuracion[num_entradas].valor, valor);
-            num_entradas++;
-        } else {
-            printf("Se alcanzó el máximo de entradas\n");
-            break;
-        }
-
-    }
-
-    // Con esto ya hemos leido el fichero de configuración
-    ficheroConfiguracionLeido = 1;
-    //Cerramos archivo 
-    fclose(archivo);
-}
+/*
+    El fichero de configuración es común a FileProcessor y Monitor: ver ../Comun/Configuracion.c
+        Se lee al arrancar y cada clave queda convertida a su tipo en un campo de Configuracion (obtener_configuracion)
+        El bucle de eventos lo vuelve a leer con SIGHUP o cuando se guarda (atender_recarga_configuracion)
+*/
 
-//Funcion para acceder a los valores de el archivo .conf por Clave y poder usarlos en el resto del programa fácilmente
-// Devuelve el valor de la clave del fichero de configuración 
-// o un valor por defecto
-const char *obtener_valor_configuracion(const char *clave, const char *valor_por_defecto) {
-    // Si no hemos leído todavía el fichero de configuración, leerlo.  La primera vez, siempre se leerá
-    if (ficheroConfiguracionLeido == 0) {
-        leer_archivo_configuracion(FICHERO_CONFIGURACION);
-    }
-    for (int i = 0; i < num_entradas; i++) {
-        if (strcmp(configuracion[i].clave, clave) == 0) {
-            return configuracion[i].valor;
-        }
-    }
-    //Si no he encontrado la clave en el .conf devulevo el valor por defecto
-    return valor_por_defecto;
-}
 #pragma endregion FicheroConfiguracion
 
 
@@ -162,191 +96,13 @@ const char *obtener_valor_configuracion(const char *clave, const char *valor_por
 // ------------------------------------------------------------------
 #pragma region FicherosLog
 /*
-    Vamos a manejar dos ficheros de log:
-        El primero será un log detallado que ayudará a ver el funcionamiento de la aplicación y nos permita depurar (clave de .conf LOG_FILE_APP)
-        El segundo será el log que se pde en la práctica (clave de .conf LOG_FILE)
-
-        Para ello emplearemos una variable adicional de tipo NivelLog con los siguientes valores (clave de .conf LOG_LEVEL)
-            LOG_GENERAL: mensajes generales solicitados en el enunciado de la práctica, se escriben en ambos ficheros de log LOG_FILE_APP y LOG_FILE
-            LOG_DEBUG: mensajes muy detallados utilizados para depurar el funcionamiento de la aplicación en desarrollo, se escribe en LOG_FILE_APP
-            LOG_INFO: mensajes informativos acerca del funcionamiento de la aplicación, se escribe en LOG_FILE_APP
-            LOG_WARNING: mensajes de advertencia (de momento no los he utilizado), se escribe en LOG_FILE_APP
-            LOG_ERROR: mensajes de error que indican que algo ha funcionado incorrectamente, se escribe en LOG_FILE_APP
-*/
-
-//Mutex para seguridad de los hilos, garantiza que dos hilos no podrán escribir a la vez en el fichero de log
-pthread_mutex_t mutex_escritura_log = PTHREAD_MUTEX_INITIALIZER;
-
-#define ARCHIVO_LOG "file_log.log"
-#define ARCHIVO_LOG_APP "logfile_app.log"
-
-//Damos los posibles valores a el Nivel de Depuración que queremos para los ficheros de log
-typedef enum LOG_LEVEL_TYPE {
-    LOG_GENERAL,
-    LOG_DEBUG,
-    LOG_INFO,
-    LOG_WARNING,
-    LOG_ERROR
-} NivelLog;
-
-
-/*
-    Función de escritura en fichero de log segura para hilos
-        NivelLog es el nivel de log para ese mensaje
-        Módulo es una cadena que describe la parte del programa que ha generado el mensaje de log; ejemplo: hilopatronfraude
-        Formato es cadena de formato C que aplicaremos para formatear los parametros del mensaje
-    ... Número variable de parametro que compondrán el mensaje de log; ejemplo: numHilo, numRegistrosProcesados, etc
-    
-    Ejemplo de como llamar a la función: 
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: Registro que cumple el patrón Clave: %s, Registros a la vez: %d\n", id_hilo, registro->clave, registro->cantidad);
+    El log es asíncrono y es común a FileProcessor y Monitor: ver ../Comun/Log.c
+        escribirEnLog deja la línea en un buffer del hilo que llama y un hilo escritor la escribe en los ficheros
+        LOG_FILE_APP y LOG_FILE (los mensajes LOG_GENERAL también se muestran por pantalla)
+        Niveles (LOG_LEVEL): GENERAL, DEBUG, INFO, WARNING, ERROR
+        Si el buffer de un hilo se llena, LOG_OVERFLOW indica si se espera (BLOCK) o se descarta el mensaje (DROP)
 */
-void escribirEnLog(NivelLog nivelLog, const char *modulo, const char *formato, ...) {
-
-    // Primero comparar el nivel de log del mensaje con el nivel de log solicitado 
-    // en el fichero de configuración para escribir en el log únicamente si es necesario
-
-    // Obtener el nivel de log solicitado en el fichero de configuración
-    const char *log_level_configuracion;
-    log_level_configuracion = obtener_valor_configuracion("LOG_LEVEL", "LOG_INFO");
-    // Calculo el nivel_log_solicitado (según typedef) a partir de la cadena log_level_configuracion
-    NivelLog nivel_log_solicitado;
-    if (strcmp(log_level_configuracion, "DEBUG") == 0) {
-        nivel_log_solicitado = LOG_DEBUG;
-    } else if (strcmp(log_level_configuracion, "GENERAL") == 0) {
-        nivel_log_solicitado = LOG_GENERAL;
-    } else if (strcmp(log_level_configuracion, "INFO") == 0) {
-        nivel_log_solicitado = LOG_INFO;
-    } else if (strcmp(log_level_configuracion, "WARNING") == 0) {
-        nivel_log_solicitado = LOG_WARNING;
-    } else if (strcmp(log_level_configuracion, "ERROR") == 0) {
-        nivel_log_solicitado = LOG_ERROR;
-    } else {
-        // En caso de error ponemos LOG_DEBUG
-        nivel_log_solicitado = LOG_DEBUG;
-    }
-        
-    // Ver si es necesario escribir en el log, en función del niveLog y log_level
-
-    // En principio no es necesario escribir en el log
-    int escribirLog = 0;
-    //Ahora vemos si hay que escribir
-    if (nivel_log_solicitado == LOG_DEBUG) {
-        // Si en el fichero de configuracion LOG_DEBUG, registramos todos los mensajes
-        escribirLog = 1;
-    } else if (nivelLog == LOG_GENERAL) {
-        // Los mensajes de nivel de depuración LOG_GENERAL siempre se escriben
-        escribirLog = 1;
-    } else if (nivel_log_solicitado == LOG_INFO && (nivelLog == LOG_INFO || nivelLog == LOG_WARNING || nivelLog == LOG_ERROR)) {
-        // Si en el fichero de configuracion LOG_INFO, registramos LOG_INFO, LOG_WARNING, LOG_ERROR
-        escribirLog = 1;
-    } else if (nivel_log_solicitado == LOG_WARNING && (nivelLog == LOG_WARNING || nivelLog == LOG_ERROR)) {
-        // Si en el fichero de configuracion LOG_WARNING, registramos , LOG_WARNING, LOG_ERROR
-        escribirLog = 1;
-    } else if (nivel_log_solicitado == LOG_ERROR && nivelLog == LOG_ERROR) {
-        // Si en el fichero de configuracion LOG_ERROR, registramos LOG_ERROR
-        escribirLog = 1;
-    }
-    
-    // Si no hay que escribir en el log, retornamos sin escribir en log
-    if (escribirLog == 0) {
-        return;
-    }    
-
-    //Si el programa llega hasta aquí es que hay que escribir
-    // Bloquear el mutex
-    pthread_mutex_lock(&mutex_escritura_log);
-
-    // Obtener el nombre del archivo de log de aplicacion del fichero de configuración
-    const char *fichero_log_aplicacion;
-    fichero_log_aplicacion = obtener_valor_configuracion("LOG_FILE_APP", ARCHIVO_LOG_APP);
-    FILE *archivo_log_aplicacion = fopen(fichero_log_aplicacion, "a");
-    //Si hay un error, liberar el mutex para que no se quede estancado el programa
-    if (archivo_log_aplicacion == NULL) {
-        fprintf(stderr, "Error al abrir el archivo de log de aplicacion\n");
-        pthread_mutex_unlock(&mutex_escritura_log);
-        return;
-    }
-
-    // Obtener el nombre del archivo de log general del fichero de configuración
-    const char *fichero_log_general;
-    fichero_log_general = obtener_valor_configuracion("LOG_FILE", ARCHIVO_LOG);
-    FILE *archivo_log_general = fopen(fichero_log_general, "a");
-    //Si hay un error, liberar el mutex para que no se quede estancado el programa
-    if (archivo_log_general == NULL) {
-        fprintf(stderr, "Error al abrir el archivo de log general\n");
-        pthread_mutex_unlock(&mutex_escritura_log);
-        return;
-    }
 
-    // Obtener fecha y hora actual
-    char fechaHora[20];
-    obtenerFechaHora(fechaHora);
-    char fechaHora2[20];
-    obtenerFechaHora2(fechaHora2);
-
-    // Obtener cadena de nivel de depuración de manera más estética
-    const char *cadenaDepuracion;
-    switch (nivelLog) {
-        case LOG_DEBUG:
-            cadenaDepuracion = "DEBUG   ";
-            break;
-        case LOG_INFO:
-            cadenaDepuracion = "INFO    ";
-            break;
-        case LOG_WARNING:
-            cadenaDepuracion = "WARNING ";
-            break;
-        case LOG_ERROR:
-            cadenaDepuracion = "ERROR   ";
-            break;
-        case LOG_GENERAL:
-            cadenaDepuracion = "GENERAL ";
-            break;
-        default:
-            cadenaDepuracion = "UNKNOWN ";
-            break;
-    }
-
-    
-    // Escribir entrada de registro en el log de aplicación LOG_FILE_APP
-    fprintf(archivo_log_aplicacion, "%s - [%s] - %s: ", fechaHora, cadenaDepuracion, modulo);
-    //Todavía no hemos metido salto de línea
-
-    // Si hay argumentos adicionales, escribirlos en una variable y en el fichero
-    //Este snippet lo hemos buscado en internet y lo hemos entendido 
-    char mensaje[255] = "";
-    if (formato != NULL) {
-        //va_lists almacenará los parámetros adicionales
-        va_list args;
-        //va_start es un "bucle" que incializa los parametros adicionales y comprueba el formato
-        va_start(args, formato);
-        //vsnprinft imprimer en la cadena mensaje los argumentos con el formato
-        vsnprintf(mensaje, sizeof(mensaje), formato, args);
-        //Lo escribimos en el fichero
-        fprintf(archivo_log_aplicacion, "%s", mensaje);
-        //Libera args
-        va_end(args);
-    } 
-
-
-    // En caso de mensaje con nivel de depuración LOG_GENERAL
-    // escribir entrada en log general y en pantalla
-    // Formato fichero log aplicación: FECHA:::HORA:::NoPROCESO:::INICIO:::FIN:::NOMBRE_FICHERO:::NoOperacionesConsolidadas
-    if (nivelLog == LOG_GENERAL) {
-        // Formato fichero log aplicación: FECHA:::HORA:::
-        /// Escribir en fichero de log general
-        fprintf(archivo_log_general, "%s:::%s", fechaHora2, mensaje);
-        // Escribir por pantalla
-        printf("%s:::%s", fechaHora2, mensaje);
-    }
-
-    // Cerrar los 2 ficheros log
-    fclose(archivo_log_general);
-    fclose(archivo_log_aplicacion);
-
-    // Desbloquear el mutex
-    pthread_mutex_unlock(&mutex_escritura_log);
-}
 #pragma endregion FicherosLog
 
 
@@ -355,39 +111,6 @@ void escribirEnLog(NivelLog nivelLog, const char *modulo, const char *formato, .
 // ------------------------------------------------------------------
 #pragma region Utilidades
 
-// Función para sleep centésimas de segundo
-void sleep_centiseconds(int n) {
-    struct timespec sleep_time;
-    sleep_time.tv_sec = n / 100;            // Seconds
-    sleep_time.tv_nsec = (n % 100) * 10000000;   // Convert centiseconds to nanoseconds
-
-    // Call nanosleep with the calculated sleep time
-    nanosleep(&sleep_time, NULL);
-}
-
-// Función que simula un retardo según los parámetros del fichero de configuración
-void simulaRetardo(const char* mensaje) {
-    int retardoMin;
-    int retardoMax;
-    const char* retardoMinTexto;
-    const char* retardoMaxTexto;
-    retardoMinTexto = obtener_valor_configuracion("SIMULATE_SLEEP_MIN", "1");
-    retardoMaxTexto = obtener_valor_configuracion("SIMULATE_SLEEP_MAX", "2");
-    retardoMin = atoi(retardoMinTexto);
-    retardoMax = atoi(retardoMaxTexto);
-    int retardo;
-
-    // Inicializamos la semilla para generar números aleatorios
-    srand(time(NULL));
-    
-    // Generamos el retardo como un número aleatorio dentro del rango
-    retardo = rand() % (retardoMax - retardoMin + 1) + retardoMin;
-
-    escribirEnLog(LOG_INFO,"retardo", "%s entrando en retardo simulado de %0d segundos\n", mensaje, retardo);
-    sleep(retardo);
-
-}
-
 // Función para obtener la hora actual en formato HH:MM
 char* obtener_hora_actual() {
     // Variable local para almacenar la hora actual
@@ -435,855 +158,1921 @@ void obtenerFechaHora2(char *fechaHora2) {
 // ------------------------------------------------------------------
 #pragma region DeteccionPatronesFraude
 
-// Utilizaremos este semaforo para asegurar el acceso de los threads 
-// a recursos compartidos (ficheros de entraa¡da y fichero consolidado)
-sem_t *semaforo_consolidar_ficheros_entrada;
-// Este es el nombre del semáforo
-const char *semName;
+// El hilo evaluador de patrones lee el fichero consolidado con un bloqueo de lectura compartido:
+// FileProcessor (que toma un bloqueo de escritura para añadir registros) espera a que termine la pasada.
+// Se utilizan bloqueos OFD (asociados al descriptor abierto y no al proceso), ver bloquear_fichero en
+// Comun/AnilloRegistros.c.
 
-// En esta matriz guardamos los mutex que utilizaremos para bloquear los hilos hasta que se recibe una notificación del pipe
-pthread_mutex_t mutex_array[NUM_PATRONES_FRAUDE];
+// Avisos al hilo evaluador de patrones: cada notificación del pipe incrementa la generación de avisos y el hilo
+// espera en la variable de condición hasta que la generación supera la última que ha atendido. Los avisos que
+// llegan mientras evalúa se agrupan: al terminar hace una única evaluación más, que incluye todo lo nuevo
+pthread_mutex_t mutex_evaluador = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t condicion_evaluador = PTHREAD_COND_INITIALIZER;
+uint64_t generacion_avisos = 0;
+int mantenimiento_pendiente = 0;        // El temporizador pide guardar el punto de control aunque no haya pasado su plazo
 
-// Tamaño de los mensajes que se reciben a través del named pipe desde FileProcessor
-#define MESSAGE_SIZE 100
+// Terminación ordenada: main la pide al recibir SIGINT/SIGTERM y espera a que el evaluador haya escrito las
+// alertas y el punto de control antes de terminar el proceso (protegidas por mutex_evaluador)
+pthread_cond_t condicion_terminado = PTHREAD_COND_INITIALIZER;
+int terminacion_pendiente = 0;
+int evaluador_terminado = 0;
+
+// Tamaño máximo del texto de los mensajes que se reciben a través del named pipe desde FileProcessor
+// Cada mensaje llega como una trama: longitud del texto (uint32_t) seguida del texto (sin '\0')
+#define MESSAGE_SIZE 1024
+
+// Tamaño del buffer de lectura del pipe (admite muchas tramas por lectura)
+#define TAMANO_BUFFER_PIPE (64 * (sizeof(uint32_t) + MESSAGE_SIZE))
 
 // Pipe por el que recibiremos datos desde FileProcessor
 int pipefd;
 
-// Diccionario para patron_fraude_1
-typedef struct REGISTRO_PATRON {
-    char* clave;
-    int cantidad;
-    int operacion1Presente;
-    int operacion2Presente;
-    int operacion3Presente;
-    int operacion4Presente;
-} RegistroPatron;
+// Función para avisar al hilo evaluador de patrones de fraude de que hay registros nuevos
+void notificarEvaluadorPatrones() {
+    pthread_mutex_lock(&mutex_evaluador);
+    generacion_avisos++;
+    pthread_cond_signal(&condicion_evaluador);
+    pthread_mutex_unlock(&mutex_evaluador);
+    escribirEnLog(LOG_DEBUG, "Monitor: notificarEvaluadorPatrones", "Evaluador avisado\n");
+}
 
-void free_registroPatronF1(gpointer data) {
-    RegistroPatron* registro = (RegistroPatron*)data;
-    //g_free(registro->usuario);
-    g_free(registro);
+// Función para pedir al hilo evaluador el mantenimiento periódico (punto de control con los cambios pendientes)
+void solicitarMantenimientoEvaluador() {
+    __atomic_store_n(&mantenimiento_pendiente, 1, __ATOMIC_RELEASE);
+    notificarEvaluadorPatrones();
 }
 
-// Función para eliminar los últimos caracteres de una cadena
-char *eliminarUltimosCaracteres(char *cadena, int n) {
-    // La podemos utilizar para eliminar el :MM:DD de una fecha-hora de tipo YYYY-MM-DD HH:MM:SS (llamando con n=5)
-    // La utilizamos para quitar el " €" en los importes": 120 €" (llamando con n=5)
-    int longitud = strlen(cadena);
-    if (longitud >= n) {
-        cadena[longitud - n] = '\0';
+// Función que pide al hilo evaluador que termine y espera a que lo haga
+// El evaluador hace una última comprobación, escribe las alertas y el punto de control y avisa al terminar
+void solicitarTerminacionEvaluador() {
+    pthread_mutex_lock(&mutex_evaluador);
+    terminacion_pendiente = 1;
+    generacion_avisos++;
+    pthread_cond_signal(&condicion_evaluador);
+    while (!evaluador_terminado) {
+        pthread_cond_wait(&condicion_terminado, &mutex_evaluador);
     }
-    return cadena;
+    pthread_mutex_unlock(&mutex_evaluador);
+    escribirEnLog(LOG_INFO, "Monitor: solicitarTerminacionEvaluador", "Evaluador terminado\n");
 }
 
-// Función para concatenar 2 cadenas
-char* concatenar_cadenas(char cadena1[30], char cadena2[30], char cadena3[30]) {
-    static char resultado[100]; // Almacenará el resultado de la concatenación
-    strcpy(resultado, cadena1); // Copia la primera cadena en resultado
-    
-    // Concatena la segunda cadena a resultado
-    strcat(resultado, cadena2);
-
-    // Concatena la tercera cadena a resultado
-    strcat(resultado, cadena3);
-
-    return resultado; // Devuelve la cadena concatenada
+// Función que indica que el hilo evaluador ha terminado su última comprobación
+void avisarEvaluadorTerminado() {
+    pthread_mutex_lock(&mutex_evaluador);
+    evaluador_terminado = 1;
+    pthread_cond_signal(&condicion_terminado);
+    pthread_mutex_unlock(&mutex_evaluador);
 }
 
-
-// Función para indicar a un hilo de patrón de fraude que se active (1) o desactive (0)
-void activarHiloPatronFraude(int numPatron, int estado) {
-    // La utilizamos para mantener los hilos bloqueados, hasta que se recibe una notificación en el pipe
-    if (estado) {
-        // Bloquear el mutex --> de esta forma bloquea la activación del hilo
-        pthread_mutex_lock(&mutex_array[numPatron - 1]);
-        escribirEnLog(LOG_DEBUG, "Monitor: activarHiloPatronFraude", "Hilo %02d activado en estado %01d\n", numPatron, estado);
-    } else {
-        // Desbloquear el mutex --> permite activar el hilo
-        pthread_mutex_unlock(&mutex_array[numPatron - 1]);
-        escribirEnLog(LOG_DEBUG, "Monitor: activarHiloPatronFraude", "Hilo %02d desactivado en estado %01d\n", numPatron, estado);
+// Función que bloquea el hilo evaluador hasta que llega un aviso posterior a la generación "atendida"
+// Devuelve la generación de avisos actual, que es la que queda atendida con la evaluación que sigue
+// Si se ha pedido la terminación lo indica en *terminar
+uint64_t esperarAvisoEvaluador(uint64_t atendida, int *terminar) {
+    pthread_mutex_lock(&mutex_evaluador);
+    while (generacion_avisos == atendida) {
+        pthread_cond_wait(&condicion_evaluador, &mutex_evaluador);
     }
+    uint64_t generacion = generacion_avisos;
+    *terminar = terminacion_pendiente;
+    pthread_mutex_unlock(&mutex_evaluador);
+    escribirEnLog(LOG_DEBUG, "Monitor: esperarAvisoEvaluador", "Evaluador activado (%llu avisos agrupados)\n", (unsigned long long)(generacion - atendida));
+    return generacion;
 }
 
-// Función para escribir el resultado de los registros que cumplen con el patrón de fraude en un fichero
-void escribirResultadoPatron(int patron, const char* mensaje) {
-    const char *carpeta_datos;
-    carpeta_datos = obtener_valor_configuracion("PATH_FILES", "../datos");
-    const char *raiz_fichero_resultado;
-    raiz_fichero_resultado = obtener_valor_configuracion("RESULTS_FILE", "resultado_patron_");
+// Publica el fichero resultado de un patrón con todos los registros que lo cumplen: los "bytes_cerradas"
+// primeros bytes del fichero de alertas cerradas del patrón (fd_cerradas) seguidos del contenido
+// El resultado se escribe entero en un fichero temporal que después se renombra sobre el fichero resultado:
+// quien lo lea ve el resultado anterior completo o el nuevo completo, nunca un fichero vacío o a medias
+// Las alertas cerradas se copian de fichero a fichero con sendfile, sin cargarlas en memoria
+// Sin registros que cumplan el patrón, el fichero resultado se elimina
+void publicar_fichero_resultado(int patron, int fd_cerradas, uint64_t bytes_cerradas, const char *contenido, size_t longitud) {
+    const Configuracion *configuracion = obtener_configuracion();
     char nombre_completo_fichero_resultado[PATH_MAX];
-    sprintf(nombre_completo_fichero_resultado, "%s/%s%02d.csv", carpeta_datos, raiz_fichero_resultado, patron);
+    snprintf(nombre_completo_fichero_resultado, sizeof(nombre_completo_fichero_resultado), "%s/%s%02d.csv",
+             configuracion->carpeta_datos, configuracion->raiz_fichero_resultado, patron);
 
-    // Escribir el registro en el fichero resultado
-    FILE *fichero_resultado = fopen(nombre_completo_fichero_resultado, "a");
-    //Si hay un error loguearlo
-    if (fichero_resultado == NULL) {
-        escribirEnLog(LOG_ERROR, "Error al escribir en fichero resultado %s\n", nombre_completo_fichero_resultado);
+    if (bytes_cerradas == 0 && longitud == 0) {
+        unlink(nombre_completo_fichero_resultado);
         return;
     }
-    fprintf(fichero_resultado, "%s", mensaje);
-    fclose(fichero_resultado);
-
-    return;
-}
-
-// Función para eliminar el fichero resultado
-void eliminarFicheroResultado(int patron) {
-    const char *carpeta_datos;
-    carpeta_datos = obtener_valor_configuracion("PATH_FILES", "../datos");
-    const char *raiz_fichero_resultado;
-    raiz_fichero_resultado = obtener_valor_configuracion("RESULTS_FILE", "resultado_patron_");
-    char nombre_completo_fichero_resultado[PATH_MAX];
-    sprintf(nombre_completo_fichero_resultado, "%s/%s%02d.csv", carpeta_datos, raiz_fichero_resultado, patron);
-    remove(nombre_completo_fichero_resultado);
-    return;
-}
-
-// Detección de patrón de fraude de tipo 1
-// Más de 5 transacciones por usuario en una hora
-void *hilo_patron_fraude_1(void *arg) {
-    int id_hilo = *((int *)arg);
-    const char *carpeta_datos;
-    char clave[100];
-    char separador1[30] = "@";
-    char separador2[30] = ":00";
-    int cantidad;
-    char mensaje[150];
-
-    carpeta_datos = obtener_valor_configuracion("PATH_FILES", "../datos");
-    const char *fichero_datos;
-    fichero_datos = obtener_valor_configuracion("INVENTORY_FILE", "file.csv");
-    char nombre_completo_fichero_datos[PATH_MAX];
-    sprintf(nombre_completo_fichero_datos, "%s/%s", carpeta_datos, fichero_datos);
-    
-    escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_1", "Hilo %02d: procesando fichero %s \n", id_hilo, nombre_completo_fichero_datos);
 
-    // Bucle infinito para observar la carpeta
-    while (1) {
-        // Esperar a que el hilo se active
-        activarHiloPatronFraude(id_hilo, 1);
-        
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_1", "Hilo %02d: se ha activado\n", id_hilo);
-        // Obtener acceso exclusivo al fichero consolidado
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_1", "Hilo %02d: solicitando acceso al semáforo\n", id_hilo);
-        sem_wait(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_1", "Hilo %02d: comenzando comprobación patrón fraude 1 en fichero %s\n", id_hilo, nombre_completo_fichero_datos);
-
-        //Implementación patrón de fraude tipo 1
-        FILE *archivo_consolidado;
-        archivo_consolidado = fopen(nombre_completo_fichero_datos, "r");
-        if (archivo_consolidado == NULL) {
-
-            // No se ha conseguido abrir el fichero
-            escribirEnLog(LOG_ERROR, "hilo_patron_fraude", "Hilo %02d: error al abrir el archivo en patrón fraude 1 en fichero %s\n", id_hilo, nombre_completo_fichero_datos);
-
-            // Simular retardo
-             //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-            snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_1: Hilo %02d: ", id_hilo);
-            simulaRetardo(mensaje);
-            //Liberar semáforo y continuar
-            sem_post(semaforo_consolidar_ficheros_entrada);
-            continue;
-        }
+    char nombre_temporal[PATH_MAX + 8];
+    snprintf(nombre_temporal, sizeof(nombre_temporal), "%s.tmp", nombre_completo_fichero_resultado);
+    int fd = open(nombre_temporal, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    //Si hay un error loguearlo
+    if (fd == -1) {
+        escribirEnLog(LOG_ERROR, "Monitor: publicar_fichero_resultado", "Error al crear el fichero resultado %s\n", nombre_temporal);
+        return;
+    }
 
-        GHashTable *usuariosPF1 = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_registroPatronF1);
-
-        char line[MAX_LINE_LENGTH];
-        while (fgets(line, sizeof(line), archivo_consolidado)) {
-            // Formato: SUC001;OPE0001;12/03/2024 09:47:00;12/03/2024 10:14:00;USER144;COMPRA01;1;73 €;Finalizado
-            char *sucursal = strtok(line, ";");
-            char *operacion = strtok(NULL, ";");
-            char *fechaHora1 = strtok(NULL, ";");
-            char *fechaHora2 = strtok(NULL, ";");
-            char *usuario = strtok(NULL, ";");
-            char *tipoOperacion1 = strtok(NULL, ";");
-            char *tipoOperacion2 = strtok(NULL, ";");
-            char *importeTexto = strtok(NULL, ";");
-            char *estado = strtok(NULL, ";");
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_1", "Hilo %02d: datos de registro %s;%s;%s;%s;%s;%s;%s;%s;%s;\n", id_hilo, sucursal, operacion, fechaHora1, fechaHora2, usuario, tipoOperacion1, tipoOperacion2, importeTexto, estado);
-
-            // Para este patrón la clave del diccionario va a ser usuario+fecha+hora comienzo
-            if (usuario) {
-                strncpy(clave, usuario, sizeof(clave)-1);
-                strncat(clave, separador1, sizeof(clave)-1);
-                strncat(clave, eliminarUltimosCaracteres(fechaHora1, 6), sizeof(clave)-1);
-                strncat(clave, separador2, sizeof(clave)-1);
-                cantidad = 1;
-                RegistroPatron *registro = g_hash_table_lookup(usuariosPF1, clave);
-                if (registro == NULL) {
-                    registro = g_new(RegistroPatron, 1);
-                    registro->clave = g_strdup(clave);
-                    registro->cantidad = cantidad;
-                    g_hash_table_insert(usuariosPF1, registro->clave, registro);
-                } else {
-                    registro->cantidad += cantidad;
-                }
+    // Copiar las alertas cerradas (sendfile también puede copiar menos de lo pedido)
+    off_t copiados = 0;
+    while ((uint64_t)copiados < bytes_cerradas) {
+        ssize_t resultado = sendfile(fd, fd_cerradas, &copiados, bytes_cerradas - copiados);
+        if (resultado <= 0) {
+            if (resultado == -1 && errno == EINTR) {
+                continue;
             }
+            break;
         }
+    }
 
-        fclose(archivo_consolidado);
-
-        // Imprimir resultados del diccionario en el log
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_1", "Hilo %02d: Diccionario del patrón\n", id_hilo);
-        GHashTableIter iter;
-        gpointer clave, valor;
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_1", "Hilo %02d: Diccionario del patrón Clave: %s, Número Registros: %d\n", id_hilo, registro->clave, registro->cantidad);
-        }
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_1", "Hilo %02d: Terminado diccionario del patrón\n", id_hilo);
-
-        // Eliminar fichero resultado
-        eliminarFicheroResultado(id_hilo);
-        
-        // Revisar resultados que cumplen el patrón
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_1", "Hilo %02d: Registros que cumplen el patrón\n", id_hilo);
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            // Más de 5 movimientos en una hora
-            if (registro->cantidad > 5) {
-                escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_1", "Hilo %02d: Registro que cumple el patrón Clave: %s, Registros en la Misma Hora: %d\n", id_hilo, registro->clave, registro->cantidad);
-                // Componer el mensaje para el log y monitor
-                snprintf(mensaje, sizeof(mensaje), "%02d:::Registro fraude patrón 1:::Clave=%s:::Registros en la Misma Hora=%d\n", id_hilo, registro->clave, registro->cantidad);
-                escribirEnLog(LOG_GENERAL, "Monitor: hilo_patron_fraude_1", mensaje);
-                // Escribir en fichero resultado patron 1
-                escribirResultadoPatron(id_hilo, mensaje);
+    // Escribir el resto del resultado (write puede escribir menos de lo pedido)
+    size_t escritos = 0;
+    while ((uint64_t)copiados == bytes_cerradas && escritos < longitud) {
+        ssize_t resultado = write(fd, contenido + escritos, longitud - escritos);
+        if (resultado == -1) {
+            if (errno == EINTR) {
+                continue;
             }
+            break;
         }
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_1", "Hilo %02d: Terminados registros que cumplen el patrón\n", id_hilo);
+        escritos += resultado;
+    }
+    if (close(fd) == -1 || (uint64_t)copiados < bytes_cerradas || escritos < longitud) {
+        escribirEnLog(LOG_ERROR, "Monitor: publicar_fichero_resultado", "Error al escribir en fichero resultado %s\n", nombre_temporal);
+        unlink(nombre_temporal);
+        return;
+    }
+
+    // rename sustituye el fichero resultado de forma atómica
+    if (rename(nombre_temporal, nombre_completo_fichero_resultado) == -1) {
+        escribirEnLog(LOG_ERROR, "Monitor: publicar_fichero_resultado", "Error al renombrar %s a %s\n", nombre_temporal, nombre_completo_fichero_resultado);
+        unlink(nombre_temporal);
+    }
+}
 
-        // Liberar memoria
-        g_hash_table_destroy(usuariosPF1);
+// ------------------------------------------------------------------
+// DICCIONARIOS DE LOS PATRONES
+// ------------------------------------------------------------------
+/*
+    Los diccionarios de los patrones no usan claves de texto ("USER144@12/03/2024 09:00"): cada usuario se
+    registra una vez en la tabla de usuarios, que le asigna un identificador consecutivo (0, 1, 2...), y la
+    clave de cada entrada es un entero de 64 bits con el identificador del usuario y el intervalo de tiempo
+    (hora, día o segundo, según el patrón). El texto de la clave sólo se compone al escribir los resultados.
+
+    Tanto la tabla de usuarios como los diccionarios son tablas hash de direccionamiento abierto (sondeo
+    lineal): las entradas se guardan directamente en un único array, sin reservar memoria por cada entrada.
+
+    Toda la memoria de los diccionarios (arrays de entradas y nombres de los usuarios) sale de una arena:
+    se reserva en bloques grandes avanzando un puntero, y no se libera elemento a elemento sino toda a la vez
+    (reiniciar_arena, de coste constante) cuando hay que empezar de cero porque el fichero consolidado se ha
+    truncado o sustituido. Los bloques se conservan y se reutilizan después del reinicio.
+
+    Lo que la arena no recupera por sí sola (los arrays sustituidos al ampliar una tabla, los diccionarios que
+    se quedan grandes después de cerrar sus entradas y los usuarios que ya no aparecen en ninguna entrada) se
+    recupera compactando: cuando la arena dobla lo que ocupaba después de la última compactación, se copian
+    a una arena nueva sólo las entradas abiertas, las ventanas que todavía pueden cambiar y sus usuarios
+    (renumerados), con las tablas al tamaño justo, y se liberan los bloques de la anterior
+    (compactar_diccionarios). La memoria queda así proporcional a las entradas abiertas y no al tiempo que
+    lleva Monitor en marcha.
+
+    El patrón 1 (más de 5 transacciones de un usuario en una hora) no agrupa por hora del reloj (09:00-09:59),
+    que no ve las ráfagas que cruzan el cambio de hora: usa una ventana deslizante de una hora. Cada usuario
+    tiene un buffer de tamaño fijo con los instantes de sus transacciones recientes, ordenados; con cada
+    transacción se descartan las que han quedado a más de una hora de la más reciente y se cuentan las que
+    caben en una hora con ella. Los buffers se indexan directamente por el identificador del usuario y también
+    salen de la arena. En el diccionario del patrón 1 sólo se guardan las alertas: una por ráfaga, con el
+    instante en el que empieza y el máximo de transacciones que ha llegado a haber dentro de una hora.
+
+    Para que la memoria no crezca con el tiempo, las entradas se cierran según el tiempo de los eventos (no el
+    del reloj): la marca de agua es el instante más reciente leído menos el retraso permitido (ALLOWED_LATENESS
+    en Monitor.conf). Los registros con una fecha-hora posterior a la actual del reloj más el adelanto
+    permitido (ALLOWED_FUTURE) se ignoran: un solo registro con una fecha equivocada adelantaría la marca de
+    agua y haría que se ignoraran todos los demás. Los registros anteriores a la marca de agua llegan tarde y
+    se ignoran, de modo que una entrada cuyo intervalo (hora, día, segundo o ráfaga del patrón 1) termina antes
+    de la marca de agua ya no puede cambiar: se comprueba por última vez, su resultado se añade al fichero de
+    alertas cerradas del patrón y se borra del diccionario. El diccionario mantiene así sólo las entradas abiertas.
+
+    El fichero de alertas cerradas (RESULTS_FILE + número de patrón + ".cerradas", en PATH_FILES) sólo crece
+    por el final y no se vuelve a cargar en memoria: el fichero resultado del patrón se compone copiándolo
+    (sendfile) y añadiendo después los resultados de las entradas abiertas. El punto de control guarda cuántos
+    bytes suyos corresponden a su estado; al restaurarlo, lo que haya después se descarta, porque esas
+    entradas vuelven a estar abiertas y se cerrarán otra vez.
+*/
 
-        // Una vez terminado, dejamos el estado del hilo en bloqueado, así nos aseguramos de que no se vuelva a ejecutar hasta
-        // que llegue un aviso a través del pipe
+// Tamaño de los bloques de la arena de los diccionarios
+#define TAMANO_BLOQUE_ARENA (1024 * 1024)
 
-        //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-        snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_1: Hilo %02d: ", id_hilo);
-        simulaRetardo(mensaje);
+// Bloque de memoria de una arena
+typedef struct BLOQUE_ARENA {
+    struct BLOQUE_ARENA *siguiente;
+    size_t tamano;                  // Bytes de datos del bloque
+    size_t usado;                   // Bytes ya reservados del bloque
+    uint64_t datos[];               // uint64_t para que las reservas queden alineadas a 8 bytes
+} BloqueArena;
 
-        // Liberar acceso exclusivo al fichero consolidado
-        sem_post(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_1", "Hilo %02d: liberado semáforo.\n", id_hilo);
+// Arena: lista de bloques en la que se reserva avanzando por el bloque actual
+typedef struct ARENA {
+    BloqueArena *primero;
+    BloqueArena *actual;
+    size_t tamano_bloque;
+    size_t bytes_en_uso;            // Bytes reservados desde el último reinicio
+} Arena;
 
-    }
+// Bits de la clave que ocupa el intervalo de tiempo (el resto, los de más peso, son del usuario)
+#define BITS_INTERVALO_CLAVE 40
+#define MASCARA_INTERVALO_CLAVE ((UINT64_C(1) << BITS_INTERVALO_CLAVE) - 1)
 
-    return NULL;
-}
+// Clave que marca una entrada libre de un diccionario
+#define CLAVE_LIBRE UINT64_MAX
 
-// Detección de patrón de fraude de tipo 2
-// Un usuario realiza más de 3 retiros a la vez
-// Entendemos que quiere decir que el usuario realiza tres retiros en la misma hora:minuto:segundo
-void *hilo_patron_fraude_2(void *arg) {
-    int id_hilo = *((int *)arg);
-    const char *carpeta_datos;
-    char clave[100];
-    char separador1[30] = "@";
+// Capacidad inicial (potencia de 2) de las tablas hash
+#define CAPACIDAD_INICIAL_TABLA 1024
+
+// Entrada del diccionario de un patrón
+typedef struct REGISTRO_PATRON {
+    uint64_t clave;                 // Usuario + intervalo de tiempo (CLAVE_LIBRE si la entrada está libre)
+    int64_t cierre;                 // Instante a partir del cual ningún registro puede cambiar la entrada
+    uint64_t huella_notificada;     // Huella del último mensaje escrito en el flujo de alertas (0 si ninguno)
     int cantidad;
-    char mensaje[150];
+    int operacion1Presente;
+    int operacion2Presente;
+    int operacion3Presente;
+    int operacion4Presente;
+} RegistroPatron;
 
-    carpeta_datos = obtener_valor_configuracion("PATH_FILES", "../datos");
-    const char *fichero_datos;
-    fichero_datos = obtener_valor_configuracion("INVENTORY_FILE", "file.csv");
-    char nombre_completo_fichero_datos[PATH_MAX];
-    sprintf(nombre_completo_fichero_datos, "%s/%s", carpeta_datos, fichero_datos);
+// Diccionario de un patrón
+typedef struct DICCIONARIO_PATRON {
+    Arena *arena;                   // Arena de la que se reserva la memoria
+    RegistroPatron *entradas;
+    size_t capacidad;               // Potencia de 2
+    size_t num_entradas;
+} DiccionarioPatron;
+
+// Hueco de la tabla de usuarios
+typedef struct HUECO_USUARIO {
+    uint32_t hash;
+    uint32_t id_mas_uno;            // Identificador del usuario + 1 (0 si el hueco está libre)
+} HuecoUsuario;
+
+// Tabla de usuarios: nombre de usuario -> identificador consecutivo
+typedef struct TABLA_USUARIOS {
+    Arena *arena;                   // Arena de la que se reserva la memoria (también la de los nombres)
+    HuecoUsuario *huecos;
+    uint32_t capacidad;             // Potencia de 2
+    char **nombres;                 // Nombre de cada usuario, por identificador
+    uint32_t num_usuarios;
+    uint32_t capacidad_nombres;
+} TablaUsuarios;
+
+// Ventana deslizante del patrón 1
+#define SEGUNDOS_VENTANA_PATRON_1 3600      // Duración de la ventana
+#define UMBRAL_VENTANA_PATRON_1 6           // Se dispara con la sexta transacción dentro de la ventana
+#define CAPACIDAD_VENTANA_PATRON_1 32       // Instantes que se guardan como mucho por usuario
+
+// Ventana de un usuario: instantes de sus transacciones recientes y la última alerta que ha provocado
+typedef struct VENTANA_USUARIO {
+    int64_t instantes[CAPACIDAD_VENTANA_PATRON_1 + 1];  // Ordenados de menor a mayor (uno más para el que llega)
+    int num_instantes;
+    uint64_t clave_alerta;          // Clave en el diccionario de la última alerta (CLAVE_LIBRE si no hay)
+    int64_t fin_alerta;             // Instante de la última transacción de la ráfaga de esa alerta
+} VentanaUsuario;
+
+// Ventanas de todos los usuarios, por identificador de usuario
+typedef struct VENTANAS_USUARIOS {
+    Arena *arena;                   // Arena de la que se reserva la memoria
+    VentanaUsuario *ventanas;
+    uint32_t capacidad;
+} VentanasUsuarios;
+
+// Contenido de un fichero resultado que se va componiendo en memoria antes de publicarlo
+// El buffer se conserva entre comprobaciones: sólo crece
+typedef struct TEXTO_RESULTADO {
+    char *datos;
+    size_t longitud;
+    size_t capacidad;
+} TextoResultado;
+
+// Flujo de alertas (ALERTS_FILE): fichero al que sólo se añaden las alertas nuevas o que han cambiado,
+// numeradas, para que quien lo lea pueda seguir desde la última que procesó
+// Sólo lo usa el hilo evaluador
+typedef struct FLUJO_ALERTAS {
+    int fd;                         // Abierto con O_APPEND (-1 si no se ha podido abrir)
+    uint64_t ultima_secuencia;      // Número de la última alerta escrita
+    TextoResultado pendiente;       // Alertas de la comprobación en curso, se escriben de una vez al final
+} FlujoAlertas;
+
+FlujoAlertas flujo_alertas = {.fd = -1};
+
+// Retraso permitido (en segundos) de un registro respecto al más reciente leído (ALLOWED_LATENESS)
+// El hilo evaluador lo toma de la configuración al empezar cada comprobación
+int64_t retraso_permitido = 0;
+
+// Instante más allá del cual un registro se considera del futuro y se ignora: fecha-hora actual del reloj más
+// el adelanto permitido (ALLOWED_FUTURE). El hilo evaluador lo calcula al empezar cada comprobación
+int64_t instante_limite_futuro = INT64_MAX;
+
+// Mezcla los bits de un entero de 64 bits para usarlo como hash (finalizador de splitmix64)
+static inline uint64_t mezclar_bits(uint64_t valor) {
+    valor ^= valor >> 30;
+    valor *= UINT64_C(0xbf58476d1ce4e5b9);
+    valor ^= valor >> 27;
+    valor *= UINT64_C(0x94d049bb133111eb);
+    valor ^= valor >> 31;
+    return valor;
+}
 
-    escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: observando carpeta %s \n", id_hilo, carpeta_datos);
+// Hash FNV-1a de una cadena
+static inline uint32_t hash_cadena(const char *cadena) {
+    uint32_t hash = 2166136261u;
+    for (; *cadena != '\0'; cadena++) {
+        hash ^= (unsigned char)*cadena;
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
-    // Bucle infinito para observar la carpeta
-    while (1) {
-        // Esperar a que el hilo se active
-        activarHiloPatronFraude(id_hilo, 1);
-
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: se ha activado\n", id_hilo);
-        // Obtener acceso exclusivo al fichero consolidado
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: esperando semáforo...\n", id_hilo);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: solicitando acceso al semáforo\n", id_hilo);
-        sem_wait(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: comenzando comprobación patrón fraude 2\n", id_hilo);
-
-        // Implentación de patrón_fraude_2
-        FILE *archivo_consolidado;
-        archivo_consolidado = fopen(nombre_completo_fichero_datos, "r");
-        if (archivo_consolidado == NULL) {
-
-            // No se ha conseguido abrir el fichero
-            escribirEnLog(LOG_ERROR, "hilo_patron_fraude", "Hilo %02d: error al abrir el archivo en patrón fraude 1 en fichero %s\n", id_hilo, nombre_completo_fichero_datos);
-
-            // Simular retardo
-             //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-            char mensaje[100];
-            snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_2: Hilo %02d: ", id_hilo);
-            simulaRetardo(mensaje);
-            //Liberar semáforo y continuar
-            sem_post(semaforo_consolidar_ficheros_entrada);
-            continue;
-        }
+// Inicializa una arena vacía (los bloques se reservan al hacer falta)
+void iniciar_arena(Arena *arena, size_t tamano_bloque) {
+    arena->primero = NULL;
+    arena->actual = NULL;
+    arena->tamano_bloque = tamano_bloque;
+    arena->bytes_en_uso = 0;
+}
 
-        GHashTable *usuariosPF1 = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_registroPatronF1);
-        char line[MAX_LINE_LENGTH];
-        int importe;
-        while (fgets(line, sizeof(line), archivo_consolidado)) {
-            // Formato: SUC001;OPE0001;12/03/2024 09:47:00;12/03/2024 10:14:00;USER144;COMPRA01;1;73 €;Finalizado
-            char *sucursal = strtok(line, ";");
-            char *operacion = strtok(NULL, ";");
-            char *fechaHora1 = strtok(NULL, ";");
-            char *fechaHora2 = strtok(NULL, ";");
-            char *usuario = strtok(NULL, ";");
-            char *tipoOperacion1 = strtok(NULL, ";");
-            char *tipoOperacion2 = strtok(NULL, ";");
-            char *importeTexto = strtok(NULL, ";");
-            char *estado = strtok(NULL, ";");
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_2", "Hilo %02d: datos de registro %s;%s;%s;%s;%s;%s;%s;%s;%s;\n", id_hilo, sucursal, operacion, fechaHora1, fechaHora2, usuario, tipoOperacion1, tipoOperacion2, importeTexto, estado);
-
-            // Para este patrón la clave del diccionario va a ser usuario y fecha-hora completa
-            // Comprobar que es un movimiento de retirar dinero
-            importe = atoi(importeTexto);
-            if (usuario && (importe < 0)) {
-                strncpy(clave, usuario, sizeof(clave)-1);
-                strncat(clave, separador1, sizeof(clave)-1);
-                strncat(clave, fechaHora1, sizeof(clave)-1);
-                cantidad = 1;
-                RegistroPatron *registro = g_hash_table_lookup(usuariosPF1, clave);
-                if (registro == NULL) {
-                    registro = g_new(RegistroPatron, 1);
-                    registro->clave = g_strdup(clave);
-                    registro->cantidad = cantidad;
-                    g_hash_table_insert(usuariosPF1, registro->clave, registro);
-                } else {
-                    registro->cantidad += cantidad;
-                }
+// Reserva memoria de la arena; termina el programa si no hay memoria
+void *reservar_arena(Arena *arena, size_t tamano) {
+    tamano = (tamano + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+
+    // Avanzar por los bloques (reutilizando los que quedaron de antes del último reinicio) hasta uno con sitio
+    BloqueArena *bloque = arena->actual;
+    while (bloque == NULL || bloque->usado + tamano > bloque->tamano) {
+        BloqueArena *siguiente = (bloque != NULL) ? bloque->siguiente : arena->primero;
+        if (siguiente == NULL) {
+            size_t tamano_nuevo = (tamano > arena->tamano_bloque) ? tamano : arena->tamano_bloque;
+            siguiente = malloc(sizeof(BloqueArena) + tamano_nuevo);
+            if (siguiente == NULL) {
+                escribirEnLog(LOG_ERROR, "Monitor: reservar_arena", "Error al reservar memoria para los diccionarios de los patrones\n");
+                exit(EXIT_FAILURE);
             }
-        }
-
-        fclose(archivo_consolidado);
-
-        // Imprimir resultados del diccionario en el log
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_2", "Hilo %02d: Diccionario del patrón\n", id_hilo);
-        GHashTableIter iter;
-        gpointer clave, valor;
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_2", "Hilo %02d: Diccionario del patrón Clave: %s, Número Registros: %d\n", id_hilo, registro->clave, registro->cantidad);
-        }
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_2", "Hilo %02d: Terminado diccionario del patrón\n", id_hilo);
-
-        // Eliminar fichero resultado
-        eliminarFicheroResultado(id_hilo);
-
-        // Revisar resultados que cumplen el patrón
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: Registros que cumplen el patrón\n", id_hilo);
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            // Más de 3 retiros a la vez
-            if (registro->cantidad > 3) {
-                escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: Registro que cumple el patrón Clave: %s, Registros a la vez: %d\n", id_hilo, registro->clave, registro->cantidad);
-                // Componer el mensaje para el log y monitor
-                snprintf(mensaje, sizeof(mensaje), "%02d:::Registro fraude patrón 2:::Clave=%s:::Registros a la vez=%d\n", id_hilo, registro->clave, registro->cantidad);
-                escribirEnLog(LOG_GENERAL, "Monitor: hilo_patron_fraude_2", mensaje);
-
-                // Escribir en fichero resultado patron
-                escribirResultadoPatron(id_hilo, mensaje);
+            siguiente->siguiente = NULL;
+            siguiente->tamano = tamano_nuevo;
+            if (bloque != NULL) {
+                bloque->siguiente = siguiente;
+            } else {
+                arena->primero = siguiente;
             }
         }
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: Terminados registros que cumplen el patrón\n", id_hilo);
-
-        // Liberar memoria
-        g_hash_table_destroy(usuariosPF1);
-
-        // Una vez terminado, dejamos el estado del hilo en bloqueado, así nos aseguramos de que no se vuelva a ejecutar hasta
-        // que llegue un aviso a través del pipe
+        siguiente->usado = 0;
+        bloque = siguiente;
+    }
 
-        //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-        snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_2: Hilo %02d: ", id_hilo);
-        simulaRetardo(mensaje);
+    arena->actual = bloque;
+    void *memoria = (char *)bloque->datos + bloque->usado;
+    bloque->usado += tamano;
+    arena->bytes_en_uso += tamano;
+    return memoria;
+}
 
-        // Liberar acceso exclusivo al fichero consolidado
-        sem_post(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_2", "Hilo %02d: liberado semáforo.\n", id_hilo);
+// Da por libre toda la memoria reservada de la arena, sin devolver sus bloques al sistema
+void reiniciar_arena(Arena *arena) {
+    arena->actual = arena->primero;
+    if (arena->primero != NULL) {
+        arena->primero->usado = 0;
     }
-
-    return NULL;
+    arena->bytes_en_uso = 0;
 }
 
-// Detección de patrón de fraude de tipo 3
-// Un usuario comete más de 3 errores durante 1 día
-void *hilo_patron_fraude_3(void *arg) {
-    int id_hilo = *((int *)arg);
-    const char *carpeta_datos;
-    char clave[100];
-    char separador1[30] = "@";
-    int cantidad;
-    char mensaje[150];
+// Devuelve al sistema todos los bloques de la arena y la deja vacía
+void liberar_arena(Arena *arena) {
+    BloqueArena *bloque = arena->primero;
+    while (bloque != NULL) {
+        BloqueArena *siguiente = bloque->siguiente;
+        free(bloque);
+        bloque = siguiente;
+    }
+    iniciar_arena(arena, arena->tamano_bloque);
+}
 
-    carpeta_datos = obtener_valor_configuracion("PATH_FILES", "../datos");
-    const char *fichero_datos;
-    fichero_datos = obtener_valor_configuracion("INVENTORY_FILE", "file.csv");
-    char nombre_completo_fichero_datos[PATH_MAX];
-    sprintf(nombre_completo_fichero_datos, "%s/%s", carpeta_datos, fichero_datos);
+// Capacidad (potencia de 2, al menos CAPACIDAD_INICIAL_TABLA) de una tabla hash para "elementos" elementos
+// con la ocupación por debajo del 70%
+size_t capacidad_tabla(size_t elementos) {
+    size_t capacidad = CAPACIDAD_INICIAL_TABLA;
+    while ((elementos + 1) * 10 > capacidad * 7) {
+        capacidad *= 2;
+    }
+    return capacidad;
+}
 
-    escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_3", "Hilo %02d: observando carpeta %s \n", id_hilo, carpeta_datos);
+// Inicializa un diccionario vacío de la capacidad indicada (potencia de 2) cuya memoria se reserva de la arena
+void iniciar_diccionario(DiccionarioPatron *diccionario, Arena *arena, size_t capacidad) {
+    diccionario->arena = arena;
+    diccionario->capacidad = capacidad;
+    diccionario->num_entradas = 0;
+    diccionario->entradas = reservar_arena(arena, diccionario->capacidad * sizeof(RegistroPatron));
+    for (size_t i = 0; i < diccionario->capacidad; i++) {
+        diccionario->entradas[i].clave = CLAVE_LIBRE;
+    }
+}
 
-    // Bucle infinito para observar la carpeta
-    while (1) {
-        // Esperar a que el hilo se active
-        activarHiloPatronFraude(id_hilo, 1);
-
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_3", "Hilo %02d: se ha activado\n", id_hilo);
-        // Obtener acceso exclusivo al fichero consolidado
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_3", "Hilo %02d: esperando semáforo...\n", id_hilo);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_3", "Hilo %02d: solicitando acceso al semáforo\n", id_hilo);
-        sem_wait(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_3", "Hilo %02d: comenzando comprobación patrón fraude 3\n", id_hilo);
-
-        // Implementación patrón fraude tipo 3
-        FILE *archivo_consolidado;
-        archivo_consolidado = fopen(nombre_completo_fichero_datos, "r");
-        if (archivo_consolidado == NULL) {
-
-            // No se ha conseguido abrir el fichero
-            escribirEnLog(LOG_ERROR, "hilo_patron_fraude", "Hilo %02d: error al abrir el archivo en patrón fraude 1 en fichero %s\n", id_hilo, nombre_completo_fichero_datos);
-
-            // Simular retardo
-             //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-            char mensaje[100];
-            snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_3: Hilo %02d: ", id_hilo);
-            simulaRetardo(mensaje);
-            //Liberar semáforo y continuar
-            sem_post(semaforo_consolidar_ficheros_entrada);
-            continue;
-        }
+// Duplica la capacidad del diccionario y recoloca sus entradas
+// El array anterior no se libera: se recupera con el resto de la arena o al compactarla
+void ampliar_diccionario(DiccionarioPatron *diccionario) {
+    RegistroPatron *entradas_anteriores = diccionario->entradas;
+    size_t capacidad_anterior = diccionario->capacidad;
 
-        GHashTable *usuariosPF1 = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_registroPatronF1);
-        char line[MAX_LINE_LENGTH];
-        while (fgets(line, sizeof(line), archivo_consolidado)) {
-            // Formato: SUC001;OPE0001;12/03/2024 09:47:00;12/03/2024 10:14:00;USER144;COMPRA01;1;73 €;Finalizado
-            char *sucursal = strtok(line, ";");
-            char *operacion = strtok(NULL, ";");
-            char *fechaHora1 = strtok(NULL, ";");
-            char *fechaHora2 = strtok(NULL, ";");
-            char *usuario = strtok(NULL, ";");
-            char *tipoOperacion1 = strtok(NULL, ";");
-            char *tipoOperacion2 = strtok(NULL, ";");
-            char *importeTexto = strtok(NULL, ";");
-            char *estado = strtok(NULL, ";");
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_3", "Hilo %02d: datos de registro %s;%s;%s;%s;%s;%s;%s;%s;%s;\n", id_hilo, sucursal, operacion, fechaHora1, fechaHora2, usuario, tipoOperacion1, tipoOperacion2, importeTexto, estado);
-
-            // Para este patrón la clave del diccionario va a ser usuario y el día del mes
-            // Comprobar que es un movimiento de error
-            if (usuario && (strcmp(estado, "Error"))) {
-                strncpy(clave, usuario, sizeof(clave)-1);
-                strncat(clave, separador1, sizeof(clave)-1);
-                strncat(clave, eliminarUltimosCaracteres(fechaHora1, 9), sizeof(clave)-1);
-                cantidad = 1;
-                RegistroPatron *registro = g_hash_table_lookup(usuariosPF1, clave);
-                if (registro == NULL) {
-                    registro = g_new(RegistroPatron, 1);
-                    registro->clave = g_strdup(clave);
-                    registro->cantidad = cantidad;
-                    g_hash_table_insert(usuariosPF1, registro->clave, registro);
-                } else {
-                    registro->cantidad += cantidad;
-                }
+    diccionario->capacidad = capacidad_anterior * 2;
+    diccionario->entradas = reservar_arena(diccionario->arena, diccionario->capacidad * sizeof(RegistroPatron));
+    for (size_t i = 0; i < diccionario->capacidad; i++) {
+        diccionario->entradas[i].clave = CLAVE_LIBRE;
+    }
+    size_t mascara = diccionario->capacidad - 1;
+    for (size_t i = 0; i < capacidad_anterior; i++) {
+        if (entradas_anteriores[i].clave != CLAVE_LIBRE) {
+            size_t posicion = mezclar_bits(entradas_anteriores[i].clave) & mascara;
+            while (diccionario->entradas[posicion].clave != CLAVE_LIBRE) {
+                posicion = (posicion + 1) & mascara;
             }
+            diccionario->entradas[posicion] = entradas_anteriores[i];
         }
+    }
+}
 
-        fclose(archivo_consolidado);
-
-        // Imprimir resultados del diccionario en el log
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_3", "Hilo %02d: Diccionario del patrón\n", id_hilo);
-        GHashTableIter iter;
-        gpointer clave, valor;
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_3", "Hilo %02d: Diccionario del patrón Clave: %s, Número Registros: %d\n", id_hilo, registro->clave, registro->cantidad);
-        }
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_3", "Hilo %02d: Terminado diccionario del patrón\n", id_hilo);
-
-        // Eliminar fichero resultado
-        eliminarFicheroResultado(id_hilo);
-
-        // Revisar resultados que cumplen el patrón
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_3", "Hilo %02d: Registros que cumplen el patrón\n", id_hilo);
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            // Más de tres errores en un día
-            if (registro->cantidad > 3) {
-                escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_3", "Hilo %02d: Registro que cumple el patrón Clave: %s, Registros con Error: %d\n", id_hilo, registro->clave, registro->cantidad);
-                // Componer el mensaje para el log y monitor
-                snprintf(mensaje, sizeof(mensaje), "%02d:::Registro fraude patrón 3:::Clave=%s:::Registros con Error=%d\n", id_hilo, registro->clave, registro->cantidad);
-                escribirEnLog(LOG_GENERAL, "Monitor: hilo_patron_fraude_3", mensaje);
-
-                // Escribir en fichero resultado patron
-                escribirResultadoPatron(id_hilo, mensaje);
-            }
+// Busca en el diccionario del patrón la entrada de una clave, y la crea (a ceros) si no existe
+RegistroPatron *obtener_registro_patron(DiccionarioPatron *diccionario, uint64_t clave) {
+    // Se mantiene la ocupación por debajo del 70% para que las búsquedas sean cortas
+    if ((diccionario->num_entradas + 1) * 10 > diccionario->capacidad * 7) {
+        ampliar_diccionario(diccionario);
+    }
+    size_t mascara = diccionario->capacidad - 1;
+    size_t posicion = mezclar_bits(clave) & mascara;
+    while (diccionario->entradas[posicion].clave != clave) {
+        if (diccionario->entradas[posicion].clave == CLAVE_LIBRE) {
+            RegistroPatron *registro = &diccionario->entradas[posicion];
+            memset(registro, 0, sizeof(RegistroPatron));
+            registro->clave = clave;
+            diccionario->num_entradas++;
+            return registro;
         }
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_3", "Hilo %02d: Terminados registros que cumplen el patrón\n", id_hilo);
-
-        // Liberar memoria
-        g_hash_table_destroy(usuariosPF1);
-
-        // Una vez terminado, dejamos el estado del hilo en bloqueado, así nos aseguramos de que no se vuelva a ejecutar hasta
-        // que llegue un aviso a través del pipe
-
-        //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-        snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_3: Hilo %02d: ", id_hilo);
-        simulaRetardo(mensaje);
-
-        // Liberar acceso exclusivo al fichero consolidado
-        sem_post(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_3", "Hilo %02d: liberado semáforo.\n", id_hilo);
+        posicion = (posicion + 1) & mascara;
     }
-    
-    return NULL;
+    return &diccionario->entradas[posicion];
 }
 
-// Detección de patrón de fraude de tipo 4
-// Un usuario realiza una operación por cada tipo de operaciones durante el mismo día
-// Suponemos que este patrón de fraude se da cuando en el mismo día hay 1 registro de cada
-// uno de estos tipos de operaciones: 1, 2, 3, 4
-void *hilo_patron_fraude_4(void *arg) {
-    int id_hilo = *((int *)arg);
-    const char *carpeta_datos;
-    char clave[100];
-    char separador1[30] = "@";
-    int operacion1, operacion2, operacion3, operacion4;
-    char mensaje[150];
-
-    carpeta_datos = obtener_valor_configuracion("PATH_FILES", "../datos");
-    const char *fichero_datos;
-    fichero_datos = obtener_valor_configuracion("INVENTORY_FILE", "file.csv");
-    char nombre_completo_fichero_datos[PATH_MAX];
-    sprintf(nombre_completo_fichero_datos, "%s/%s", carpeta_datos, fichero_datos);
-
-    escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_4", "Hilo %02d: observando carpeta %s \n", id_hilo, carpeta_datos);
-
-    // Bucle infinito para observar la carpeta
+// Borra del diccionario la entrada de una posición
+// Las entradas siguientes del mismo grupo se desplazan hacia atrás para que las búsquedas por sondeo lineal
+// las sigan encontrando (no se dejan marcas de borrado). La posición puede quedar ocupada por otra entrada
+void borrar_registro_patron(DiccionarioPatron *diccionario, size_t posicion) {
+    size_t mascara = diccionario->capacidad - 1;
+    size_t hueco = posicion;
+    size_t siguiente = posicion;
     while (1) {
-        // Esperar a que el hilo se active
-        activarHiloPatronFraude(id_hilo, 1);
-
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_4", "Hilo %02d: se ha activado\n", id_hilo);
-        // Obtener acceso exclusivo al fichero consolidado
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_4", "Hilo %02d: esperando semáforo...\n", id_hilo);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_4", "Hilo %02d: solicitando acceso al semáforo\n", id_hilo);
-        sem_wait(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_4", "Hilo %02d: comenzando comprobación patrón fraude 3\n", id_hilo);
-
-        // Implementación patrón fraude tipo 3
-        FILE *archivo_consolidado;
-        archivo_consolidado = fopen(nombre_completo_fichero_datos, "r");
-        if (archivo_consolidado == NULL) {
-
-            // No se ha conseguido abrir el fichero
-            escribirEnLog(LOG_ERROR, "hilo_patron_fraude", "Hilo %02d: error al abrir el archivo en patrón fraude 1 en fichero %s\n", id_hilo, nombre_completo_fichero_datos);
-
-            // Simular retardo
-             //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-            char mensaje[100];
-            snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_4: Hilo %02d: ", id_hilo);
-            simulaRetardo(mensaje);
-            //Liberar semáforo y continuar
-            sem_post(semaforo_consolidar_ficheros_entrada);
-            continue;
+        siguiente = (siguiente + 1) & mascara;
+        if (diccionario->entradas[siguiente].clave == CLAVE_LIBRE) {
+            break;
         }
-
-        GHashTable *usuariosPF1 = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_registroPatronF1);
-        char line[MAX_LINE_LENGTH];
-        while (fgets(line, sizeof(line), archivo_consolidado)) {
-            // Formato: SUC001;OPE0001;12/03/2024 09:47:00;12/03/2024 10:14:00;USER144;COMPRA01;1;73 €;Finalizado
-            char *sucursal = strtok(line, ";");
-            char *operacion = strtok(NULL, ";");
-            char *fechaHora1 = strtok(NULL, ";");
-            char *fechaHora2 = strtok(NULL, ";");
-            char *usuario = strtok(NULL, ";");
-            char *tipoOperacion1 = strtok(NULL, ";");
-            char *tipoOperacion2 = strtok(NULL, ";");
-            int numTipoOperacion2 = atoi(tipoOperacion2);
-            char *importeTexto = strtok(NULL, ";");
-            char *estado = strtok(NULL, ";");
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_4", "Hilo %02d: datos de registro %s;%s;%s;%s;%s;%s;%s;%s;%s;\n", id_hilo, sucursal, operacion, fechaHora1, fechaHora2, usuario, tipoOperacion1, tipoOperacion2, importeTexto, estado);
-            
-            //Comprobar el tipo de operación
-
-            if (numTipoOperacion2 == 1) {operacion1 = 1;} else {operacion1 = 0;}
-            if (numTipoOperacion2 == 2) {operacion2 = 1;} else {operacion2 = 0;}
-            if (numTipoOperacion2 == 3) {operacion3 = 1;} else {operacion3 = 0;}
-            if (numTipoOperacion2 == 4) {operacion4 = 1;} else {operacion4 = 0;}
-            
-            // Para este patrón la clave del diccionario va a ser usuario y el día del mes
-            // Tenemos que ir acumulando los tipos de operación
-            if (usuario && (strcmp(estado, "Error"))) {
-                strncpy(clave, usuario, sizeof(clave)-1);
-                strncat(clave, separador1, sizeof(clave)-1);
-                strncat(clave, eliminarUltimosCaracteres(fechaHora1, 9), sizeof(clave)-1);
-                
-                RegistroPatron *registro = g_hash_table_lookup(usuariosPF1, clave);
-                if (registro == NULL) {
-                    registro = g_new(RegistroPatron, 1);
-                    registro->clave = g_strdup(clave);
-                    registro->cantidad = 0;
-                    registro->operacion1Presente = operacion1;
-                    registro->operacion2Presente = operacion2;
-                    registro->operacion3Presente = operacion3;
-                    registro->operacion4Presente = operacion4;
-                    g_hash_table_insert(usuariosPF1, registro->clave, registro);
-                } else {
-                    registro->operacion1Presente = registro->operacion1Presente + operacion1;
-                    registro->operacion2Presente = registro->operacion2Presente + operacion2;
-                    registro->operacion3Presente = registro->operacion3Presente + operacion3;
-                    registro->operacion4Presente = registro->operacion4Presente + operacion4;
-                }
-            }
+        // La entrada se queda donde está si su posición ideal está entre el hueco y ella (de forma circular)
+        size_t ideal = mezclar_bits(diccionario->entradas[siguiente].clave) & mascara;
+        int quedarse = (hueco <= siguiente) ? (hueco < ideal && ideal <= siguiente) : (hueco < ideal || ideal <= siguiente);
+        if (!quedarse) {
+            diccionario->entradas[hueco] = diccionario->entradas[siguiente];
+            hueco = siguiente;
         }
+    }
+    diccionario->entradas[hueco].clave = CLAVE_LIBRE;
+    diccionario->num_entradas--;
+}
+
+// Inicializa una tabla de usuarios vacía de la capacidad indicada (potencia de 2) cuya memoria se reserva de la arena
+void iniciar_tabla_usuarios(TablaUsuarios *tabla, Arena *arena, uint32_t capacidad) {
+    tabla->arena = arena;
+    tabla->capacidad = capacidad;
+    tabla->huecos = reservar_arena(arena, tabla->capacidad * sizeof(HuecoUsuario));
+    memset(tabla->huecos, 0, tabla->capacidad * sizeof(HuecoUsuario));
+    tabla->capacidad_nombres = capacidad;
+    tabla->nombres = reservar_arena(arena, tabla->capacidad_nombres * sizeof(char *));
+    tabla->num_usuarios = 0;
+}
 
-        fclose(archivo_consolidado);
-
-        // Imprimir resultados del diccionario en el log
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_4", "Hilo %02d: Diccionario del patrón\n", id_hilo);
-        GHashTableIter iter;
-        gpointer clave, valor;
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_4", "Hilo %02d: Diccionario del patrón Clave: %s, Número Registros: %d\n", id_hilo, registro->clave, registro->cantidad);
-        }
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_4", "Hilo %02d: Terminado diccionario del patrón\n", id_hilo);
-
-        // Eliminar fichero resultado
-        eliminarFicheroResultado(id_hilo);
-
-        // Revisar resultados que cumplen el patrón
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_4", "Hilo %02d: Registros que cumplen el patrón\n", id_hilo);
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            // Todos los tipos de operación presentes
-            if (registro->operacion1Presente > 0 && registro->operacion2Presente > 0 && registro->operacion3Presente > 0 && registro->operacion4Presente > 0 ) {
-                escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_4", "Hilo %02d: Registro que cumple el patrón Clave: %s, Registros con Todos los Tipos de Operaciones\n", id_hilo, registro->clave);
-                // Componer el mensaje para el log y monitor
-                snprintf(mensaje, sizeof(mensaje), "%02d:::Registro fraude patrón 4:::Clave=%s:::Registros con Todos los Tipos de Operaciones\n", id_hilo, registro->clave);
-                escribirEnLog(LOG_GENERAL, "Monitor: hilo_patron_fraude_4", mensaje);
-
-                // Escribir en fichero resultado patron
-                escribirResultadoPatron(id_hilo, mensaje);
+// Duplica la capacidad de la tabla de usuarios y recoloca sus huecos
+// El array anterior no se libera: se recupera con el resto de la arena o al compactarla
+void ampliar_tabla_usuarios(TablaUsuarios *tabla) {
+    HuecoUsuario *huecos_anteriores = tabla->huecos;
+    uint32_t capacidad_anterior = tabla->capacidad;
+
+    tabla->capacidad = capacidad_anterior * 2;
+    tabla->huecos = reservar_arena(tabla->arena, tabla->capacidad * sizeof(HuecoUsuario));
+    memset(tabla->huecos, 0, tabla->capacidad * sizeof(HuecoUsuario));
+    uint32_t mascara = tabla->capacidad - 1;
+    for (uint32_t i = 0; i < capacidad_anterior; i++) {
+        if (huecos_anteriores[i].id_mas_uno != 0) {
+            uint32_t posicion = huecos_anteriores[i].hash & mascara;
+            while (tabla->huecos[posicion].id_mas_uno != 0) {
+                posicion = (posicion + 1) & mascara;
             }
+            tabla->huecos[posicion] = huecos_anteriores[i];
         }
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_4", "Hilo %02d: Terminados registros que cumplen el patrón\n", id_hilo);
-
-        // Liberar memoria
-        g_hash_table_destroy(usuariosPF1);
-
-        // Una vez terminado, dejamos el estado del hilo en bloqueado, así nos aseguramos de que no se vuelva a ejecutar hasta
-        // que llegue un aviso a través del pipe
+    }
+}
 
-        //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-        snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_4: Hilo %02d: ", id_hilo);
-        simulaRetardo(mensaje);
+// Devuelve el identificador de un usuario, registrándolo si es la primera vez que aparece
+uint32_t obtener_id_usuario(TablaUsuarios *tabla, const char *usuario) {
+    if ((tabla->num_usuarios + 1) * 10 > tabla->capacidad * 7) {
+        ampliar_tabla_usuarios(tabla);
+    }
+    uint32_t hash = hash_cadena(usuario);
+    uint32_t mascara = tabla->capacidad - 1;
+    uint32_t posicion = hash & mascara;
+    while (tabla->huecos[posicion].id_mas_uno != 0) {
+        HuecoUsuario *hueco = &tabla->huecos[posicion];
+        if (hueco->hash == hash && strcmp(tabla->nombres[hueco->id_mas_uno - 1], usuario) == 0) {
+            return hueco->id_mas_uno - 1;
+        }
+        posicion = (posicion + 1) & mascara;
+    }
 
-        // Liberar acceso exclusivo al fichero consolidado
-        sem_post(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_4", "Hilo %02d: liberado semáforo.\n", id_hilo);
+    // Usuario nuevo: su nombre se copia en la arena
+    if (tabla->num_usuarios == tabla->capacidad_nombres) {
+        char **nuevos_nombres = reservar_arena(tabla->arena, 2 * tabla->capacidad_nombres * sizeof(char *));
+        memcpy(nuevos_nombres, tabla->nombres, tabla->num_usuarios * sizeof(char *));
+        tabla->nombres = nuevos_nombres;
+        tabla->capacidad_nombres *= 2;
     }
-    
-    return NULL;
+    size_t longitud = strlen(usuario);
+    char *nombre = reservar_arena(tabla->arena, longitud + 1);
+    memcpy(nombre, usuario, longitud + 1);
+    uint32_t id = tabla->num_usuarios++;
+    tabla->nombres[id] = nombre;
+    tabla->huecos[posicion].hash = hash;
+    tabla->huecos[posicion].id_mas_uno = id + 1;
+    return id;
 }
 
-// Detección de patrón de fraude de tipo 5
-// La cantidad de dinero retirado (-) es mayor que la cantidad de dinero ingresado (+) por un usuario en 1 día
-void *hilo_patron_fraude_5(void *arg) {
-    int id_hilo = *((int *)arg);
-    const char *carpeta_datos;
-    char clave[100];
-    char separador1[30] = "@";
-    int cantidad;
-    int importe;
-    char mensaje[150];
-
-    carpeta_datos = obtener_valor_configuracion("PATH_FILES", "../datos");
-    const char *fichero_datos;
-    fichero_datos = obtener_valor_configuracion("INVENTORY_FILE", "file.csv");
-    char nombre_completo_fichero_datos[PATH_MAX];
-    sprintf(nombre_completo_fichero_datos, "%s/%s", carpeta_datos, fichero_datos);
-    
-    escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_5", "Hilo %02d: observando carpeta %s \n", id_hilo, carpeta_datos);
+// Inicializa un conjunto de ventanas vacío (las ventanas se reservan de la arena cuando hacen falta)
+void iniciar_ventanas_usuarios(VentanasUsuarios *ventanas, Arena *arena) {
+    ventanas->arena = arena;
+    ventanas->ventanas = NULL;
+    ventanas->capacidad = 0;
+}
 
-    // Bucle infinito para observar la carpeta
-    while (1) {
-        // Esperar a que el hilo se active
-        activarHiloPatronFraude(id_hilo, 1);
-
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_5", "Hilo %02d: se ha activado\n", id_hilo);
-        // Obtener acceso exclusivo al fichero consolidado
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_5", "Hilo %02d: esperando semáforo...\n", id_hilo);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_5", "Hilo %02d: solicitando acceso al semáforo\n", id_hilo);
-        sem_wait(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_5", "Hilo %02d: comenzando comprobación patrón fraude 5\n", id_hilo);
-
-        // Implentación de patrón_fraude_5
-        FILE *archivo_consolidado;
-        archivo_consolidado = fopen(nombre_completo_fichero_datos, "r");
-        if (archivo_consolidado == NULL) {
-
-            // No se ha conseguido abrir el fichero
-            escribirEnLog(LOG_ERROR, "hilo_patron_fraude", "Hilo %02d: error al abrir el archivo en patrón fraude 1 en fichero %s\n", id_hilo, nombre_completo_fichero_datos);
-
-            // Simular retardo
-             //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-            char mensaje[100];
-            snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_5: Hilo %02d: ", id_hilo);
-            simulaRetardo(mensaje);
-            //Liberar semáforo y continuar
-            sem_post(semaforo_consolidar_ficheros_entrada);
-            continue;
+// Devuelve la ventana de un usuario, ampliando el array de ventanas si el identificador todavía no cabe
+// El array anterior no se libera: se recupera con el resto de la arena o al compactarla
+VentanaUsuario *obtener_ventana_usuario(VentanasUsuarios *ventanas, uint32_t id_usuario) {
+    if (id_usuario >= ventanas->capacidad) {
+        uint32_t capacidad = (ventanas->capacidad > 0) ? ventanas->capacidad : CAPACIDAD_INICIAL_TABLA;
+        while (capacidad <= id_usuario) {
+            capacidad *= 2;
         }
-
-        GHashTable *usuariosPF1 = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_registroPatronF1);
-        char line[MAX_LINE_LENGTH];
-        while (fgets(line, sizeof(line), archivo_consolidado)) {
-            // Formato: SUC001;OPE0001;12/03/2024 09:47:00;12/03/2024 10:14:00;USER144;COMPRA01;1;73 €;Finalizado
-            char *sucursal = strtok(line, ";");
-            char *operacion = strtok(NULL, ";");
-            char *fechaHora1 = strtok(NULL, ";");
-            char *fechaHora2 = strtok(NULL, ";");
-            char *usuario = strtok(NULL, ";");
-            char *tipoOperacion1 = strtok(NULL, ";");
-            char *tipoOperacion2 = strtok(NULL, ";");
-            char *importeTexto = strtok(NULL, ";");
-            char *estado = strtok(NULL, ";");
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_5", "Hilo %02d: datos de registro %s;%s;%s;%s;%s;%s;%s;%s;%s;\n", id_hilo, sucursal, operacion, fechaHora1, fechaHora2, usuario, tipoOperacion1, tipoOperacion2, importeTexto, estado);
-
-            // Para este patrón la clave del diccionario va a ser usuario y fecha completa
-            importe = atoi(importeTexto);
-            if (usuario) {
-                strncpy(clave, usuario, sizeof(clave)-1);
-                strncat(clave, separador1, sizeof(clave)-1);
-                strncat(clave, eliminarUltimosCaracteres(fechaHora1, 9), sizeof(clave)-1);;
-                cantidad = importe;
-                RegistroPatron *registro = g_hash_table_lookup(usuariosPF1, clave);
-                if (registro == NULL) {
-                    registro = g_new(RegistroPatron, 1);
-                    registro->clave = g_strdup(clave);
-                    registro->cantidad = cantidad;
-                    g_hash_table_insert(usuariosPF1, registro->clave, registro);
-                } else {
-                    registro->cantidad += cantidad;
-                }
-            }
+        VentanaUsuario *nuevas = reservar_arena(ventanas->arena, capacidad * sizeof(VentanaUsuario));
+        if (ventanas->capacidad > 0) {
+            memcpy(nuevas, ventanas->ventanas, ventanas->capacidad * sizeof(VentanaUsuario));
         }
-
-        fclose(archivo_consolidado);
-
-        // Imprimir resultados del diccionario en el log
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_5", "Hilo %02d: Diccionario del patrón\n", id_hilo);
-        GHashTableIter iter;
-        gpointer clave, valor;
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_5", "Hilo %02d: Diccionario del patrón Clave: %s, Número Registros: %d\n", id_hilo, registro->clave, registro->cantidad);
-        }
-        escribirEnLog(LOG_DEBUG, "Monitor: hilo_patron_fraude_5", "Hilo %02d: Terminado diccionario del patrón\n", id_hilo);
-
-        // Eliminar fichero resultado
-        eliminarFicheroResultado(id_hilo);
-
-        // Revisar resultados que cumplen el patrón
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_5", "Hilo %02d: Registros que cumplen el patrón\n", id_hilo);
-        g_hash_table_iter_init(&iter, usuariosPF1);
-        while (g_hash_table_iter_next(&iter, &clave, &valor)) {
-            RegistroPatron *registro = (RegistroPatron *)valor;
-            // Suma de dinero ingresado y retirado es negativa
-            if (registro->cantidad < 0) {
-                escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_5", "Hilo %02d: Registro que cumple el patrón Clave: %s, Número Registros: %d\n", id_hilo, registro->clave, registro->cantidad);
-                // Componer el mensaje para el log y monitor
-                snprintf(mensaje, sizeof(mensaje), "%02d:::Registro fraude patrón 5:::Clave=%s:::Saldo negativo=%d\n", id_hilo, registro->clave, registro->cantidad);
-                escribirEnLog(LOG_GENERAL, "Monitor: hilo_patron_fraude_5", mensaje);
-                
-                // Escribir en fichero resultado patron
-                escribirResultadoPatron(id_hilo, mensaje);
-            }
+        for (uint32_t i = ventanas->capacidad; i < capacidad; i++) {
+            nuevas[i].num_instantes = 0;
+            nuevas[i].clave_alerta = CLAVE_LIBRE;
+            nuevas[i].fin_alerta = 0;
         }
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_5", "Hilo %02d: Terminados registros que cumplen el patrón\n", id_hilo);
-
-        // Liberar memoria
-        g_hash_table_destroy(usuariosPF1);
+        ventanas->ventanas = nuevas;
+        ventanas->capacidad = capacidad;
+    }
+    return &ventanas->ventanas[id_usuario];
+}
 
-        // Una vez terminado, dejamos el estado del hilo en bloqueado, así nos aseguramos de que no se vuelva a ejecutar hasta
-        // que llegue un aviso a través del pipe
+// Clave de un diccionario: identificador de usuario + número de intervalo de tiempo
+static inline uint64_t componer_clave_patron(uint32_t id_usuario, int64_t intervalo) {
+    return ((uint64_t)id_usuario << BITS_INTERVALO_CLAVE) | ((uint64_t)intervalo & MASCARA_INTERVALO_CLAVE);
+}
 
-        //Cada proceso simulará un retardo aleatorio entre SIMULATE_SLEEP_MAX y SIMULATE_SLEEP_MIN
-        snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_patron_fraude_5: Hilo %02d: ", id_hilo);
-        simulaRetardo(mensaje);
+// Número de intervalo de "segundos_intervalo" segundos al que pertenece un instante (división entera hacia abajo,
+// también para instantes anteriores a 1970)
+static inline int64_t numero_intervalo(int64_t instante, int64_t segundos_intervalo) {
+    int64_t intervalo = instante / segundos_intervalo;
+    return (instante % segundos_intervalo < 0) ? intervalo - 1 : intervalo;
+}
 
-        // Liberar acceso exclusivo al fichero consolidado
-        sem_post(semaforo_consolidar_ficheros_entrada);
-        escribirEnLog(LOG_INFO, "Monitor: hilo_patron_fraude_5", "Hilo %02d: liberado semáforo.\n", id_hilo);
+// Compone el texto de la clave de una entrada del diccionario, con el mismo formato que se ha usado siempre
+// en los resultados: USER144@12/03/2024 (día), USER144@12/03/2024 09:00 (hora), USER144@12/03/2024 09:47:00 (segundo)
+void texto_clave_patron(const TablaUsuarios *usuarios, uint64_t clave, int64_t segundos_intervalo, char *texto, size_t tamano_texto) {
+    uint32_t id_usuario = (uint32_t)(clave >> BITS_INTERVALO_CLAVE);
+    // El intervalo ocupa los bits de menos peso, con signo (se extiende el bit de signo)
+    int64_t intervalo = (int64_t)(clave << (64 - BITS_INTERVALO_CLAVE)) >> (64 - BITS_INTERVALO_CLAVE);
+    int64_t instante = intervalo * segundos_intervalo;
+    int64_t dias = numero_intervalo(instante, 86400);
+    int64_t segundos_dia = instante - dias * 86400;
+    int hora = (int)(segundos_dia / 3600);
+    int minuto = (int)((segundos_dia / 60) % 60);
+    int segundo = (int)(segundos_dia % 60);
+    int64_t anio;
+    int mes, dia;
+    civil_desde_dias(dias, &anio, &mes, &dia);
+    const char *usuario = (id_usuario < usuarios->num_usuarios) ? usuarios->nombres[id_usuario] : "";
+
+    if (segundos_intervalo >= 86400) {
+        snprintf(texto, tamano_texto, "%s@%02d/%02d/%04d", usuario, dia, mes, (int)anio);
+    } else if (segundos_intervalo >= 3600) {
+        snprintf(texto, tamano_texto, "%s@%02d/%02d/%04d %02d:00", usuario, dia, mes, (int)anio, hora);
+    } else {
+        snprintf(texto, tamano_texto, "%s@%02d/%02d/%04d %02d:%02d:%02d", usuario, dia, mes, (int)anio, hora, minuto, segundo);
     }
+}
 
-    return NULL;
+// ------------------------------------------------------------------
+// REGISTROS NUEVOS: ANILLO DE MEMORIA COMPARTIDA Y FICHERO CONSOLIDADO
+// ------------------------------------------------------------------
+/*
+    FileProcessor publica los registros consolidados, ya separados en campos, en un anillo de memoria
+    compartida (SHM_REGISTROS). Un único hilo evaluador lee cada registro una sola vez y lo aplica a todos los
+    patrones registrados. Los diccionarios de los patrones se mantienen entre activaciones y, cada vez que
+    se activa, sólo se incorporan los registros nuevos que se leen del anillo: el coste es proporcional a
+    los registros nuevos y no al tamaño del fichero consolidado.
+
+    Cada registro lleva su posición en el fichero consolidado. Si falta algún registro (el anillo se ha
+    sobrescrito antes de leerlo, no existe el anillo, o hay registros anteriores a que se creara), el hilo
+    lee del fichero consolidado sólo lo añadido desde la última posición procesada y después sigue con el
+    anillo. Si el fichero se ha truncado o sustituido por otro, los diccionarios se vacían y se empieza de cero.
+
+    Las estructuras del anillo y su lectura están en Comun/AnilloRegistros.c, que comparte con FileProcessor.
+*/
+
+// Anillo proyectado (sólo lectura)
+AnilloRegistros *anillo_registros = NULL;
+size_t tamano_anillo_registros = 0;
+int conexion_anillo = 0;            // Se incrementa cada vez que se conecta a un anillo nuevo
+
+// Evaluador de un patrón de fraude: su diccionario y las funciones que lo actualizan con cada registro
+// y que comprueban si una entrada del diccionario cumple el patrón
+typedef struct EVALUADOR_PATRON {
+    int numero;                                 // Número del patrón (1..NUM_PATRONES_FRAUDE)
+    int64_t segundos_intervalo;                 // Intervalo de tiempo de las claves: 1 (segundo), 3600 (hora) o 86400 (día)
+    void (*aplicar)(struct EVALUADOR_PATRON *evaluador, uint32_t id_usuario, int64_t instante, const RegistroTransaccion *registro);
+    int (*comprobar)(const RegistroPatron *registro, const char *clave, char *mensaje, size_t tamano_mensaje);
+    DiccionarioPatron diccionario;              // Diccionario del patrón
+    VentanasUsuarios ventanas;                  // Ventanas deslizantes por usuario (sólo las usa el patrón 1)
+    int64_t cierre_minimo;                      // Cierre más temprano de las entradas del diccionario
+    int fd_cerradas;                            // Fichero de alertas cerradas (-1 si no está abierto)
+    uint64_t bytes_cerradas;                    // Bytes válidos del fichero de alertas cerradas (lo que haya después se descarta)
+    int cerradas_sin_sincronizar;               // Hay bytes escritos que todavía pueden no estar en disco
+    TextoResultado cerradas_pendientes;         // Alertas cerradas que todavía no se han escrito en su fichero
+    TextoResultado resultado;                   // Resultados de las entradas abiertas de la última comprobación
+} EvaluadorPatron;
+
+// Clave del diccionario de un evaluador para un usuario y un instante: el intervalo del evaluador que lo contiene
+static inline uint64_t clave_evaluador(const EvaluadorPatron *evaluador, uint32_t id_usuario, int64_t instante) {
+    return componer_clave_patron(id_usuario, numero_intervalo(instante, evaluador->segundos_intervalo));
+}
+
+// Fija el instante de cierre de una entrada del diccionario de un evaluador
+static inline void fijar_cierre_registro(EvaluadorPatron *evaluador, RegistroPatron *registro, int64_t cierre) {
+    registro->cierre = cierre;
+    if (cierre < evaluador->cierre_minimo) {
+        evaluador->cierre_minimo = cierre;
+    }
 }
 
+// Devuelve la entrada del diccionario de un evaluador para un usuario y un instante, que se cierra al terminar
+// el intervalo del evaluador que contiene el instante
+RegistroPatron *obtener_registro_evaluador(EvaluadorPatron *evaluador, uint32_t id_usuario, int64_t instante) {
+    int64_t intervalo = numero_intervalo(instante, evaluador->segundos_intervalo);
+    RegistroPatron *registro = obtener_registro_patron(&evaluador->diccionario, componer_clave_patron(id_usuario, intervalo));
+    fijar_cierre_registro(evaluador, registro, (intervalo + 1) * evaluador->segundos_intervalo);
+    return registro;
+}
 
+// Estado del lector de registros que se mantiene entre activaciones
+// Es común a todos los patrones: cada registro se lee y se separa en campos una sola vez y se
+// aplica a todos los evaluadores registrados
+typedef struct ESTADO_LECTOR {
+    EvaluadorPatron *evaluadores;               // Evaluadores a los que se aplica cada registro
+    int num_evaluadores;
+    TablaUsuarios usuarios;                     // Usuarios que aparecen en las claves de los diccionarios
+    Arena arena;                                // Memoria de los diccionarios y de la tabla de usuarios
+    size_t bytes_compactados;                   // Bytes en uso de la arena después de la última compactación
+    uint64_t offset_procesado;                  // Bytes del fichero consolidado ya incorporados a los diccionarios
+    dev_t dispositivo;                          // Identidad (dispositivo + inodo) del fichero consolidado procesado,
+    ino_t inodo;                                // para detectar que se ha sustituido por otro (rotación)
+    uint64_t siguiente_registro;                // Número del siguiente registro a leer del anillo
+    int conexion_anillo;                        // Conexión al anillo a la que se refiere siguiente_registro
+    int64_t instante_maximo;                    // Instante más reciente leído (INSTANTE_NO_VALIDO si todavía ninguno)
+    uint64_t registros_tardios;                 // Registros ignorados por llegar después de la marca de agua
+    uint64_t secuencia_alertas;                 // Última alerta del flujo de alertas según el punto de control
+} EstadoLector;
+
+// Marca de agua: los registros anteriores llegan tarde y las entradas que se cierran antes ya no pueden cambiar
+static inline int64_t marca_agua(const EstadoLector *estado) {
+    if (estado->instante_maximo == INSTANTE_NO_VALIDO) {
+        return INSTANTE_NO_VALIDO;
+    }
+    return estado->instante_maximo - retraso_permitido;
+}
 
-// Función que crea los hilos de detección de los patrones de fraude
-int crear_hilos_patrones_fraude() {
-    // Obtener el número de hilos a crear
-    int num_hilos; 
-    num_hilos = NUM_PATRONES_FRAUDE; // 1 hilo por cada patrón de fraude
-    escribirEnLog(LOG_INFO, "Monitor: crea_hilos_patrones_fraude", "Necesario crear %02d hilos de patrones de fraude\n", num_hilos);
-
-    // Dimensionar pool de hilos observadores
-    pthread_t tid[num_hilos];
-    int id[num_hilos];
-
-    // Crear los hilos de detección de patrones de fraude
-    // Esta variable servirá para apuntar a la función de implementación del hilo
-    void *(*ptr_hilo_patron_fraude)(void *);
-    for (int i = 0; i < num_hilos; i++) {
-        id[i] = i + 1; //id[i] tiene el número de hilo
-
-        // Ponemos el procesado de este hilo a 1: de momento está bloqueado el mutex
-        activarHiloPatronFraude(id[i], 1);
-
-        // Identificar la función para la creación del hilo según sea el valor de i
-        if (id[i]==1) {
-            ptr_hilo_patron_fraude = &hilo_patron_fraude_1;
-        } else if (id[i]==2) {
-            ptr_hilo_patron_fraude = &hilo_patron_fraude_2;
-        } else if (id[i]==3) {
-            ptr_hilo_patron_fraude = &hilo_patron_fraude_3;
-        } else if (id[i]==4) {
-            ptr_hilo_patron_fraude = &hilo_patron_fraude_4;
-        } else if (id[i]==5) {
-            ptr_hilo_patron_fraude = &hilo_patron_fraude_5;
-        }    
-
-        // Crear el hilo que apunta a la función identificada anteriormente
-        escribirEnLog(LOG_INFO, "Monitor: crea_hilos_patrones_fraude", "Creado hilo de detección de patrón de fraude %02d\n", id[i]);
-        if (pthread_create(&tid[i], NULL, ptr_hilo_patron_fraude, (void *)&id[i]) != 0) {
-            escribirEnLog(LOG_ERROR, "Monitor: crea_hilos_patrones_fraude", "Error al crear el hilo de de detección de patrón de fraude %02d\n", id[i]);
-            exit(EXIT_FAILURE);
-        }
+// Devuelve el anillo de registros, conectándose a él si hace falta
+// Si FileProcessor lo ha descartado (magia a 0) se libera y se intenta conectar al nuevo
+// Devuelve NULL si no hay anillo disponible
+// Sólo lo utiliza el hilo evaluador de patrones, por lo que no necesita sincronización
+AnilloRegistros *conectar_anillo_registros() {
+    if (anillo_registros != NULL && !anillo_registros_vigente(anillo_registros)) {
+        munmap(anillo_registros, tamano_anillo_registros);
+        anillo_registros = NULL;
+        tamano_anillo_registros = 0;
+        escribirEnLog(LOG_INFO, "Monitor: conectar_anillo_registros", "Anillo de registros descartado por FileProcessor\n");
     }
 
-    // Desanclar los hilos para que se ejecuten de forma independiente
-    for (int i = 0;i < num_hilos; i++) {
-        if (pthread_detach(tid[i]) != 0) {
-            escribirEnLog(LOG_ERROR, "Monitor: crea_hilos_patrones_fraude", "Error al desanclar el hilo de observación detección de patrón de fraude 1");
-            exit(EXIT_FAILURE);
+    if (anillo_registros == NULL) {
+        const char *nombre_anillo = obtener_configuracion()->nombre_anillo_registros;
+        anillo_registros = proyectar_anillo_registros(nombre_anillo, &tamano_anillo_registros);
+        if (anillo_registros != NULL) {
+            conexion_anillo++;
+            escribirEnLog(LOG_INFO, "Monitor: conectar_anillo_registros", "Conectado al anillo %s de %u registros\n", nombre_anillo, anillo_registros->capacidad);
         }
     }
 
-    escribirEnLog(LOG_INFO, "Monitor: crea_hilos_patrones_fraude", "hilos de detección de patrones de fraude creados\n");
-    return 0;
+    return anillo_registros;
+}
+
+// Pasa a un registro de tamaño fijo la vista de una línea del fichero consolidado
+// Formato: SU001;OPE0001;12/03/2024 09:47:00;12/03/2024 10:14:00;USER144;COMPRA01;1;73 €;Finalizado
+void rellenar_registro(const VistaRegistro *vista, RegistroTransaccion *registro) {
+    memset(registro, 0, sizeof(RegistroTransaccion));
+    copiar_campo(registro->sucursal, sizeof(registro->sucursal), vista->campos[CAMPO_SUCURSAL].texto, vista->campos[CAMPO_SUCURSAL].longitud);
+    copiar_campo(registro->operacion, sizeof(registro->operacion), vista->campos[CAMPO_OPERACION].texto, vista->campos[CAMPO_OPERACION].longitud);
+    copiar_campo(registro->fechaHora1, sizeof(registro->fechaHora1), vista->campos[CAMPO_FECHA_HORA1].texto, vista->campos[CAMPO_FECHA_HORA1].longitud);
+    copiar_campo(registro->fechaHora2, sizeof(registro->fechaHora2), vista->campos[CAMPO_FECHA_HORA2].texto, vista->campos[CAMPO_FECHA_HORA2].longitud);
+    copiar_campo(registro->usuario, sizeof(registro->usuario), vista->campos[CAMPO_USUARIO].texto, vista->campos[CAMPO_USUARIO].longitud);
+    copiar_campo(registro->tipoOperacion1, sizeof(registro->tipoOperacion1), vista->campos[CAMPO_TIPO_OPERACION1].texto, vista->campos[CAMPO_TIPO_OPERACION1].longitud);
+    registro->instante1 = vista->instante1;
+    registro->instante2 = vista->instante2;
+    registro->tipoOperacion2 = vista->tipo_operacion;
+    registro->importe = vista->importe;
+    copiar_campo(registro->estado, sizeof(registro->estado), vista->campos[CAMPO_ESTADO].texto, vista->campos[CAMPO_ESTADO].longitud);
+    registro->codigoEstado = vista->estado;
+}
+
+// Deja vacíos los diccionarios de todos los patrones, la tabla de usuarios y los ficheros de alertas cerradas
+// La memoria anterior se recupera de una vez reiniciando la arena
+void iniciar_diccionarios(EstadoLector *estado) {
+    reiniciar_arena(&estado->arena);
+    iniciar_tabla_usuarios(&estado->usuarios, &estado->arena, CAPACIDAD_INICIAL_TABLA);
+    for (int i = 0; i < estado->num_evaluadores; i++) {
+        EvaluadorPatron *evaluador = &estado->evaluadores[i];
+        iniciar_diccionario(&evaluador->diccionario, &estado->arena, CAPACIDAD_INICIAL_TABLA);
+        iniciar_ventanas_usuarios(&evaluador->ventanas, &estado->arena);
+        evaluador->cierre_minimo = INT64_MAX;
+        evaluador->bytes_cerradas = 0;
+        evaluador->cerradas_pendientes.longitud = 0;
+        if (evaluador->fd_cerradas != -1 && ftruncate(evaluador->fd_cerradas, 0) == -1) {
+            escribirEnLog(LOG_ERROR, "Monitor: iniciar_diccionarios", "Patrón %02d: error al vaciar el fichero de alertas cerradas\n", evaluador->numero);
+        }
+    }
+    estado->bytes_compactados = estado->arena.bytes_en_uso;
+    estado->instante_maximo = INSTANTE_NO_VALIDO;
+    estado->registros_tardios = 0;
+}
+
+// La arena se compacta cuando ocupa más de FACTOR_COMPACTACION_ARENA veces lo que ocupaba después de la
+// última compactación (y al menos MINIMO_COMPACTACION_ARENA bytes): el coste de copiar lo vivo se reparte
+// entre todo lo reservado desde entonces
+#define FACTOR_COMPACTACION_ARENA 2
+#define MINIMO_COMPACTACION_ARENA (4 * TAMANO_BLOQUE_ARENA)
+
+// Indica si la ventana de un usuario del patrón 1 todavía puede influir en alguna alerta
+// Los registros que lleguen no pueden ser anteriores a la marca de agua: si el instante más reciente de la
+// ventana está a una hora o más antes de ella, la ventana se comporta igual que una vacía
+static inline int ventana_viva(const VentanaUsuario *ventana, int64_t marca) {
+    return ventana->num_instantes > 0 &&
+           (marca == INSTANTE_NO_VALIDO || ventana->instantes[ventana->num_instantes - 1] > marca - SEGUNDOS_VENTANA_PATRON_1);
+}
+
+// Copia a una arena nueva las entradas abiertas de los diccionarios, las ventanas vivas y los usuarios que
+// aparecen en ellas, y libera la arena anterior
+// Los usuarios se renumeran en el mismo orden y las tablas se crean ya con la capacidad que necesitan
+void compactar_diccionarios(EstadoLector *estado) {
+    int64_t marca = marca_agua(estado);
+    uint32_t num_usuarios = estado->usuarios.num_usuarios;
+
+    // Identificador nuevo de cada usuario (UINT32_MAX si ya no aparece en ninguna entrada ni ventana)
+    uint32_t *nuevo_id = malloc(((num_usuarios > 0) ? num_usuarios : 1) * sizeof(uint32_t));
+    if (nuevo_id == NULL) {
+        escribirEnLog(LOG_WARNING, "Monitor: compactar_diccionarios", "No hay memoria para compactar los diccionarios\n");
+        return;
+    }
+    for (uint32_t i = 0; i < num_usuarios; i++) {
+        nuevo_id[i] = UINT32_MAX;
+    }
+    for (int i = 0; i < estado->num_evaluadores; i++) {
+        EvaluadorPatron *evaluador = &estado->evaluadores[i];
+        for (size_t j = 0; j < evaluador->diccionario.capacidad; j++) {
+            uint64_t clave = evaluador->diccionario.entradas[j].clave;
+            if (clave != CLAVE_LIBRE) {
+                nuevo_id[clave >> BITS_INTERVALO_CLAVE] = 0;
+            }
+        }
+        uint32_t num_ventanas = (evaluador->ventanas.capacidad < num_usuarios) ? evaluador->ventanas.capacidad : num_usuarios;
+        for (uint32_t j = 0; j < num_ventanas; j++) {
+            if (ventana_viva(&evaluador->ventanas.ventanas[j], marca)) {
+                nuevo_id[j] = 0;
+            }
+        }
+    }
+    uint32_t num_vivos = 0;
+    for (uint32_t i = 0; i < num_usuarios; i++) {
+        num_vivos += (nuevo_id[i] != UINT32_MAX);
+    }
+
+    // Las estructuras anteriores siguen en los bloques de la arena anterior hasta el final
+    Arena arena_anterior = estado->arena;
+    TablaUsuarios usuarios_anteriores = estado->usuarios;
+    iniciar_arena(&estado->arena, arena_anterior.tamano_bloque);
+    iniciar_tabla_usuarios(&estado->usuarios, &estado->arena, (uint32_t)capacidad_tabla(num_vivos));
+    for (uint32_t i = 0; i < num_usuarios; i++) {
+        if (nuevo_id[i] != UINT32_MAX) {
+            nuevo_id[i] = obtener_id_usuario(&estado->usuarios, usuarios_anteriores.nombres[i]);
+        }
+    }
+
+    for (int i = 0; i < estado->num_evaluadores; i++) {
+        EvaluadorPatron *evaluador = &estado->evaluadores[i];
+        DiccionarioPatron diccionario_anterior = evaluador->diccionario;
+        VentanasUsuarios ventanas_anteriores = evaluador->ventanas;
+
+        iniciar_diccionario(&evaluador->diccionario, &estado->arena, capacidad_tabla(diccionario_anterior.num_entradas));
+        for (size_t j = 0; j < diccionario_anterior.capacidad; j++) {
+            const RegistroPatron *registro = &diccionario_anterior.entradas[j];
+            if (registro->clave == CLAVE_LIBRE) {
+                continue;
+            }
+            uint64_t clave = ((uint64_t)nuevo_id[registro->clave >> BITS_INTERVALO_CLAVE] << BITS_INTERVALO_CLAVE) | (registro->clave & MASCARA_INTERVALO_CLAVE);
+            RegistroPatron *nuevo = obtener_registro_patron(&evaluador->diccionario, clave);
+            *nuevo = *registro;
+            nuevo->clave = clave;
+        }
+
+        iniciar_ventanas_usuarios(&evaluador->ventanas, &estado->arena);
+        if (ventanas_anteriores.capacidad > 0 && num_vivos > 0) {
+            // Reservar de una vez las ventanas de todos los usuarios
+            obtener_ventana_usuario(&evaluador->ventanas, num_vivos - 1);
+        }
+        uint32_t num_ventanas = (ventanas_anteriores.capacidad < num_usuarios) ? ventanas_anteriores.capacidad : num_usuarios;
+        for (uint32_t j = 0; j < num_ventanas; j++) {
+            if (!ventana_viva(&ventanas_anteriores.ventanas[j], marca)) {
+                continue;
+            }
+            VentanaUsuario *ventana = obtener_ventana_usuario(&evaluador->ventanas, nuevo_id[j]);
+            *ventana = ventanas_anteriores.ventanas[j];
+            if (ventana->clave_alerta != CLAVE_LIBRE) {
+                ventana->clave_alerta = ((uint64_t)nuevo_id[j] << BITS_INTERVALO_CLAVE) | (ventana->clave_alerta & MASCARA_INTERVALO_CLAVE);
+            }
+        }
+    }
+
+    free(nuevo_id);
+    size_t bytes_anteriores = arena_anterior.bytes_en_uso;
+    liberar_arena(&arena_anterior);
+    // free no siempre devuelve al sistema los bloques liberados: malloc_trim lo fuerza
+    malloc_trim(0);
+    estado->bytes_compactados = estado->arena.bytes_en_uso;
+    escribirEnLog(LOG_INFO, "Monitor: compactar_diccionarios", "Diccionarios compactados: de %zu a %zu bytes, de %u a %u usuarios\n", bytes_anteriores, estado->arena.bytes_en_uso, num_usuarios, num_vivos);
+}
+
+// Tamaño del final del flujo de alertas que se lee al abrirlo para recuperar el último número de secuencia
+#define TAMANO_COLA_FLUJO_ALERTAS 1024
+
+// Huella de un mensaje (FNV-1a de 64 bits) para saber si ha cambiado desde la última vez que se notificó
+// Nunca es 0, que indica que la entrada no se ha notificado
+static inline uint64_t huella_mensaje(const char *mensaje) {
+    uint64_t huella = UINT64_C(0xcbf29ce484222325);
+    for (const unsigned char *c = (const unsigned char *)mensaje; *c != '\0'; c++) {
+        huella ^= *c;
+        huella *= UINT64_C(0x100000001b3);
+    }
+    return (huella == 0) ? 1 : huella;
+}
+
+// Abre el flujo de alertas para añadir y recupera el número de la última alerta escrita de su última línea
+// completa (el del punto de control puede ser anterior si Monitor terminó después de escribir alertas)
+// Si la última línea está incompleta se termina, para que la siguiente alerta empiece en una línea nueva
+int abrir_flujo_alertas(const char *nombre_fichero, uint64_t secuencia_punto_control) {
+    flujo_alertas.ultima_secuencia = secuencia_punto_control;
+    flujo_alertas.fd = open(nombre_fichero, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (flujo_alertas.fd == -1) {
+        escribirEnLog(LOG_ERROR, "Monitor: abrir_flujo_alertas", "Error al abrir el flujo de alertas %s\n", nombre_fichero);
+        return -1;
+    }
+
+    struct stat info;
+    char cola[TAMANO_COLA_FLUJO_ALERTAS + 1];
+    ssize_t leidos = 0;
+    if (fstat(flujo_alertas.fd, &info) == 0 && info.st_size > 0) {
+        off_t inicio = (info.st_size > TAMANO_COLA_FLUJO_ALERTAS) ? info.st_size - TAMANO_COLA_FLUJO_ALERTAS : 0;
+        leidos = pread(flujo_alertas.fd, cola, info.st_size - inicio, inicio);
+    }
+    if (leidos > 0) {
+        cola[leidos] = '\0';
+        if (cola[leidos - 1] != '\n') {
+            if (write(flujo_alertas.fd, "\n", 1) != 1) {
+                escribirEnLog(LOG_ERROR, "Monitor: abrir_flujo_alertas", "Error al terminar la última línea del flujo de alertas %s\n", nombre_fichero);
+            }
+            // La línea incompleta no cuenta
+            while (leidos > 0 && cola[leidos - 1] != '\n') {
+                leidos--;
+            }
+        }
+        // Principio de la última línea completa (si no cabe entera en lo leído no se usa)
+        ssize_t inicio_linea = leidos - 1;
+        while (inicio_linea > 0 && cola[inicio_linea - 1] != '\n') {
+            inicio_linea--;
+        }
+        if (leidos > 0 && (inicio_linea > 0 || leidos == info.st_size)) {
+            uint64_t secuencia = strtoull(cola + inicio_linea, NULL, 10);
+            if (secuencia > flujo_alertas.ultima_secuencia) {
+                flujo_alertas.ultima_secuencia = secuencia;
+            }
+        }
+    }
+
+    escribirEnLog(LOG_INFO, "Monitor: abrir_flujo_alertas", "Flujo de alertas %s: última alerta %llu\n", nombre_fichero, (unsigned long long)flujo_alertas.ultima_secuencia);
+    return 0;
+}
+
+// Añade al flujo de alertas el mensaje de una entrada que cumple el patrón si no se había notificado o si ha
+// cambiado desde la última vez: sólo se compone texto para las alertas nuevas
+void notificar_alerta(RegistroPatron *registro, const char *mensaje) {
+    uint64_t huella = huella_mensaje(mensaje);
+    if (huella == registro->huella_notificada) {
+        return;
+    }
+    const char *tipo = (registro->huella_notificada == 0) ? "NUEVA" : "ACTUALIZADA";
+    registro->huella_notificada = huella;
+
+    char cabecera[40];
+    int longitud = snprintf(cabecera, sizeof(cabecera), "%llu:::%s:::", (unsigned long long)++flujo_alertas.ultima_secuencia, tipo);
+    anadir_texto_resultado(&flujo_alertas.pendiente, cabecera, longitud);
+    anadir_texto_resultado(&flujo_alertas.pendiente, mensaje, strlen(mensaje));
+}
+
+// Escribe de una vez en el flujo de alertas las alertas de la comprobación
+// Con O_APPEND cada write se añade entero al final, así que quien lo lee nunca ve una alerta a medias
+// Devuelve 1 si había alertas que escribir y 0 si no
+int volcar_flujo_alertas() {
+    TextoResultado *pendiente = &flujo_alertas.pendiente;
+    if (pendiente->longitud == 0) {
+        return 0;
+    }
+    if (flujo_alertas.fd != -1) {
+        size_t escritos = 0;
+        while (escritos < pendiente->longitud) {
+            ssize_t resultado = write(flujo_alertas.fd, pendiente->datos + escritos, pendiente->longitud - escritos);
+            if (resultado == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                escribirEnLog(LOG_ERROR, "Monitor: volcar_flujo_alertas", "Error al escribir en el flujo de alertas\n");
+                break;
+            }
+            escritos += resultado;
+        }
+    }
+    escribirEnLog(LOG_DEBUG, "Monitor: volcar_flujo_alertas", "Escritas alertas hasta la %llu\n", (unsigned long long)flujo_alertas.ultima_secuencia);
+    pendiente->longitud = 0;
+    return 1;
+}
+
+// Añade el resultado de una entrada cerrada a las alertas cerradas de un evaluador que quedan por escribir
+// en su fichero (volcar_alertas_cerradas)
+void anadir_alerta_cerrada(EvaluadorPatron *evaluador, const char *mensaje) {
+    anadir_texto_resultado(&evaluador->cerradas_pendientes, mensaje, strlen(mensaje));
+}
+
+// Nombre del fichero de alertas cerradas de un patrón: el del fichero resultado terminado en ".cerradas"
+void nombre_alertas_cerradas(int patron, char *nombre, size_t tamano) {
+    const Configuracion *configuracion = obtener_configuracion();
+    snprintf(nombre, tamano, "%s/%s%02d.cerradas", configuracion->carpeta_datos, configuracion->raiz_fichero_resultado, patron);
+}
+
+// Abre los ficheros de alertas cerradas de todos los evaluadores y descarta lo que se escribió en ellos después
+// del punto de control restaurado (bytes_cerradas de cada evaluador)
+// Si a alguno le falta parte de lo que indica el punto de control, el estado restaurado no es coherente con
+// ellos: se vacían los diccionarios y se vuelve a procesar el fichero consolidado desde el principio
+void abrir_alertas_cerradas(EstadoLector *estado) {
+    int completos = 1;
+    for (int i = 0; i < estado->num_evaluadores; i++) {
+        EvaluadorPatron *evaluador = &estado->evaluadores[i];
+        char nombre[PATH_MAX];
+        nombre_alertas_cerradas(evaluador->numero, nombre, sizeof(nombre));
+        evaluador->fd_cerradas = open(nombre, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        struct stat info;
+        if (evaluador->fd_cerradas == -1 || fstat(evaluador->fd_cerradas, &info) == -1) {
+            // Sin fichero, las alertas cerradas se quedan pendientes en memoria y no se guarda el punto de control
+            escribirEnLog(LOG_ERROR, "Monitor: abrir_alertas_cerradas", "Error al abrir el fichero de alertas cerradas %s\n", nombre);
+            completos = completos && (evaluador->bytes_cerradas == 0);
+        } else if ((uint64_t)info.st_size < evaluador->bytes_cerradas) {
+            escribirEnLog(LOG_WARNING, "Monitor: abrir_alertas_cerradas", "Al fichero de alertas cerradas %s le faltan alertas del punto de control\n", nombre);
+            completos = 0;
+        } else if ((uint64_t)info.st_size > evaluador->bytes_cerradas && ftruncate(evaluador->fd_cerradas, evaluador->bytes_cerradas) == -1) {
+            escribirEnLog(LOG_ERROR, "Monitor: abrir_alertas_cerradas", "Error al descartar las alertas cerradas posteriores al punto de control en %s\n", nombre);
+            completos = 0;
+        }
+    }
+
+    if (!completos) {
+        escribirEnLog(LOG_WARNING, "Monitor: abrir_alertas_cerradas", "Alertas cerradas incompletas, se vuelve a procesar el fichero consolidado desde el principio\n");
+        iniciar_diccionarios(estado);
+        estado->offset_procesado = 0;
+    }
+}
+
+// Escribe a continuación de los bytes válidos del fichero de alertas cerradas de un evaluador las que tiene pendientes
+// Si la escritura falla, las alertas siguen pendientes (se vuelve a intentar en la siguiente comprobación) y lo
+// que se haya llegado a escribir se quita del fichero; aunque no se pueda quitar, sólo cuentan los bytes válidos
+// y la siguiente escritura lo sobrescribe
+// Devuelve 0 si no queda ninguna pendiente y -1 si no
+int volcar_alertas_cerradas(EvaluadorPatron *evaluador) {
+    TextoResultado *pendientes = &evaluador->cerradas_pendientes;
+    if (pendientes->longitud == 0) {
+        return 0;
+    }
+    if (evaluador->fd_cerradas == -1) {
+        return -1;
+    }
+
+    size_t escritos = 0;
+    while (escritos < pendientes->longitud) {
+        ssize_t resultado = pwrite(evaluador->fd_cerradas, pendientes->datos + escritos, pendientes->longitud - escritos, evaluador->bytes_cerradas + escritos);
+        if (resultado == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            escribirEnLog(LOG_ERROR, "Monitor: volcar_alertas_cerradas", "Patrón %02d: error al escribir en el fichero de alertas cerradas\n", evaluador->numero);
+            if (ftruncate(evaluador->fd_cerradas, evaluador->bytes_cerradas) == -1) {
+                escribirEnLog(LOG_ERROR, "Monitor: volcar_alertas_cerradas", "Patrón %02d: error al quitar la escritura incompleta del fichero de alertas cerradas\n", evaluador->numero);
+            }
+            return -1;
+        }
+        escritos += resultado;
+    }
+    evaluador->bytes_cerradas += pendientes->longitud;
+    evaluador->cerradas_sin_sincronizar = 1;
+    pendientes->longitud = 0;
+    return 0;
+}
+
+// Cierra las entradas del diccionario de un evaluador que terminan antes de la marca de agua: si cumplen el
+// patrón su resultado se añade a las alertas cerradas, y se borran del diccionario
+// Sólo se recorre el diccionario si alguna entrada puede haberse cerrado
+// Devuelve el número de entradas cerradas
+size_t cerrar_entradas_vencidas(EvaluadorPatron *evaluador, const TablaUsuarios *usuarios, int64_t marca) {
+    DiccionarioPatron *diccionario = &evaluador->diccionario;
+    if (evaluador->cierre_minimo > marca) {
+        return 0;
+    }
+
+    char mensaje[150];
+    char clave[100];
+    size_t num_cerradas = 0;
+    int64_t cierre_minimo = INT64_MAX;
+    size_t posicion = 0;
+    while (posicion < diccionario->capacidad) {
+        RegistroPatron *registro = &diccionario->entradas[posicion];
+        if (registro->clave == CLAVE_LIBRE) {
+            posicion++;
+            continue;
+        }
+        if (registro->cierre > marca) {
+            if (registro->cierre < cierre_minimo) {
+                cierre_minimo = registro->cierre;
+            }
+            posicion++;
+            continue;
+        }
+
+        texto_clave_patron(usuarios, registro->clave, evaluador->segundos_intervalo, clave, sizeof(clave));
+        if (evaluador->comprobar(registro, clave, mensaje, sizeof(mensaje))) {
+            // La entrada puede haber cambiado en esta misma comprobación antes de cerrarse
+            notificar_alerta(registro, mensaje);
+            anadir_alerta_cerrada(evaluador, mensaje);
+        }
+        // Al borrar, otra entrada puede ocupar esta posición: se vuelve a mirar la misma posición
+        borrar_registro_patron(diccionario, posicion);
+        num_cerradas++;
+    }
+    evaluador->cierre_minimo = cierre_minimo;
+
+    escribirEnLog(LOG_DEBUG, "Monitor: cerrar_entradas_vencidas", "Patrón %02d: %zu entradas cerradas, %zu abiertas\n", evaluador->numero, num_cerradas, diccionario->num_entradas);
+    return num_cerradas;
+}
+
+// Aplica un registro a todos los evaluadores de patrones (los registros sin usuario o sin fecha-hora válida,
+// como las líneas vacías, y los que llegan después de la marca de agua se ignoran)
+// La fecha-hora ya viene decodificada en el registro y el usuario se busca una sola vez: cada evaluador
+// compone su clave con ellos (clave_evaluador) o los usa directamente, como la ventana del patrón 1
+void aplicar_registro_evaluadores(EstadoLector *estado, const RegistroTransaccion *registro) {
+    if (registro->usuario[0] == '\0') {
+        return;
+    }
+    int64_t instante = registro->instante1;
+    if (instante == INSTANTE_NO_VALIDO) {
+        escribirEnLog(LOG_WARNING, "Monitor: aplicar_registro_evaluadores", "Registro %s con fecha-hora no válida: %s\n", registro->operacion, registro->fechaHora1);
+        return;
+    }
+    if (instante > instante_limite_futuro) {
+        escribirEnLog(LOG_WARNING, "Monitor: aplicar_registro_evaluadores", "Registro %s con fecha-hora futura, fuera del adelanto permitido: %s\n", registro->operacion, registro->fechaHora1);
+        return;
+    }
+    if (instante < marca_agua(estado)) {
+        escribirEnLog(LOG_DEBUG, "Monitor: aplicar_registro_evaluadores", "Registro %s fuera del retraso permitido: %s\n", registro->operacion, registro->fechaHora1);
+        estado->registros_tardios++;
+        return;
+    }
+    if (instante > estado->instante_maximo) {
+        estado->instante_maximo = instante;
+    }
+    uint32_t id_usuario = obtener_id_usuario(&estado->usuarios, registro->usuario);
+    for (int i = 0; i < estado->num_evaluadores; i++) {
+        EvaluadorPatron *evaluador = &estado->evaluadores[i];
+        evaluador->aplicar(evaluador, id_usuario, instante, registro);
+    }
+}
+
+// Calcula el instante límite de los registros: fecha-hora actual del reloj (local, en la misma escala que las
+// fechas-hora de los registros) más el adelanto permitido
+int64_t calcular_limite_futuro(int64_t adelanto_permitido) {
+    time_t ahora = time(NULL);
+    struct tm local;
+    localtime_r(&ahora, &local);
+    int64_t instante_actual = dias_desde_civil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 86400 +
+                              local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+    return instante_actual + adelanto_permitido;
+}
+
+// Comprueba que el fichero consolidado sigue siendo el que se ha procesado hasta ahora
+// Si se ha truncado (es más corto que lo procesado) o se ha sustituido por otro (rotación, otro inodo),
+// los diccionarios ya no corresponden al fichero y se empieza de cero
+// info es NULL si el fichero no existe
+void comprobar_fichero_consolidado(EstadoLector *estado, const struct stat *info) {
+    int reiniciar;
+    if (info == NULL) {
+        reiniciar = (estado->offset_procesado > 0);
+    } else {
+        reiniciar = (estado->offset_procesado > 0) &&
+                    (info->st_dev != estado->dispositivo || info->st_ino != estado->inodo || (uint64_t)info->st_size < estado->offset_procesado);
+        estado->dispositivo = info->st_dev;
+        estado->inodo = info->st_ino;
+    }
+
+    if (reiniciar) {
+        escribirEnLog(LOG_WARNING, "Monitor: comprobar_fichero_consolidado", "El fichero consolidado se ha truncado o sustituido, se vuelve a procesar desde el principio\n");
+        iniciar_diccionarios(estado);
+        estado->offset_procesado = 0;
+    }
+}
+
+// Incorpora a los diccionarios los registros añadidos al fichero consolidado desde la última lectura
+// Se lee a partir de offset_procesado, de modo que el coste depende de lo nuevo y no del tamaño del fichero.
+// Se hace una única pasada con un único bloqueo de lectura para todos los patrones
+// Devuelve el número de registros leídos
+int leer_fichero_consolidado(EstadoLector *estado, const char *nombre_fichero) {
+    FILE *archivo_consolidado = fopen(nombre_fichero, "r");
+    if (archivo_consolidado == NULL) {
+        // Todavía no hay fichero consolidado (o se ha borrado): no hay registros
+        escribirEnLog(LOG_WARNING, "Monitor: leer_fichero_consolidado", "No se ha podido abrir el fichero %s\n", nombre_fichero);
+        comprobar_fichero_consolidado(estado, NULL);
+        return 0;
+    }
+
+    // Bloqueo de lectura compartido sobre el fichero consolidado
+    escribirEnLog(LOG_INFO, "Monitor: leer_fichero_consolidado", "Solicitando bloqueo de lectura del fichero consolidado\n");
+    bloquear_fichero(fileno(archivo_consolidado), F_RDLCK);
+
+    struct stat info;
+    fstat(fileno(archivo_consolidado), &info);
+    comprobar_fichero_consolidado(estado, &info);
+
+    // Continuar donde se quedó la lectura anterior: se proyecta en memoria sólo lo añadido desde entonces
+    // (desde el comienzo de su página) y se separa en campos directamente sobre la proyección
+    int num_registros = 0;
+    if ((uint64_t)info.st_size > estado->offset_procesado) {
+        uint64_t tamano_pagina = (uint64_t)sysconf(_SC_PAGESIZE);
+        uint64_t inicio_proyeccion = estado->offset_procesado - (estado->offset_procesado % tamano_pagina);
+        size_t tamano_proyeccion = (size_t)((uint64_t)info.st_size - inicio_proyeccion);
+        char *datos = mmap(NULL, tamano_proyeccion, PROT_READ, MAP_PRIVATE, fileno(archivo_consolidado), (off_t)inicio_proyeccion);
+        if (datos == MAP_FAILED) {
+            escribirEnLog(LOG_ERROR, "Monitor: leer_fichero_consolidado", "Error al proyectar en memoria el fichero %s\n", nombre_fichero);
+        } else {
+            madvise(datos, tamano_proyeccion, MADV_SEQUENTIAL);
+            const char *linea = datos + (estado->offset_procesado - inicio_proyeccion);
+            const char *fin = datos + tamano_proyeccion;
+            while (linea < fin) {
+                VistaRegistro vista;
+                const char *siguiente = parsear_registro_csv(linea, fin, CAMPO_SUCURSAL, &vista);
+                // Una línea sin salto de línea final está incompleta: se leerá entera la próxima vez
+                if (!vista.completa) {
+                    break;
+                }
+                RegistroTransaccion registro;
+                rellenar_registro(&vista, &registro);
+                aplicar_registro_evaluadores(estado, &registro);
+                estado->offset_procesado += vista.longitud;
+                num_registros++;
+                linea = siguiente;
+            }
+            munmap(datos, tamano_proyeccion);
+        }
+    }
+
+    // Liberar el bloqueo de lectura: FileProcessor ya puede añadir registros
+    bloquear_fichero(fileno(archivo_consolidado), F_UNLCK);
+    fclose(archivo_consolidado);
+    escribirEnLog(LOG_INFO, "Monitor: leer_fichero_consolidado", "Liberado bloqueo de lectura.\n");
+
+    return num_registros;
+}
+
+// Incorpora los registros nuevos del anillo a los diccionarios
+// Devuelve el número de registros incorporados, o -1 si falta algún registro y hay que leer el fichero
+int consumir_anillo_registros(EstadoLector *estado, AnilloRegistros *anillo) {
+    uint64_t escritos = __atomic_load_n(&anillo->escritos, __ATOMIC_ACQUIRE);
+
+    // Si el anillo es nuevo (FileProcessor lo ha vuelto a crear) se empieza desde el principio, y si
+    // se ha dado la vuelta desde la última lectura se empieza por el registro más antiguo disponible
+    if (estado->conexion_anillo != conexion_anillo || estado->siguiente_registro > escritos) {
+        estado->conexion_anillo = conexion_anillo;
+        estado->siguiente_registro = 0;
+    }
+    if (escritos - estado->siguiente_registro > anillo->capacidad) {
+        estado->siguiente_registro = escritos - anillo->capacidad;
+    }
+
+    int num_registros = 0;
+    while (estado->siguiente_registro < escritos) {
+        RegistroTransaccion registro;
+        if (!leer_registro_anillo(anillo, estado->siguiente_registro, &registro)) {
+            // Sobrescrito antes de poder leerlo
+            return -1;
+        }
+        if (registro.offset_fin <= estado->offset_procesado) {
+            // Ya incorporado (leído del fichero consolidado)
+            estado->siguiente_registro++;
+            continue;
+        }
+        if (registro.offset_inicio != estado->offset_procesado) {
+            // Faltan registros entre lo procesado y este registro
+            return -1;
+        }
+        aplicar_registro_evaluadores(estado, &registro);
+        estado->offset_procesado = registro.offset_fin;
+        estado->siguiente_registro++;
+        num_registros++;
+    }
+    return num_registros;
+}
+
+// Pone al día los diccionarios de todos los patrones con los registros nuevos
+// Devuelve el número de registros incorporados
+int sincronizar_registros(EstadoLector *estado, const char *nombre_fichero) {
+    // Antes de usar las posiciones de los registros del anillo, comprobar que el fichero al que se
+    // refieren es el mismo que se ha procesado hasta ahora
+    struct stat info;
+    comprobar_fichero_consolidado(estado, (stat(nombre_fichero, &info) == 0) ? &info : NULL);
+
+    AnilloRegistros *anillo = conectar_anillo_registros();
+    int num_registros = (anillo != NULL) ? consumir_anillo_registros(estado, anillo) : -1;
+    if (num_registros == -1) {
+        // Faltan registros: leerlos del fichero consolidado y seguir con lo que quede en el anillo
+        escribirEnLog(LOG_INFO, "Monitor: sincronizar_registros", "Leyendo el fichero consolidado %s\n", nombre_fichero);
+        num_registros = leer_fichero_consolidado(estado, nombre_fichero);
+        if (anillo != NULL) {
+            int num_anillo = consumir_anillo_registros(estado, anillo);
+            if (num_anillo > 0) {
+                num_registros += num_anillo;
+            }
+        }
+    }
+    return num_registros;
+}
+
+// ------------------------------------------------------------------
+// PUNTO DE CONTROL DEL ESTADO DE LOS PATRONES
+// ------------------------------------------------------------------
+/*
+    Cada CHECKPOINT_SECONDS segundos (Monitor.conf) se guarda en un fichero binario (CHECKPOINT_FILE, en la
+    carpeta de datos) todo el estado del hilo evaluador: posición procesada del fichero consolidado, marca de
+    agua, usuarios, entradas abiertas de los diccionarios, ventanas del patrón 1 y cuántos bytes de cada fichero
+    de alertas cerradas le corresponden (las alertas cerradas no se copian: antes de guardar se llevan a disco
+    con fdatasync). Se escribe en un fichero temporal que después se renombra, así que siempre hay un punto de
+    control completo.
+
+    Al arrancar, Monitor proyecta en memoria el último punto de control, reconstruye con él los diccionarios y
+    sólo lee del fichero consolidado lo añadido después de la posición guardada. Si el fichero consolidado ya
+    no es el mismo (otro inodo o más corto), se descarta el estado restaurado y se empieza de cero, igual que
+    en una rotación.
+
+    Formato: cabecera, nombres de los usuarios (terminados en '\0') y, por cada evaluador, su cabecera, sus
+    entradas (RegistroPatron) y sus ventanas (VentanaUsuario).
+    Cada bloque empieza alineado a 8 bytes. Las estructuras se guardan tal cual: si cambian hay que cambiar
+    MAGIA_PUNTO_CONTROL para que no se lean puntos de control antiguos.
+*/
+
+// Identificador del formato del punto de control
+#define MAGIA_PUNTO_CONTROL 0x50434D33u
+
+// Cabecera del punto de control
+typedef struct CABECERA_PUNTO_CONTROL {
+    uint32_t magia;
+    uint32_t num_evaluadores;
+    uint32_t tamano_registro;       // sizeof(RegistroPatron) y sizeof(VentanaUsuario), para detectar
+    uint32_t tamano_ventana;        // puntos de control de otra versión del programa
+    uint64_t tamano_total;          // Bytes del fichero (para detectar que está incompleto)
+    uint64_t offset_procesado;
+    uint64_t dispositivo;
+    uint64_t inodo;
+    int64_t instante_maximo;
+    uint64_t registros_tardios;
+    uint64_t secuencia_alertas;     // Última alerta escrita en el flujo de alertas
+    uint64_t num_usuarios;
+    uint64_t bytes_nombres;
+} CabeceraPuntoControl;
+
+// Cabecera del estado de un evaluador en el punto de control
+typedef struct CABECERA_EVALUADOR_PUNTO_CONTROL {
+    int64_t numero;
+    int64_t cierre_minimo;
+    uint64_t num_entradas;
+    uint64_t num_ventanas;
+    uint64_t bytes_cerradas;        // Bytes válidos del fichero de alertas cerradas
+} CabeceraEvaluadorPuntoControl;
+
+// Redondea un tamaño a múltiplo de 8 bytes
+static inline uint64_t alinear_punto_control(uint64_t tamano) {
+    return (tamano + 7) & ~(uint64_t)7;
+}
+
+// Completa con ceros hasta múltiplo de 8 bytes un bloque del punto de control de "tamano" bytes
+// Devuelve 0 si hay error de escritura
+int escribir_relleno_punto_control(FILE *fichero, uint64_t tamano) {
+    static const char ceros[8] = {0};
+    size_t relleno = (size_t)(alinear_punto_control(tamano) - tamano);
+    return fwrite(ceros, 1, relleno, fichero) == relleno;
+}
+
+// Escribe un bloque del punto de control y lo completa con ceros hasta múltiplo de 8 bytes
+// Devuelve 0 si hay error de escritura
+int escribir_bloque_punto_control(FILE *fichero, const void *datos, size_t tamano) {
+    return fwrite(datos, 1, tamano, fichero) == tamano && escribir_relleno_punto_control(fichero, tamano);
+}
+
+// Guarda el estado del hilo evaluador en el punto de control (fichero temporal + rename)
+// Devuelve 0 si se ha guardado y -1 si no
+int escribir_punto_control(EstadoLector *estado, const char *nombre_fichero) {
+    // Las alertas cerradas que indica el punto de control tienen que estar en disco antes que él
+    for (int i = 0; i < estado->num_evaluadores; i++) {
+        EvaluadorPatron *evaluador = &estado->evaluadores[i];
+        if (evaluador->cerradas_pendientes.longitud > 0) {
+            escribirEnLog(LOG_ERROR, "Monitor: escribir_punto_control", "Patrón %02d: hay alertas cerradas sin escribir, no se guarda el punto de control\n", evaluador->numero);
+            return -1;
+        }
+        if (evaluador->cerradas_sin_sincronizar) {
+            if (fdatasync(evaluador->fd_cerradas) == -1) {
+                escribirEnLog(LOG_ERROR, "Monitor: escribir_punto_control", "Patrón %02d: error al llevar a disco las alertas cerradas, no se guarda el punto de control\n", evaluador->numero);
+                return -1;
+            }
+            evaluador->cerradas_sin_sincronizar = 0;
+        }
+    }
+
+    char nombre_temporal[PATH_MAX];
+    snprintf(nombre_temporal, sizeof(nombre_temporal), "%s.tmp", nombre_fichero);
+    FILE *fichero = fopen(nombre_temporal, "wb");
+    if (fichero == NULL) {
+        escribirEnLog(LOG_ERROR, "Monitor: escribir_punto_control", "No se ha podido crear el fichero %s\n", nombre_temporal);
+        return -1;
+    }
+
+    CabeceraPuntoControl cabecera = {0};
+    cabecera.magia = MAGIA_PUNTO_CONTROL;
+    cabecera.num_evaluadores = estado->num_evaluadores;
+    cabecera.tamano_registro = sizeof(RegistroPatron);
+    cabecera.tamano_ventana = sizeof(VentanaUsuario);
+    cabecera.offset_procesado = estado->offset_procesado;
+    cabecera.dispositivo = estado->dispositivo;
+    cabecera.inodo = estado->inodo;
+    cabecera.instante_maximo = estado->instante_maximo;
+    cabecera.registros_tardios = estado->registros_tardios;
+    cabecera.secuencia_alertas = flujo_alertas.ultima_secuencia;
+    cabecera.num_usuarios = estado->usuarios.num_usuarios;
+    for (uint32_t i = 0; i < estado->usuarios.num_usuarios; i++) {
+        cabecera.bytes_nombres += strlen(estado->usuarios.nombres[i]) + 1;
+    }
+    // La cabecera se escribe al principio y se vuelve a escribir al final con el tamaño total
+    int correcto = escribir_bloque_punto_control(fichero, &cabecera, sizeof(cabecera));
+
+    for (uint32_t i = 0; correcto && i < estado->usuarios.num_usuarios; i++) {
+        const char *nombre = estado->usuarios.nombres[i];
+        correcto = fwrite(nombre, 1, strlen(nombre) + 1, fichero) == strlen(nombre) + 1;
+    }
+    correcto = correcto && escribir_relleno_punto_control(fichero, cabecera.bytes_nombres);
+
+    for (int i = 0; correcto && i < estado->num_evaluadores; i++) {
+        EvaluadorPatron *evaluador = &estado->evaluadores[i];
+        CabeceraEvaluadorPuntoControl cabecera_evaluador = {0};
+        cabecera_evaluador.numero = evaluador->numero;
+        cabecera_evaluador.cierre_minimo = evaluador->cierre_minimo;
+        cabecera_evaluador.num_entradas = evaluador->diccionario.num_entradas;
+        cabecera_evaluador.num_ventanas = (evaluador->ventanas.capacidad < estado->usuarios.num_usuarios) ? evaluador->ventanas.capacidad : estado->usuarios.num_usuarios;
+        cabecera_evaluador.bytes_cerradas = evaluador->bytes_cerradas;
+        correcto = escribir_bloque_punto_control(fichero, &cabecera_evaluador, sizeof(cabecera_evaluador));
+
+        for (size_t j = 0; correcto && j < evaluador->diccionario.capacidad; j++) {
+            if (evaluador->diccionario.entradas[j].clave != CLAVE_LIBRE) {
+                correcto = fwrite(&evaluador->diccionario.entradas[j], sizeof(RegistroPatron), 1, fichero) == 1;
+            }
+        }
+        if (correcto && cabecera_evaluador.num_ventanas > 0) {
+            correcto = escribir_bloque_punto_control(fichero, evaluador->ventanas.ventanas, cabecera_evaluador.num_ventanas * sizeof(VentanaUsuario));
+        }
+    }
+
+    if (correcto) {
+        cabecera.tamano_total = (uint64_t)ftell(fichero);
+        correcto = fseek(fichero, 0, SEEK_SET) == 0 && escribir_bloque_punto_control(fichero, &cabecera, sizeof(cabecera));
+    }
+    // Asegurar que el contenido está en disco antes de sustituir el punto de control anterior
+    correcto = (fflush(fichero) == 0) && correcto && (fsync(fileno(fichero)) == 0);
+    fclose(fichero);
+    if (!correcto || rename(nombre_temporal, nombre_fichero) != 0) {
+        escribirEnLog(LOG_ERROR, "Monitor: escribir_punto_control", "Error al escribir el punto de control %s\n", nombre_fichero);
+        unlink(nombre_temporal);
+        return -1;
+    }
+
+    escribirEnLog(LOG_INFO, "Monitor: escribir_punto_control", "Punto de control guardado: %llu bytes procesados del fichero consolidado, %u usuarios\n", (unsigned long long)estado->offset_procesado, estado->usuarios.num_usuarios);
+    return 0;
+}
+
+// Reconstruye el estado del hilo evaluador a partir del punto de control
+// Devuelve 0 si se ha restaurado y -1 si no hay punto de control válido (el estado queda vacío)
+int restaurar_punto_control(EstadoLector *estado, const char *nombre_fichero) {
+    int fd = open(nombre_fichero, O_RDONLY);
+    if (fd == -1) {
+        escribirEnLog(LOG_INFO, "Monitor: restaurar_punto_control", "No hay punto de control %s, se empieza de cero\n", nombre_fichero);
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(CabeceraPuntoControl)) {
+        close(fd);
+        escribirEnLog(LOG_WARNING, "Monitor: restaurar_punto_control", "Punto de control %s no válido, se empieza de cero\n", nombre_fichero);
+        return -1;
+    }
+    size_t tamano = (size_t)info.st_size;
+    const char *datos = mmap(NULL, tamano, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (datos == MAP_FAILED) {
+        escribirEnLog(LOG_ERROR, "Monitor: restaurar_punto_control", "Error al proyectar en memoria el punto de control %s\n", nombre_fichero);
+        return -1;
+    }
+
+    const CabeceraPuntoControl *cabecera = (const CabeceraPuntoControl *)datos;
+    int correcto = cabecera->magia == MAGIA_PUNTO_CONTROL && cabecera->tamano_total == tamano &&
+                   cabecera->num_evaluadores == (uint32_t)estado->num_evaluadores &&
+                   cabecera->tamano_registro == sizeof(RegistroPatron) && cabecera->tamano_ventana == sizeof(VentanaUsuario);
+    // Los tamaños de cada bloque se comprueban contra lo que queda del fichero antes de usarlo
+    uint64_t posicion = alinear_punto_control(sizeof(CabeceraPuntoControl));
+    correcto = correcto && cabecera->bytes_nombres <= tamano - posicion;
+
+    iniciar_diccionarios(estado);
+    if (correcto) {
+        const char *nombre = datos + posicion;
+        const char *fin_nombres = nombre + cabecera->bytes_nombres;
+        for (uint64_t i = 0; correcto && i < cabecera->num_usuarios; i++) {
+            const char *fin_nombre = memchr(nombre, '\0', fin_nombres - nombre);
+            // Los identificadores son consecutivos: registrar los nombres en orden los conserva
+            correcto = fin_nombre != NULL && obtener_id_usuario(&estado->usuarios, nombre) == i;
+            nombre = (fin_nombre != NULL) ? fin_nombre + 1 : fin_nombres;
+        }
+        posicion += alinear_punto_control(cabecera->bytes_nombres);
+    }
+
+    for (int i = 0; correcto && i < estado->num_evaluadores; i++) {
+        EvaluadorPatron *evaluador = &estado->evaluadores[i];
+        correcto = tamano - posicion >= sizeof(CabeceraEvaluadorPuntoControl);
+        if (!correcto) {
+            break;
+        }
+        const CabeceraEvaluadorPuntoControl *cabecera_evaluador = (const CabeceraEvaluadorPuntoControl *)(datos + posicion);
+        posicion += alinear_punto_control(sizeof(CabeceraEvaluadorPuntoControl));
+        uint64_t bytes_entradas = cabecera_evaluador->num_entradas * sizeof(RegistroPatron);
+        uint64_t bytes_ventanas = alinear_punto_control(cabecera_evaluador->num_ventanas * sizeof(VentanaUsuario));
+        correcto = cabecera_evaluador->numero == evaluador->numero && cabecera_evaluador->num_ventanas <= cabecera->num_usuarios &&
+                   cabecera_evaluador->num_entradas <= (tamano - posicion) / sizeof(RegistroPatron) &&
+                   bytes_entradas + bytes_ventanas <= tamano - posicion;
+        if (!correcto) {
+            break;
+        }
+
+        const RegistroPatron *entradas = (const RegistroPatron *)(datos + posicion);
+        for (uint64_t j = 0; j < cabecera_evaluador->num_entradas; j++) {
+            *obtener_registro_patron(&evaluador->diccionario, entradas[j].clave) = entradas[j];
+        }
+        evaluador->cierre_minimo = cabecera_evaluador->cierre_minimo;
+        posicion += bytes_entradas;
+
+        if (cabecera_evaluador->num_ventanas > 0) {
+            obtener_ventana_usuario(&evaluador->ventanas, (uint32_t)(cabecera_evaluador->num_ventanas - 1));
+            memcpy(evaluador->ventanas.ventanas, datos + posicion, cabecera_evaluador->num_ventanas * sizeof(VentanaUsuario));
+        }
+        posicion += bytes_ventanas;
+
+        // El fichero de alertas cerradas se comprueba al abrirlo (abrir_alertas_cerradas)
+        evaluador->bytes_cerradas = cabecera_evaluador->bytes_cerradas;
+    }
+
+    if (correcto) {
+        estado->offset_procesado = cabecera->offset_procesado;
+        estado->dispositivo = (dev_t)cabecera->dispositivo;
+        estado->inodo = (ino_t)cabecera->inodo;
+        estado->instante_maximo = cabecera->instante_maximo;
+        // Un punto de control anterior puede tener la marca de agua adelantada por un registro con fecha futura
+        int64_t limite = calcular_limite_futuro(obtener_configuracion()->adelanto_permitido);
+        if (estado->instante_maximo != INSTANTE_NO_VALIDO && estado->instante_maximo > limite) {
+            escribirEnLog(LOG_WARNING, "Monitor: restaurar_punto_control", "Instante más reciente del punto de control en el futuro: se limita al adelanto permitido\n");
+            estado->instante_maximo = limite;
+        }
+        estado->registros_tardios = cabecera->registros_tardios;
+        estado->secuencia_alertas = cabecera->secuencia_alertas;
+    }
+    munmap((void *)datos, tamano);
+
+    if (!correcto) {
+        escribirEnLog(LOG_WARNING, "Monitor: restaurar_punto_control", "Punto de control %s no válido, se empieza de cero\n", nombre_fichero);
+        iniciar_diccionarios(estado);
+        return -1;
+    }
+    escribirEnLog(LOG_INFO, "Monitor: restaurar_punto_control", "Restaurado el punto de control %s: %llu bytes procesados del fichero consolidado, %u usuarios\n", nombre_fichero, (unsigned long long)estado->offset_procesado, estado->usuarios.num_usuarios);
+    return 0;
+}
+
+// Patrón 1: ventana deslizante de una hora por usuario
+// La clave del diccionario va a ser usuario+fecha-hora de la primera transacción de la ráfaga (USER144@12/03/2024 09:47:00)
+// Cada transacción se coloca en orden en la ventana del usuario (los registros de varias sucursales no llegan
+// ordenados) y se busca la hora que más transacciones junta con ella. El coste por registro está acotado por
+// el tamaño de la ventana, que no crece con el número de registros
+// La cantidad de la alerta no depende del tamaño de la ventana: empieza con las transacciones de la hora que
+// la dispara y suma una por cada transacción que después se une a su ráfaga
+void aplicar_patron_fraude_1(EvaluadorPatron *evaluador, uint32_t id_usuario, int64_t instante, const RegistroTransaccion *registro) {
+    VentanaUsuario *ventana = obtener_ventana_usuario(&evaluador->ventanas, id_usuario);
+
+    // Colocar el instante en orden (normalmente va al final)
+    int posicion = ventana->num_instantes;
+    while (posicion > 0 && ventana->instantes[posicion - 1] > instante) {
+        ventana->instantes[posicion] = ventana->instantes[posicion - 1];
+        posicion--;
+    }
+    ventana->instantes[posicion] = instante;
+    ventana->num_instantes++;
+
+    // Hora (intervalo de menos de SEGUNDOS_VENTANA_PATRON_1 segundos) con más transacciones que incluye la nueva
+    int mejor_inicio = posicion, mejor_fin = posicion;
+    int inicio = posicion;
+    while (inicio > 0 && instante - ventana->instantes[inicio - 1] < SEGUNDOS_VENTANA_PATRON_1) {
+        inicio--;
+    }
+    int fin = posicion;
+    for (; inicio <= posicion; inicio++) {
+        while (fin + 1 < ventana->num_instantes && ventana->instantes[fin + 1] - ventana->instantes[inicio] < SEGUNDOS_VENTANA_PATRON_1) {
+            fin++;
+        }
+        if (fin - inicio > mejor_fin - mejor_inicio) {
+            mejor_inicio = inicio;
+            mejor_fin = fin;
+        }
+    }
+
+    int cantidad = mejor_fin - mejor_inicio + 1;
+    if (cantidad >= UMBRAL_VENTANA_PATRON_1) {
+        int64_t comienzo = ventana->instantes[mejor_inicio];
+        int64_t final = ventana->instantes[mejor_fin];
+        // Si se solapa con la ráfaga de la última alerta se actualiza esa alerta en lugar de crear otra
+        int nueva_alerta = (ventana->clave_alerta == CLAVE_LIBRE || comienzo > ventana->fin_alerta);
+        if (nueva_alerta) {
+            ventana->clave_alerta = clave_evaluador(evaluador, id_usuario, comienzo);
+            ventana->fin_alerta = final;
+        } else if (final > ventana->fin_alerta) {
+            ventana->fin_alerta = final;
+        }
+        // La alerta se cierra cuando ya no puede llegar una transacción a menos de una hora de su ráfaga
+        RegistroPatron *alerta = obtener_registro_patron(&evaluador->diccionario, ventana->clave_alerta);
+        fijar_cierre_registro(evaluador, alerta, ventana->fin_alerta + SEGUNDOS_VENTANA_PATRON_1);
+        // La nueva alerta cuenta las transacciones de la hora que la dispara; después, cada transacción
+        // que se une a la ráfaga suma una, aunque la ventana ya no guarde todos sus instantes
+        if (nueva_alerta) {
+            alerta->cantidad = cantidad;
+        } else {
+            alerta->cantidad += 1;
+        }
+    }
+
+    // Descartar los instantes a más de una hora (más el retraso permitido, por los registros que llegan tarde)
+    // del más reciente y, si no caben, los más antiguos
+    int64_t mas_reciente = ventana->instantes[ventana->num_instantes - 1];
+    int descartar = 0;
+    while (descartar < ventana->num_instantes && mas_reciente - ventana->instantes[descartar] >= SEGUNDOS_VENTANA_PATRON_1 + retraso_permitido) {
+        descartar++;
+    }
+    if (ventana->num_instantes - descartar > CAPACIDAD_VENTANA_PATRON_1) {
+        descartar = ventana->num_instantes - CAPACIDAD_VENTANA_PATRON_1;
+    }
+    if (descartar > 0) {
+        ventana->num_instantes -= descartar;
+        memmove(ventana->instantes, ventana->instantes + descartar, ventana->num_instantes * sizeof(int64_t));
+    }
+}
+
+// Detección de patrón de fraude de tipo 1
+// Más de 5 transacciones por usuario en una hora (en el diccionario sólo están las alertas de la ventana deslizante)
+int comprobar_patron_fraude_1(const RegistroPatron *registro, const char *clave, char *mensaje, size_t tamano_mensaje) {
+    if (registro->cantidad > 5) {
+        snprintf(mensaje, tamano_mensaje, "%02d:::Registro fraude patrón 1:::Clave=%s:::Registros en la Misma Hora=%d\n", 1, clave, registro->cantidad);
+        return 1;
+    }
+    return 0;
+}
+
+// Patrón 2: la clave del diccionario va a ser usuario y fecha-hora completa, sólo para retiradas de dinero
+void aplicar_patron_fraude_2(EvaluadorPatron *evaluador, uint32_t id_usuario, int64_t instante, const RegistroTransaccion *registro) {
+    if (registro->importe < 0) {
+        obtener_registro_evaluador(evaluador, id_usuario, instante)->cantidad += 1;
+    }
+}
+
+// Detección de patrón de fraude de tipo 2
+// Un usuario realiza más de 3 retiros a la vez
+// Entendemos que quiere decir que el usuario realiza tres retiros en la misma hora:minuto:segundo
+int comprobar_patron_fraude_2(const RegistroPatron *registro, const char *clave, char *mensaje, size_t tamano_mensaje) {
+    if (registro->cantidad > 3) {
+        snprintf(mensaje, tamano_mensaje, "%02d:::Registro fraude patrón 2:::Clave=%s:::Registros a la vez=%d\n", 2, clave, registro->cantidad);
+        return 1;
+    }
+    return 0;
+}
+
+// Patrón 3: la clave del diccionario va a ser usuario y el día, sólo para los movimientos con error
+void aplicar_patron_fraude_3(EvaluadorPatron *evaluador, uint32_t id_usuario, int64_t instante, const RegistroTransaccion *registro) {
+    if (registro->codigoEstado == ESTADO_ERROR) {
+        obtener_registro_evaluador(evaluador, id_usuario, instante)->cantidad += 1;
+    }
+}
+
+// Detección de patrón de fraude de tipo 3
+// Un usuario comete más de 3 errores durante 1 día
+int comprobar_patron_fraude_3(const RegistroPatron *registro, const char *clave, char *mensaje, size_t tamano_mensaje) {
+    if (registro->cantidad > 3) {
+        snprintf(mensaje, tamano_mensaje, "%02d:::Registro fraude patrón 3:::Clave=%s:::Registros con Error=%d\n", 3, clave, registro->cantidad);
+        return 1;
+    }
+    return 0;
+}
+
+// Patrón 4: la clave del diccionario va a ser usuario y el día, y se acumulan los tipos de operación
+// de los movimientos sin error
+void aplicar_patron_fraude_4(EvaluadorPatron *evaluador, uint32_t id_usuario, int64_t instante, const RegistroTransaccion *registro) {
+    if (registro->codigoEstado != ESTADO_ERROR) {
+        RegistroPatron *registroPatron = obtener_registro_evaluador(evaluador, id_usuario, instante);
+        registroPatron->operacion1Presente += (registro->tipoOperacion2 == 1);
+        registroPatron->operacion2Presente += (registro->tipoOperacion2 == 2);
+        registroPatron->operacion3Presente += (registro->tipoOperacion2 == 3);
+        registroPatron->operacion4Presente += (registro->tipoOperacion2 == 4);
+    }
+}
+
+// Detección de patrón de fraude de tipo 4
+// Un usuario realiza una operación por cada tipo de operaciones durante el mismo día
+// Suponemos que este patrón de fraude se da cuando en el mismo día hay 1 registro de cada
+// uno de estos tipos de operaciones: 1, 2, 3, 4
+int comprobar_patron_fraude_4(const RegistroPatron *registro, const char *clave, char *mensaje, size_t tamano_mensaje) {
+    if (registro->operacion1Presente > 0 && registro->operacion2Presente > 0 && registro->operacion3Presente > 0 && registro->operacion4Presente > 0) {
+        snprintf(mensaje, tamano_mensaje, "%02d:::Registro fraude patrón 4:::Clave=%s:::Registros con Todos los Tipos de Operaciones\n", 4, clave);
+        return 1;
+    }
+    return 0;
+}
+
+// Patrón 5: la clave del diccionario va a ser usuario y el día, y se acumula el importe
+void aplicar_patron_fraude_5(EvaluadorPatron *evaluador, uint32_t id_usuario, int64_t instante, const RegistroTransaccion *registro) {
+    obtener_registro_evaluador(evaluador, id_usuario, instante)->cantidad += registro->importe;
+}
+
+// Detección de patrón de fraude de tipo 5
+// La cantidad de dinero retirado (-) es mayor que la cantidad de dinero ingresado (+) por un usuario en 1 día
+int comprobar_patron_fraude_5(const RegistroPatron *registro, const char *clave, char *mensaje, size_t tamano_mensaje) {
+    // Suma de dinero ingresado y retirado es negativa
+    if (registro->cantidad < 0) {
+        snprintf(mensaje, tamano_mensaje, "%02d:::Registro fraude patrón 5:::Clave=%s:::Saldo negativo=%d\n", 5, clave, registro->cantidad);
+        return 1;
+    }
+    return 0;
+}
+
+// Evaluadores registrados: para añadir un patrón basta con añadir aquí su intervalo de tiempo y sus funciones
+EvaluadorPatron evaluadores_patrones[NUM_PATRONES_FRAUDE] = {
+    {.numero = 1, .segundos_intervalo = 1, .aplicar = aplicar_patron_fraude_1, .comprobar = comprobar_patron_fraude_1},
+    {.numero = 2, .segundos_intervalo = 1, .aplicar = aplicar_patron_fraude_2, .comprobar = comprobar_patron_fraude_2},
+    {.numero = 3, .segundos_intervalo = 86400, .aplicar = aplicar_patron_fraude_3, .comprobar = comprobar_patron_fraude_3},
+    {.numero = 4, .segundos_intervalo = 86400, .aplicar = aplicar_patron_fraude_4, .comprobar = comprobar_patron_fraude_4},
+    {.numero = 5, .segundos_intervalo = 86400, .aplicar = aplicar_patron_fraude_5, .comprobar = comprobar_patron_fraude_5},
+};
+
+// Añade un texto al contenido de un fichero resultado
+void anadir_texto_resultado(TextoResultado *resultado, const char *texto, size_t longitud) {
+    if (resultado->longitud + longitud > resultado->capacidad) {
+        size_t capacidad = (resultado->capacidad == 0) ? 4096 : resultado->capacidad;
+        while (resultado->longitud + longitud > capacidad) {
+            capacidad *= 2;
+        }
+        char *datos = realloc(resultado->datos, capacidad);
+        if (datos == NULL) {
+            escribirEnLog(LOG_ERROR, "Monitor: anadir_texto_resultado", "Error al reservar memoria para el fichero resultado\n");
+            exit(EXIT_FAILURE);
+        }
+        resultado->datos = datos;
+        resultado->capacidad = capacidad;
+    }
+    memcpy(resultado->datos + resultado->longitud, texto, longitud);
+    resultado->longitud += longitud;
+}
+
+// Escribe en el fichero resultado del patrón sus alertas cerradas y las entradas de su diccionario que cumplen el patrón
+// El texto de la clave se compone aquí, sólo para las entradas que se escriben
+// Lo que no está en el fichero de alertas cerradas se compone en memoria y se publica de una vez al final
+void escribir_resultados_patron(EvaluadorPatron *evaluador, const TablaUsuarios *usuarios) {
+    int patron = evaluador->numero;
+    DiccionarioPatron *diccionario = &evaluador->diccionario;
+    char mensaje[150];
+    char clave[100];
+
+    // Imprimir resultados del diccionario en el log
+    escribirEnLog(LOG_DEBUG, "Monitor: escribir_resultados_patron", "Patrón %02d: Diccionario del patrón (%zu entradas)\n", patron, diccionario->num_entradas);
+    for (size_t i = 0; i < diccionario->capacidad; i++) {
+        RegistroPatron *registro = &diccionario->entradas[i];
+        if (registro->clave != CLAVE_LIBRE) {
+            texto_clave_patron(usuarios, registro->clave, evaluador->segundos_intervalo, clave, sizeof(clave));
+            escribirEnLog(LOG_DEBUG, "Monitor: escribir_resultados_patron", "Patrón %02d: Diccionario del patrón Clave: %s, Número Registros: %d\n", patron, clave, registro->cantidad);
+        }
+    }
+    escribirEnLog(LOG_DEBUG, "Monitor: escribir_resultados_patron", "Patrón %02d: Terminado diccionario del patrón\n", patron);
+
+    // Revisar resultados que cumplen el patrón: primero los de las entradas ya cerradas (las de su fichero y las
+    // que no se han podido escribir en él) y después los de las abiertas
+    escribirEnLog(LOG_INFO, "Monitor: escribir_resultados_patron", "Patrón %02d: Registros que cumplen el patrón\n", patron);
+    TextoResultado *resultado = &evaluador->resultado;
+    resultado->longitud = 0;
+    if (evaluador->cerradas_pendientes.longitud > 0) {
+        anadir_texto_resultado(resultado, evaluador->cerradas_pendientes.datos, evaluador->cerradas_pendientes.longitud);
+    }
+    for (size_t i = 0; i < diccionario->capacidad; i++) {
+        RegistroPatron *registro = &diccionario->entradas[i];
+        if (registro->clave == CLAVE_LIBRE) {
+            continue;
+        }
+        texto_clave_patron(usuarios, registro->clave, evaluador->segundos_intervalo, clave, sizeof(clave));
+        if (evaluador->comprobar(registro, clave, mensaje, sizeof(mensaje))) {
+            escribirEnLog(LOG_GENERAL, "Monitor: escribir_resultados_patron", mensaje);
+            // Añadir al fichero resultado del patrón y, si es nueva o ha cambiado, al flujo de alertas
+            anadir_texto_resultado(resultado, mensaje, strlen(mensaje));
+            notificar_alerta(registro, mensaje);
+        }
+    }
+
+    // Sustituir el fichero resultado por el nuevo contenido
+    publicar_fichero_resultado(patron, evaluador->fd_cerradas, evaluador->bytes_cerradas, resultado->datos, resultado->longitud);
+    escribirEnLog(LOG_INFO, "Monitor: escribir_resultados_patron", "Patrón %02d: Terminados registros que cumplen el patrón\n", patron);
+}
+
+// Hilo evaluador de los patrones de fraude
+// Cada vez que se activa lee una sola vez los registros nuevos, aplica cada uno a todos los evaluadores
+// registrados y después escribe los resultados de cada patrón
+void *hilo_evaluador_patrones(void *arg) {
+    const char *carpeta_datos;
+    char mensaje[150];
+
+    carpeta_datos = obtener_configuracion()->carpeta_datos;
+    const char *fichero_datos;
+    fichero_datos = obtener_configuracion()->fichero_consolidado;
+    char nombre_completo_fichero_datos[PATH_MAX];
+    sprintf(nombre_completo_fichero_datos, "%s/%s", carpeta_datos, fichero_datos);
+
+    escribirEnLog(LOG_DEBUG, "Monitor: hilo_evaluador_patrones", "Procesando fichero %s \n", nombre_completo_fichero_datos);
+
+    // Retraso permitido de los registros para el cierre de las entradas de los diccionarios
+    retraso_permitido = obtener_configuracion()->retraso_permitido;
+
+    // Punto de control del estado de los patrones
+    char nombre_punto_control[PATH_MAX];
+    snprintf(nombre_punto_control, sizeof(nombre_punto_control), "%s/%s", carpeta_datos, obtener_configuracion()->fichero_punto_control);
+    time_t ultimo_punto_control = time(NULL);
+    int cambios_sin_guardar = 0;
+
+    // Diccionarios de los patrones: se mantienen entre activaciones y sólo se les añaden los registros nuevos
+    // Se parte del último punto de control, si lo hay: sólo hará falta leer lo añadido después
+    EstadoLector estado = {0};
+    estado.evaluadores = evaluadores_patrones;
+    estado.num_evaluadores = NUM_PATRONES_FRAUDE;
+    for (int i = 0; i < estado.num_evaluadores; i++) {
+        estado.evaluadores[i].fd_cerradas = -1;
+    }
+    iniciar_arena(&estado.arena, TAMANO_BLOQUE_ARENA);
+    iniciar_diccionarios(&estado);
+    restaurar_punto_control(&estado, nombre_punto_control);
+
+    // Ficheros de alertas cerradas: se descarta lo escrito después del punto de control
+    abrir_alertas_cerradas(&estado);
+
+    // Flujo de alertas: la numeración sigue desde la última alerta escrita
+    char nombre_flujo_alertas[PATH_MAX];
+    snprintf(nombre_flujo_alertas, sizeof(nombre_flujo_alertas), "%s/%s", carpeta_datos, obtener_configuracion()->fichero_alertas);
+    abrir_flujo_alertas(nombre_flujo_alertas, estado.secuencia_alertas);
+
+    // Bucle infinito a la espera de avisos de FileProcessor
+    uint64_t generacion_atendida = 0;
+    int terminar = 0;
+    while (!terminar) {
+        // Esperar a que llegue un aviso (si ha llegado alguno durante la evaluación anterior no se espera)
+        generacion_atendida = esperarAvisoEvaluador(generacion_atendida, &terminar);
+
+        // Parámetros que se pueden cambiar al recargar la configuración: se mantienen durante toda la comprobación
+        const Configuracion *configuracion = obtener_configuracion();
+        retraso_permitido = configuracion->retraso_permitido;
+        instante_limite_futuro = calcular_limite_futuro(configuracion->adelanto_permitido);
+
+        escribirEnLog(LOG_INFO, "Monitor: hilo_evaluador_patrones", "Comenzando comprobación de patrones de fraude en fichero %s\n", nombre_completo_fichero_datos);
+
+        // Incorporar los registros nuevos (del anillo de memoria compartida o, si faltan, del fichero consolidado)
+        int num_nuevos = sincronizar_registros(&estado, nombre_completo_fichero_datos);
+        escribirEnLog(LOG_INFO, "Monitor: hilo_evaluador_patrones", "Incorporados %d registros nuevos (%llu fuera del retraso permitido desde el principio)\n", num_nuevos, (unsigned long long)estado.registros_tardios);
+
+        // Cerrar las entradas que ya no pueden cambiar para que los diccionarios no crezcan indefinidamente
+        // Sus alertas se añaden al fichero de alertas cerradas del patrón y no se quedan en memoria
+        size_t num_cerradas = 0;
+        for (int i = 0; i < estado.num_evaluadores; i++) {
+            num_cerradas += cerrar_entradas_vencidas(&estado.evaluadores[i], &estado.usuarios, marca_agua(&estado));
+            volcar_alertas_cerradas(&estado.evaluadores[i]);
+        }
+
+        // Recuperar la memoria de las tablas sustituidas, las entradas cerradas y los usuarios que ya no aparecen
+        if (estado.arena.bytes_en_uso > MINIMO_COMPACTACION_ARENA &&
+            estado.arena.bytes_en_uso > FACTOR_COMPACTACION_ARENA * estado.bytes_compactados) {
+            compactar_diccionarios(&estado);
+        }
+        escribirEnLog(LOG_DEBUG, "Monitor: hilo_evaluador_patrones", "Memoria de los diccionarios: %zu bytes de %u usuarios\n", estado.arena.bytes_en_uso, estado.usuarios.num_usuarios);
+
+        // Los resultados sólo cambian si hay registros nuevos o entradas cerradas (los avisos del temporizador
+        // de mantenimiento normalmente no traen nada nuevo)
+        int hay_cambios = (num_nuevos > 0 || num_cerradas > 0);
+        if (hay_cambios) {
+            for (int i = 0; i < estado.num_evaluadores; i++) {
+                escribir_resultados_patron(&estado.evaluadores[i], &estado.usuarios);
+            }
+            cambios_sin_guardar = 1;
+        }
+
+        // Las alertas nuevas o cambiadas se escriben antes del punto de control que las da por notificadas
+        // Si se ha escrito alguna, el punto de control se guarda en el mismo paso: si no, al reiniciar se
+        // volverían a notificar las alertas escritas después del último punto de control
+        int alertas_escritas = volcar_flujo_alertas();
+
+        // Guardar el punto de control si hay cambios y ha pasado el tiempo configurado desde el anterior,
+        // lo pide el temporizador de mantenimiento, se han escrito alertas o el programa va a terminar
+        int mantenimiento = __atomic_exchange_n(&mantenimiento_pendiente, 0, __ATOMIC_ACQ_REL);
+        if (cambios_sin_guardar && (mantenimiento || alertas_escritas || terminar || time(NULL) - ultimo_punto_control >= configuracion->segundos_punto_control)) {
+            if (escribir_punto_control(&estado, nombre_punto_control) == 0) {
+                cambios_sin_guardar = 0;
+            }
+            ultimo_punto_control = time(NULL);
+        }
+
+        // Una vez terminado, el hilo vuelve a esperar: no se ejecuta otra vez hasta que llegue un aviso a través
+        // del pipe o del temporizador de mantenimiento
+
+        //Se simulará el tiempo de servicio de la comprobación según SIMULATE_MODE (nada con OFF)
+        if (hay_cambios && !terminar) {
+            snprintf(mensaje, sizeof(mensaje), "Monitor: hilo_evaluador_patrones: ");
+            simulaRetardo(0, mensaje);
+        }
+    }
+
+    // Última comprobación hecha: main ya puede terminar el proceso
+    escribirEnLog(LOG_INFO, "Monitor: hilo_evaluador_patrones", "Alertas y punto de control guardados antes de terminar\n");
+    avisarEvaluadorTerminado();
+    return NULL;
+}
+
+// Función que crea el hilo evaluador de los patrones de fraude
+int crear_hilo_evaluador_patrones() {
+    pthread_t tid;
+
+    // El hilo queda esperando hasta que llegue el primer aviso por el pipe
+
+    if (pthread_create(&tid, NULL, hilo_evaluador_patrones, NULL) != 0) {
+        escribirEnLog(LOG_ERROR, "Monitor: crear_hilo_evaluador_patrones", "Error al crear el hilo evaluador de patrones de fraude\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Desanclar el hilo para que se ejecute de forma independiente
+    if (pthread_detach(tid) != 0) {
+        escribirEnLog(LOG_ERROR, "Monitor: crear_hilo_evaluador_patrones", "Error al desanclar el hilo evaluador de patrones de fraude\n");
+        exit(EXIT_FAILURE);
+    }
+
+    escribirEnLog(LOG_INFO, "Monitor: crear_hilo_evaluador_patrones", "Hilo evaluador de %d patrones de fraude creado\n", NUM_PATRONES_FRAUDE);
+    return 0;
 }
 
 #pragma endregion DeteccionPatronesFraude
@@ -1293,18 +2082,15 @@ int crear_hilos_patrones_fraude() {
 // ------------------------------------------------------------------
 #pragma region Main
 
-// Función de manejador de señal CTRL-C
+// Función que termina el programa al recibir una señal de terminación (CTRL-C o SIGTERM)
+// Se llama desde el bucle de eventos (las señales llegan por un signalfd), no desde un manejador de señal
 void ctrlc_handler(int sig) {
-    printf("Monitor: Se ha presionado CTRL-C. Terminando la ejecución.\n");
-    escribirEnLog(LOG_INFO, "file_processor: ctrlc_handler", "Se ha pulsado CTRL-C\n");
+    printf("Monitor: Se ha recibido la señal %s. Terminando la ejecución.\n", (sig == SIGINT) ? "CTRL-C" : "SIGTERM");
+    escribirEnLog(LOG_INFO, "Monitor: ctrlc_handler", "Se ha recibido la señal %d\n", sig);
 
     // Acciones que hay que realizar al terminar el programa
-    // Cerrar el semáforo
-    sem_close(semaforo_consolidar_ficheros_entrada);
-    // Borrar el semáforo
-    sem_unlink(semName);
-
-    escribirEnLog(LOG_INFO, "Monitor: ctrlc_handler", "Semáforo semaforo_consolidar_ficheros_entrada cerrado\n");
+    // El evaluador escribe las alertas pendientes y el punto de control antes de que termine el proceso
+    solicitarTerminacionEvaluador();
     close(pipefd);
     escribirEnLog(LOG_INFO, "Monitor: ctrlc_handler", "pipe cerrado\n");
     escribirEnLog(LOG_INFO, "Monitor: ctrlc_handler", "Proceso terminado\n");
@@ -1313,71 +2099,228 @@ void ctrlc_handler(int sig) {
     exit(EXIT_SUCCESS);
 }
 
+// Abre el pipe para lectura sin bloquearse (no espera a que FileProcessor lo abra para escritura) y lo añade
+// al bucle de eventos
+// Un pipe recién abierto no da fin de fichero hasta que un escritor se conecta y se vuelve a desconectar
+int abrir_pipe_monitor(int epollfd, const char *pipeName) {
+    int fd = open(pipeName, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+        escribirEnLog(LOG_ERROR, "Monitor: abrir_pipe_monitor", "Error al abrir el pipe %s\n", pipeName);
+        exit(EXIT_FAILURE);
+    }
+    struct epoll_event evento = {.events = EPOLLIN, .data.fd = fd};
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &evento) == -1) {
+        escribirEnLog(LOG_ERROR, "Monitor: abrir_pipe_monitor", "Error al añadir el pipe %s al bucle de eventos\n", pipeName);
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+// Procesa las tramas completas del buffer del pipe y deja al principio la trama incompleta que haya quedado
+// Devuelve el número de mensajes recibidos
+int procesar_tramas_pipe(char *buffer, size_t *bytes_buffer) {
+    size_t posicion = 0;
+    int num_mensajes = 0;
+    while (*bytes_buffer - posicion >= sizeof(uint32_t)) {
+        uint32_t longitud;
+        memcpy(&longitud, buffer + posicion, sizeof(uint32_t));
+        if (longitud > MESSAGE_SIZE) {
+            // Trama no válida: se descarta todo lo recibido
+            escribirEnLog(LOG_ERROR, "Monitor: procesar_tramas_pipe", "Recibida trama no válida en el pipe (longitud %u)\n", longitud);
+            posicion = *bytes_buffer;
+            break;
+        }
+        if (*bytes_buffer - posicion < sizeof(uint32_t) + longitud) {
+            // Trama incompleta: se termina de leer en la siguiente lectura
+            break;
+        }
+
+        // Recibido mensaje en el pipe
+        char mensaje[MESSAGE_SIZE + 1];
+        memcpy(mensaje, buffer + posicion + sizeof(uint32_t), longitud);
+        mensaje[longitud] = '\0';
+        escribirEnLog(LOG_INFO, "Monitor: main", "Recibido %s\n", mensaje);
+        escribirEnLog(LOG_GENERAL, "Monitor: main", "%s\n", mensaje);
+        posicion += sizeof(uint32_t) + longitud;
+        num_mensajes++;
+    }
+
+    // Mover al principio del buffer la trama incompleta que haya quedado
+    memmove(buffer, buffer + posicion, *bytes_buffer - posicion);
+    *bytes_buffer -= posicion;
+    return num_mensajes;
+}
+
+// Lee todo lo disponible en el pipe (está abierto sin bloqueo) y avisa al hilo evaluador si han llegado mensajes
+// Si FileProcessor ha cerrado el pipe, se vuelve a abrir para esperar a que se reconecte
+void atender_pipe_monitor(int epollfd, const char *pipeName, char *buffer, size_t *bytes_buffer) {
+    int num_mensajes = 0;
+    while (1) {
+        ssize_t bytes_read = read(pipefd, buffer + *bytes_buffer, TAMANO_BUFFER_PIPE - *bytes_buffer);
+        if (bytes_read == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                escribirEnLog(LOG_ERROR, "Monitor: atender_pipe_monitor", "Error al leer del pipe %s\n", pipeName);
+            }
+            break;
+        }
+        if (bytes_read == 0) {
+            // FileProcessor ha cerrado el pipe: se vuelve a abrir y se espera a que se reconecte
+            // Una trama incompleta no se terminará de recibir: FileProcessor la reenvía entera
+            escribirEnLog(LOG_INFO, "Monitor: atender_pipe_monitor", "FileProcessor ha cerrado el pipe, esperando reconexión\n");
+            epoll_ctl(epollfd, EPOLL_CTL_DEL, pipefd, NULL);
+            close(pipefd);
+            pipefd = abrir_pipe_monitor(epollfd, pipeName);
+            *bytes_buffer = 0;
+            break;
+        }
+        *bytes_buffer += bytes_read;
+        num_mensajes += procesar_tramas_pipe(buffer, bytes_buffer);
+    }
+
+    if (num_mensajes > 0) {
+        // Avisar al hilo evaluador de patrones de fraude
+        // Si han llegado varios mensajes a la vez basta con un único aviso
+        notificarEvaluadorPatrones();
+    }
+}
+
+// Programa el temporizador de mantenimiento cada "segundos" segundos (con 0 lo desactiva)
+int programar_temporizador_mantenimiento(int temporizadorfd, int segundos) {
+    struct itimerspec periodo = {.it_interval = {segundos, 0}, .it_value = {segundos, 0}};
+    return timerfd_settime(temporizadorfd, 0, &periodo, NULL);
+}
+
+// Recarga la configuración y aplica lo que se puede cambiar en ejecución
+// El retraso permitido y el intervalo del punto de control los toma el hilo evaluador en su siguiente
+// comprobación; el retardo simulado y el log los leen directamente en cada uso
+void atender_recarga_configuracion(int temporizadorfd) {
+    int segundos_anteriores = obtener_configuracion()->segundos_punto_control;
+    if (recargar_configuracion() != 1) {
+        return;
+    }
+    int segundos = obtener_configuracion()->segundos_punto_control;
+    if (segundos != segundos_anteriores) {
+        escribirEnLog(LOG_INFO, "Monitor: atender_recarga_configuracion", "Temporizador de mantenimiento cada %d segundos\n", segundos);
+        programar_temporizador_mantenimiento(temporizadorfd, segundos);
+    }
+}
+
 // Función main que se activa al llamar desde línea de comandos
 int main(int argc, char *argv[]) {
     // Parámetros: argc es el contador de parámetros y argv es el valor de estos parámetros
 
-    escribirEnLog(LOG_GENERAL, "Monitor: main", "Iniciando ejecución Monitor\n");
-
-    // Vamos a crear un semáforo con un nombre común para file procesor y monitor de forma que podamos utilizarlo
-    // para asegurar el acceso a recursos comunes desde ambos procesos. 
-    // Creamos un semáforo de 1 recursos con nombre definido en SEMAPHORE_NAME y permisos de lectura y escritura
-    semName = obtener_valor_configuracion("SEMAPHORE_NAME", "/semaforo");
+    // Leer el fichero de configuración (antes que nada: el log también depende de él)
+    cargar_configuracion(FICHERO_CONFIGURACION);
 
-    semaforo_consolidar_ficheros_entrada = sem_open(semName, O_CREAT , 0644, 1);
-    if (semaforo_consolidar_ficheros_entrada == SEM_FAILED){
-        escribirEnLog(LOG_ERROR, "Monitor: main", "Error al abrir el semáforo %s\n", semName);
-        exit(EXIT_FAILURE);
-    }
-    escribirEnLog(LOG_INFO, "Monitor: main", "Semáforo %s creado\n", semName);
-    escribirEnLog(LOG_INFO, "Monitor:main", "Semáforo semaforo_consolidar_ficheros_entrada creado\n");
+    escribirEnLog(LOG_GENERAL, "Monitor: main", "Iniciando ejecución Monitor\n");
 
-    // Registra el manejador de señal para SIGINT para CTRL-C
-    if (signal(SIGINT, ctrlc_handler) == SIG_ERR) {
+    // Las señales de terminación (CTRL-C y SIGTERM) y la de recarga de la configuración (SIGHUP) se bloquean
+    // antes de crear el hilo evaluador, para que ningún hilo las reciba de forma asíncrona: llegan al bucle de
+    // eventos a través de un signalfd
+    sigset_t senales;
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGINT);
+    sigaddset(&senales, SIGTERM);
+    sigaddset(&senales, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &senales, NULL);
+    int senalfd = signalfd(-1, &senales, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (senalfd == -1) {
         escribirEnLog(LOG_ERROR, "Monitor: main", "No se pudo capturar SIGINT\n");
         return EXIT_FAILURE;
     }
     
     // Crear el named pipe
     const char * pipeName;
-    pipeName = obtener_valor_configuracion("PIPE_NAME", "/tmp/pipeAudita");
+    pipeName = obtener_configuracion()->nombre_pipe;
     escribirEnLog(LOG_INFO, "Monitor: main", "Creando pipe %s\n", pipeName);
     mkfifo(pipeName, 0666);
 
-    // Variables de lectura del pipe
-    char buffer[MESSAGE_SIZE];
-    int bytes_read;
+    //Creación del hilo evaluador de los patrones de fraude
+    crear_hilo_evaluador_patrones();
 
-    //Creación de los hilos de observación de ficheros de las sucursales
-    crear_hilos_patrones_fraude();
+    // Bucle de eventos: pipe, señales y temporizador de mantenimiento
+    int epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd == -1) {
+        escribirEnLog(LOG_ERROR, "Monitor: main", "Error al crear el bucle de eventos\n");
+        exit(EXIT_FAILURE);
+    }
+    struct epoll_event evento_senal = {.events = EPOLLIN, .data.fd = senalfd};
+    epoll_ctl(epollfd, EPOLL_CTL_ADD, senalfd, &evento_senal);
+
+    // Temporizador de mantenimiento: cada CHECKPOINT_SECONDS segundos pide al hilo evaluador que guarde los
+    // cambios pendientes en el punto de control (0 = sin temporizador)
+    int temporizadorfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct epoll_event evento_temporizador = {.events = EPOLLIN, .data.fd = temporizadorfd};
+    if (temporizadorfd == -1 || programar_temporizador_mantenimiento(temporizadorfd, obtener_configuracion()->segundos_punto_control) == -1 ||
+        epoll_ctl(epollfd, EPOLL_CTL_ADD, temporizadorfd, &evento_temporizador) == -1) {
+        escribirEnLog(LOG_ERROR, "Monitor: main", "Error al crear el temporizador de mantenimiento\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Cambios del fichero de configuración (si inotify no está disponible, sólo se recarga con SIGHUP)
+    int vigilanciafd = vigilar_fichero_configuracion();
+    if (vigilanciafd != -1) {
+        struct epoll_event evento_vigilancia = {.events = EPOLLIN, .data.fd = vigilanciafd};
+        epoll_ctl(epollfd, EPOLL_CTL_ADD, vigilanciafd, &evento_vigilancia);
+    }
 
     // Abrir el pipe
+    // No se espera a que FileProcessor lo abra para escritura: el bucle de eventos avisa cuando llegan datos
     escribirEnLog(LOG_INFO, "Monitor: main", "Abriendo pipe %s\n", pipeName);
-    pipefd = open(pipeName, O_RDONLY);
+    pipefd = abrir_pipe_monitor(epollfd, pipeName);
     escribirEnLog(LOG_INFO, "Monitor: main", "Entrando en ejecucion indefinida\n");
-    
+
+    // Buffer de lectura: puede contener varias tramas y una trama incompleta al final
+    char *buffer = malloc(TAMANO_BUFFER_PIPE);
+    if (buffer == NULL) {
+        escribirEnLog(LOG_ERROR, "Monitor: main", "Error al reservar memoria para el buffer del pipe\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t bytes_buffer = 0;
 
     while (1) {
-        bytes_read = read(pipefd, buffer, sizeof(buffer));
-        if (bytes_read > 0) {
-            // Recibido mensaje en el pipe
-            escribirEnLog(LOG_INFO, "Monitor: main", "Recibido %s\n", buffer);    
-            escribirEnLog(LOG_GENERAL, "Monitor: main", "%s\n", buffer);    
-
-            // Desbloquear los hilos de detección de patrón de fraude
-            for (int i = 1; i <= NUM_PATRONES_FRAUDE; i++) {
-                activarHiloPatronFraude(i, 0);
+        // epoll_wait bloquea el hilo hasta que ocurre algo: sin eventos no consume CPU
+        struct epoll_event eventos[4];
+        int num_eventos = epoll_wait(epollfd, eventos, 4, -1);
+        if (num_eventos == -1) {
+            if (errno != EINTR) {
+                escribirEnLog(LOG_ERROR, "Monitor: main", "Error en el bucle de eventos\n");
             }
+            continue;
+        }
 
-            //printf("%s\n", buffer);
-            memset(buffer, 0, sizeof(buffer));
+        for (int i = 0; i < num_eventos; i++) {
+            int fd = eventos[i].data.fd;
+            if (fd == senalfd) {
+                struct signalfd_siginfo info;
+                if (read(senalfd, &info, sizeof(info)) == sizeof(info)) {
+                    if (info.ssi_signo == SIGHUP) {
+                        escribirEnLog(LOG_INFO, "Monitor: main", "Recibido SIGHUP: recargando la configuración\n");
+                        atender_recarga_configuracion(temporizadorfd);
+                    } else {
+                        ctrlc_handler((int)info.ssi_signo);
+                    }
+                }
+            } else if (fd == temporizadorfd) {
+                uint64_t expiraciones;
+                if (read(temporizadorfd, &expiraciones, sizeof(expiraciones)) == sizeof(expiraciones)) {
+                    solicitarMantenimientoEvaluador();
+                }
+            } else if (fd == pipefd) {
+                atender_pipe_monitor(epollfd, pipeName, buffer, &bytes_buffer);
+            } else if (fd == vigilanciafd) {
+                if (fichero_configuracion_modificado(vigilanciafd)) {
+                    atender_recarga_configuracion(temporizadorfd);
+                }
+            }
         }
-        // Ponemos 1 centésima de segundo para evitar el consumo excesivo de la CPU
-        sleep_centiseconds(1);
     }
 
     // Código inaccesible, el programa lo acabará le usuario con CTRL+C 
-    // de forma que los semáforos y recursos se liberarán en el manejador
+    // de forma que los recursos se liberarán en el manejador
     return 0;
 
 }
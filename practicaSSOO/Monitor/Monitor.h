@@ -1,6 +1,68 @@
-void simulaRetardo(const char *mensaje);
-void crear_hilos_patron_fraude();
-void sleep_centiseconds(int n);
+int crear_hilo_evaluador_patrones();
+void notificarEvaluadorPatrones();
+void solicitarMantenimientoEvaluador();
+void solicitarTerminacionEvaluador();
+void avisarEvaluadorTerminado();
+uint64_t esperarAvisoEvaluador(uint64_t atendida, int *terminar);
+struct ANILLO_REGISTROS;
+struct REGISTRO_TRANSACCION;
+struct ESTADO_LECTOR;
+struct EVALUADOR_PATRON;
+struct ANILLO_REGISTROS *conectar_anillo_registros();
+struct VISTA_REGISTRO;
+void rellenar_registro(const struct VISTA_REGISTRO *vista, struct REGISTRO_TRANSACCION *registro);
+void aplicar_registro_evaluadores(struct ESTADO_LECTOR *estado, const struct REGISTRO_TRANSACCION *registro);
+int64_t calcular_limite_futuro(int64_t adelanto_permitido);
+struct stat;
+void comprobar_fichero_consolidado(struct ESTADO_LECTOR *estado, const struct stat *info);
+int leer_fichero_consolidado(struct ESTADO_LECTOR *estado, const char *nombre_fichero);
+int consumir_anillo_registros(struct ESTADO_LECTOR *estado, struct ANILLO_REGISTROS *anillo);
+int sincronizar_registros(struct ESTADO_LECTOR *estado, const char *nombre_fichero);
+struct TABLA_USUARIOS;
+struct TEXTO_RESULTADO;
+void anadir_texto_resultado(struct TEXTO_RESULTADO *resultado, const char *texto, size_t longitud);
+void escribir_resultados_patron(struct EVALUADOR_PATRON *evaluador, const struct TABLA_USUARIOS *usuarios);
+struct DICCIONARIO_PATRON;
+struct REGISTRO_PATRON;
+struct ARENA;
+void iniciar_arena(struct ARENA *arena, size_t tamano_bloque);
+void *reservar_arena(struct ARENA *arena, size_t tamano);
+void reiniciar_arena(struct ARENA *arena);
+void liberar_arena(struct ARENA *arena);
+size_t capacidad_tabla(size_t elementos);
+void iniciar_diccionario(struct DICCIONARIO_PATRON *diccionario, struct ARENA *arena, size_t capacidad);
+void iniciar_diccionarios(struct ESTADO_LECTOR *estado);
+void compactar_diccionarios(struct ESTADO_LECTOR *estado);
+void ampliar_diccionario(struct DICCIONARIO_PATRON *diccionario);
+struct REGISTRO_PATRON *obtener_registro_patron(struct DICCIONARIO_PATRON *diccionario, uint64_t clave);
+void borrar_registro_patron(struct DICCIONARIO_PATRON *diccionario, size_t posicion);
+struct REGISTRO_PATRON *obtener_registro_evaluador(struct EVALUADOR_PATRON *evaluador, uint32_t id_usuario, int64_t instante);
+void anadir_alerta_cerrada(struct EVALUADOR_PATRON *evaluador, const char *mensaje);
+void nombre_alertas_cerradas(int patron, char *nombre, size_t tamano);
+void abrir_alertas_cerradas(struct ESTADO_LECTOR *estado);
+int volcar_alertas_cerradas(struct EVALUADOR_PATRON *evaluador);
+size_t cerrar_entradas_vencidas(struct EVALUADOR_PATRON *evaluador, const struct TABLA_USUARIOS *usuarios, int64_t marca);
+int escribir_relleno_punto_control(FILE *fichero, uint64_t tamano);
+int escribir_bloque_punto_control(FILE *fichero, const void *datos, size_t tamano);
+int escribir_punto_control(struct ESTADO_LECTOR *estado, const char *nombre_fichero);
+int restaurar_punto_control(struct ESTADO_LECTOR *estado, const char *nombre_fichero);
+int abrir_pipe_monitor(int epollfd, const char *pipeName);
+int procesar_tramas_pipe(char *buffer, size_t *bytes_buffer);
+void atender_pipe_monitor(int epollfd, const char *pipeName, char *buffer, size_t *bytes_buffer);
+int programar_temporizador_mantenimiento(int temporizadorfd, int segundos);
+void atender_recarga_configuracion(int temporizadorfd);
+void iniciar_tabla_usuarios(struct TABLA_USUARIOS *tabla, struct ARENA *arena, uint32_t capacidad);
+void ampliar_tabla_usuarios(struct TABLA_USUARIOS *tabla);
+uint32_t obtener_id_usuario(struct TABLA_USUARIOS *tabla, const char *usuario);
+struct VENTANAS_USUARIOS;
+struct VENTANA_USUARIO;
+void iniciar_ventanas_usuarios(struct VENTANAS_USUARIOS *ventanas, struct ARENA *arena);
+struct VENTANA_USUARIO *obtener_ventana_usuario(struct VENTANAS_USUARIOS *ventanas, uint32_t id_usuario);
+void texto_clave_patron(const struct TABLA_USUARIOS *usuarios, uint64_t clave, int64_t segundos_intervalo, char *texto, size_t tamano_texto);
 void obtenerFechaHora2(char * fechaHora2);
 void obtenerFechaHora(char * fechaHora);
+void publicar_fichero_resultado(int patron, int fd_cerradas, uint64_t bytes_cerradas, const char *contenido, size_t longitud);
+int abrir_flujo_alertas(const char *nombre_fichero, uint64_t secuencia_punto_control);
+void notificar_alerta(struct REGISTRO_PATRON *registro, const char *mensaje);
+int volcar_flujo_alertas();
 #pragma once
@@ -5,17 +5,26 @@
 # Nombre del archivo del programa C
 archivo_programa="Monitor.c"
 
+# Módulos comunes a FileProcessor y Monitor
+archivos_comunes="../Comun/RegistroCSV.c ../Comun/Log.c ../Comun/Configuracion.c ../Comun/Retardo.c ../Comun/AnilloRegistros.c"
+
 # Nombre del ejecutable después de la compilación
 ejecutable="Monitor"
 
-# Opciones de compilación para GLib
-cflags="$(pkg-config --cflags glib-2.0) -pthread"
+# Opciones de compilación para threads
+cflags="-pthread"
+
+# Nivel mínimo de log que se compila: -DLOG_NIVEL_MINIMO=LOG_INFO quita los mensajes de depuración
+# (p. ej. ./compilar_Monitor.sh con NIVEL_LOG_MINIMO=LOG_INFO en el entorno)
+if [ -n "$NIVEL_LOG_MINIMO" ]; then
+    cflags="$cflags -DLOG_NIVEL_MINIMO=$NIVEL_LOG_MINIMO"
+fi
 
-# Opciones de enlace para GLib
-ldflags=$(pkg-config --libs glib-2.0)
+# Opciones de enlace para la memoria compartida POSIX (shm_open) y la biblioteca matemática (retardo lognormal)
+ldflags="-lrt -lm"
 
-# Compilar el programa C con GLib
-gcc "$archivo_programa" -o "$ejecutable" $cflags $ldflags
+# Compilar el programa C
+gcc "$archivo_programa" $archivos_comunes -o "$ejecutable" $cflags $ldflags
 
 # Verificar si hubo errores durante la compilación
 if [ $? -eq 0 ]; then
@@ -27,6 +27,9 @@ echo
 
 # Nombre del archivo del programa C
 archivo_programa="../FileProcessor/FileProcessor.c"
+
+# Módulos comunes a FileProcessor y Monitor
+archivos_comunes="../Comun/RegistroCSV.c ../Comun/Log.c ../Comun/Configuracion.c ../Comun/Retardo.c ../Comun/AnilloRegistros.c"
 echo "Compilando $archivo_programa"
 
 # Nombre del ejecutable después de la compilación
@@ -38,8 +41,11 @@ ejecutable="FileProcessor"
 # Opciones de enlace para GLib
 # ldflags=$(pkg-config --libs glib-2.0)
 
+# Opciones de enlace para la memoria compartida POSIX (shm_open) y la biblioteca matemática (retardo lognormal)
+ldflags="-lrt -lm"
+
 # Compilar el programa C con GLib
-gcc "$archivo_programa" -o "$ejecutable" $cflags $ldflags
+gcc "$archivo_programa" $archivos_comunes -o "$ejecutable" $cflags $ldflags
 
 # Verificar si hubo errores durante la compilación
 if [ $? -eq 0 ]; then
@@ -59,14 +65,14 @@ echo "Compilando $archivo_programa"
 # Nombre del ejecutable después de la compilación
 ejecutable="Monitor"
 
-# Opciones de compilación para GLib
-cflags=$(pkg-config --cflags glib-2.0)
+# Opciones de compilación para threads
+cflags="-pthread"
 
-# Opciones de enlace para GLib
-ldflags=$(pkg-config --libs glib-2.0)
+# Opciones de enlace para la memoria compartida POSIX (shm_open) y la biblioteca matemática (retardo lognormal)
+ldflags="-lrt -lm"
 
 # Compilar el programa C con GLib
-gcc "$archivo_programa" -o "$ejecutable" $cflags $ldflags
+gcc "$archivo_programa" $archivos_comunes -o "$ejecutable" $cflags $ldflags
 
 # Verificar si hubo errores durante la compilación
 if [ $? -eq 0 ]; then
@@ -204,7 +210,7 @@ imprimir_resultado_prueba "Patrón de Fraude 5" $resultado_esperado $resultado_o
 # MATAR LOS PROCESOS EN SEGUNDO PLANO
 # -------------------------------------------------
 
-# La señal SIGINT es la misma que CTRL-C, así nos aseguramos de que se cierren ordenadamente los semáforos
+# La señal SIGINT es la misma que CTRL-C, así nos aseguramos de que se cierren ordenadamente los recursos
 
 echo
 echo "TERMINANDO LOS PROCESOS DE PRUEBA"